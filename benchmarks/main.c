@@ -0,0 +1,306 @@
+#include <tinywm.h>
+#include <X11/keysym.h>
+#include <X11/extensions/XTest.h>
+#include <sys/wait.h>
+
+#define INIT_RUNS 20
+#define WINDOW_RUNS 50
+#define STORM_EVENTS 20000
+#define LATENCY_SAMPLES 500
+#define BATCH_SIZE 64
+#define IDLE_TIMEOUT 0.25
+
+static FILE* output;
+static Display* inject;
+static twm_window window;
+
+static void report(const char* benchmark, const char* metric, double value, const char* unit) {
+	fprintf(output, "%s,%s,%.3f,%s\n", benchmark, metric, value, unit);
+	fflush(output);
+}
+
+static int compare_double(const void* a, const void* b) {
+	double x = *(const double*)a, y = *(const double*)b;
+
+	return (x > y) - (x < y);
+}
+
+// Sorts the samples and reports mean, p50, p99 and max scaled to the given unit
+static void report_samples(const char* benchmark, double* samples, int count, double scale, const char* unit) {
+	if (count == 0) return;
+
+	double sum = 0.0;
+	for (int i = 0; i < count; i++) sum += samples[i];
+
+	qsort(samples, count, sizeof(double), compare_double);
+
+	report(benchmark, "mean", sum / count * scale, unit);
+	report(benchmark, "p50", samples[count / 2] * scale, unit);
+	report(benchmark, "p99", samples[(count * 99) / 100] * scale, unit);
+	report(benchmark, "max", samples[count - 1] * scale, unit);
+}
+
+// Returns the number of events drained before the queue stays empty for IDLE_TIMEOUT
+static int drain(double* last) {
+	twm_event events[BATCH_SIZE];
+	int total = 0;
+
+	for (;;) {
+		int count = twm_peek_events(events, BATCH_SIZE);
+
+		if (count == 0) {
+			if (!twm_wait_event_timeout(&events[0], IDLE_TIMEOUT)) break;
+
+			count = 1;
+		}
+
+		total += count;
+
+		if (last) *last = twm_time();
+	}
+
+	return total;
+}
+
+// Polls instead of sleeping in the event wait, so a measurement does not include the poll wakeup
+static bool spin_for(twm_event_type type, double timeout) {
+	twm_event evt;
+	double deadline = twm_time() + timeout;
+
+	while (twm_time() < deadline) {
+		if (twm_peek_event(&evt) && evt.type == type) return true;
+	}
+
+	return false;
+}
+
+static bool wait_for(twm_event_type type, double timeout) {
+	twm_event evt;
+	double deadline = twm_time() + timeout;
+
+	for (;;) {
+		double remaining = deadline - twm_time();
+
+		if (remaining <= 0.0 || !twm_wait_event_timeout(&evt, remaining)) return false;
+		if (evt.type == type) return true;
+	}
+}
+
+// twm_init and twm_finalize are not meant to run twice per process, so each sample gets a fresh child.
+// Mode lists are decoded on first use, that cost is reported separately as init_modes
+static void bench_init() {
+	double samples[INIT_RUNS];
+	double modes[INIT_RUNS];
+	double requests = 0.0;
+	int count = 0;
+
+	for (int i = 0; i < INIT_RUNS; i++) {
+		int fds[2];
+		if (pipe(fds) != 0) break;
+
+		pid_t pid = fork();
+
+		if (pid == 0) {
+			double result[3] = { -1.0, 0.0, 0.0 };
+			double start = twm_time();
+
+			if (twm_init()) {
+				result[0] = twm_time() - start;
+				result[1] = (double)(NextRequest(twm_x11_display()) - 1);
+
+				start = twm_time();
+
+				for (int j = 0; j < twm_screen_count(); j++) twm_screen_mode_info(j, 0);
+
+				result[2] = twm_time() - start;
+			}
+
+			ssize_t written = write(fds[1], result, sizeof(result));
+			(void)written;
+
+			_exit(0);
+		}
+
+		close(fds[1]);
+
+		double result[3];
+		if (pid > 0 && read(fds[0], result, sizeof(result)) == sizeof(result) && result[0] >= 0.0) {
+			samples[count] = result[0];
+			modes[count++] = result[2];
+			requests = result[1];
+		}
+
+		close(fds[0]);
+
+		if (pid > 0) waitpid(pid, NULL, 0);
+	}
+
+	report_samples("init", samples, count, 1000.0, "ms");
+	report("init", "requests", requests, "count");
+	report_samples("init_modes", modes, count, 1000.0, "ms");
+}
+
+static void bench_create_window() {
+	double samples[WINDOW_RUNS];
+	unsigned long requests = 0;
+
+	for (int i = 0; i < WINDOW_RUNS; i++) {
+		unsigned long first = NextRequest(twm_x11_display());
+		double start = twm_time();
+
+		twm_window bench = twm_create_window("TINY Window Manager - Benchmark", 0, 0, 320, 240, TWM_WINDOW_DEFAULT);
+
+		samples[i] = twm_time() - start;
+		requests += NextRequest(twm_x11_display()) - first;
+
+		twm_destroy_window(bench);
+	}
+
+	drain(NULL);
+
+	report_samples("create_window", samples, WINDOW_RUNS, 1000.0, "ms");
+	report("create_window", "requests", (double)requests / WINDOW_RUNS, "count");
+}
+
+static void inject_keyboard(int i) {
+	KeyCode keycode = XKeysymToKeycode(inject, XK_a + i % 26);
+
+	XTestFakeKeyEvent(inject, keycode, True, CurrentTime);
+	XTestFakeKeyEvent(inject, keycode, False, CurrentTime);
+}
+
+static void inject_mouse(int i) {
+	XTestFakeMotionEvent(inject, -1, 10 + i % 600, 10 + (i / 600) % 400, CurrentTime);
+
+	if (i % 8 == 0) {
+		XTestFakeButtonEvent(inject, Button1, True, CurrentTime);
+		XTestFakeButtonEvent(inject, Button1, False, CurrentTime);
+	}
+}
+
+static void inject_rawmotion(int i) {
+	XTestFakeRelativeMotionEvent(inject, i & 1 ? 1 : -1, i & 2 ? 1 : -1, CurrentTime);
+}
+
+static void inject_configure(int i) {
+	XMoveResizeWindow(inject, window, i % 64, i % 32, 640 + i % 128, 480 + i % 96);
+}
+
+// Everything is read into the Xlib queue before the timer starts, so only client side work is measured.
+// Throughput counts X events translated, pointer motion is coalesced so fewer events are delivered
+static void bench_storm(const char* name, void (*inject_event)(int)) {
+	drain(NULL);
+
+	for (int i = 0; i < STORM_EVENTS; i++) inject_event(i);
+
+	XSync(inject, False);
+	XSync(twm_x11_display(), False);
+
+	int x_events = XEventsQueued(twm_x11_display(), QueuedAlready);
+
+	double start = twm_time(), last = start;
+	int events = drain(&last);
+
+	report(name, "x_events", x_events, "count");
+	report(name, "events", events, "count");
+
+	if (last > start) report(name, "throughput", x_events / (last - start), "x_events/s");
+}
+
+static void bench_latency(const char* name, twm_event_type type, bool key) {
+	double samples[LATENCY_SAMPLES];
+	int count = 0;
+
+	KeyCode keycode = XKeysymToKeycode(inject, XK_space);
+
+	drain(NULL);
+
+	for (int i = 0; i < LATENCY_SAMPLES; i++) {
+		double start = twm_time();
+
+		if (key) {
+			XTestFakeKeyEvent(inject, keycode, True, CurrentTime);
+		}
+		else {
+			XTestFakeMotionEvent(inject, -1, 100 + (i & 1) * 100, 100, CurrentTime);
+		}
+
+		XFlush(inject);
+
+		if (spin_for(type, 1.0)) samples[count++] = twm_time() - start;
+
+		if (key) {
+			XTestFakeKeyEvent(inject, keycode, False, CurrentTime);
+			XFlush(inject);
+
+			wait_for(TWM_EVENT_KEY_UP, 1.0);
+		}
+	}
+
+	report_samples(name, samples, count, 1000000.0, "us");
+}
+
+int main(int argc, char** argv) {
+	output = argc > 1 ? fopen(argv[1], "w") : stdout;
+
+	if (!output) {
+		fprintf(stderr, "cannot open %s\n", argv[1]);
+
+		return 1;
+	}
+
+	fprintf(output, "benchmark,metric,value,unit\n");
+
+	bench_init();
+
+	inject = XOpenDisplay(NULL);
+
+	int event_base, error_base, major, minor;
+	if (!inject || !XTestQueryExtension(inject, &event_base, &error_base, &major, &minor)) {
+		fprintf(stderr, "XTest is not available\n");
+
+		return 1;
+	}
+
+	if (!twm_init()) {
+		fprintf(stderr, "twm_init failed\n");
+
+		return 1;
+	}
+
+	bench_create_window();
+
+	window = twm_create_window("TINY Window Manager - Benchmark", 0, 0, 640, 480, TWM_WINDOW_DEFAULT);
+	twm_show_window(window, true);
+
+	twm_coalesce_rawmouse(false);
+	twm_coalesce_window_events(false);
+
+	XWindowAttributes attributes;
+	do {
+		drain(NULL);
+		XGetWindowAttributes(inject, window, &attributes);
+	} while (attributes.map_state != IsViewable);
+
+	// Raw motion is only selected while the window has focus
+	XSetInputFocus(inject, window, RevertToParent, CurrentTime);
+	XSync(inject, False);
+	wait_for(TWM_EVENT_WINDOW_ACTIVE, 1.0);
+
+	bench_storm("storm_keyboard", inject_keyboard);
+	bench_storm("storm_mouse", inject_mouse);
+	bench_storm("storm_rawmotion", inject_rawmotion);
+	bench_storm("storm_configure", inject_configure);
+
+	bench_latency("latency_mouse", TWM_EVENT_MOUSE_MOVE, false);
+	bench_latency("latency_key", TWM_EVENT_KEY_DOWN, true);
+
+	twm_destroy_window(window);
+	twm_finalize();
+
+	XCloseDisplay(inject);
+
+	if (output != stdout) fclose(output);
+
+	return 0;
+}
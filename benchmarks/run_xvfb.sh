@@ -0,0 +1,30 @@
+#!/bin/sh
+# Runs a program against a private Xvfb display: run_xvfb.sh <program> [arguments...]
+
+PROGRAM=$1
+shift
+
+DISPLAY_NUMBER=${TWM_BENCHMARK_DISPLAY:-99}
+
+while [ -e /tmp/.X11-unix/X$DISPLAY_NUMBER ] || [ -e /tmp/.X$DISPLAY_NUMBER-lock ]; do
+	DISPLAY_NUMBER=$((DISPLAY_NUMBER + 1))
+done
+
+Xvfb :$DISPLAY_NUMBER -screen 0 1920x1080x24 -nolisten tcp +extension XTEST +extension RANDR >/dev/null 2>&1 &
+XVFB_PID=$!
+
+trap 'kill $XVFB_PID 2>/dev/null' EXIT INT TERM
+
+TRIES=0
+while [ ! -e /tmp/.X11-unix/X$DISPLAY_NUMBER ]; do
+	TRIES=$((TRIES + 1))
+
+	if [ $TRIES -gt 100 ] || ! kill -0 $XVFB_PID 2>/dev/null; then
+		echo "Xvfb did not start on :$DISPLAY_NUMBER" >&2
+		exit 1
+	fi
+
+	sleep 0.1
+done
+
+DISPLAY=:$DISPLAY_NUMBER "$PROGRAM" "$@"
@@ -0,0 +1,82 @@
+#include <tinywm.h>
+
+int main(int argc, char** argv) {
+
+	twm_init();
+
+	twm_window window = twm_create_window("TINY Window Manager - Framebuffer", TWM_CENTER, TWM_CENTER, 1280, 720, TWM_WINDOW_DEFAULT);
+
+	twm_show_window(window, true);
+
+	twm_framebuffer framebuffer = twm_create_framebuffer(window);
+
+	if (framebuffer == NULL) {
+		printf("Framebuffer not supported\n");
+
+		return 0;
+	}
+
+	twm_frame_pacer pacer;
+	twm_frame_pacer_init(&pacer, 60);
+	twm_frame_pacer_lock_refresh(&pacer, window);
+
+	bool done = false;
+	twm_event evt;
+
+	unsigned int frame = 0;
+
+	while (!done) {
+		while (twm_peek_event(&evt)) {
+			switch (evt.type) {
+				case TWM_EVENT_WINDOW_CLOSE: {
+					done = true;
+					break;
+				}
+
+				case TWM_EVENT_WINDOW_SIZE: {
+					printf("WINDOW_SIZE: %dx%d\n", evt.window.width, evt.window.height);
+					break;
+				}
+
+				case TWM_EVENT_KEY_DOWN: {
+					if (evt.keyboard.key == TWM_KEY_ESCAPE) {
+						done = true;
+					}
+					break;
+				}
+
+				default:
+					break;
+			}
+		}
+
+		// Draw Graphics
+
+		int width, height, stride;
+		unsigned int* pixels = twm_framebuffer_pixels(framebuffer, &width, &height, &stride);
+
+		if (pixels) {
+			for (int y = 0; y < height; y++) {
+				for (int x = 0; x < width; x++) {
+					unsigned int r = (x + frame) & 0xFF;
+					unsigned int g = (y + frame) & 0xFF;
+					unsigned int b = (x ^ y) & 0xFF;
+
+					pixels[y * stride + x] = (r << 16) | (g << 8) | b;
+				}
+			}
+
+			twm_present_framebuffer(framebuffer);
+		}
+
+		frame++;
+
+		twm_frame_pacer_wait(&pacer);
+	}
+
+	twm_destroy_framebuffer(framebuffer);
+	twm_destroy_window(window);
+	twm_finalize();
+
+	return 1;
+}
@@ -8,15 +8,18 @@ int main(int argc, char** argv) {
 
 	twm_show_window(window, true);
 
-	int fps = 0;
-	double time = 0.0, frame_time = 0.0;
+	twm_frame_pacer pacer;
+	twm_frame_pacer_init(&pacer, 60);
+	twm_frame_pacer_lock_refresh(&pacer, window);
+
+	twm_stats_enable(true);
+
+	double time = 0.0;
 
 	bool done = false;
 	twm_event evt;
 
 	while (!done) {
-		double start_time = twm_time();
-
 		while (twm_peek_event(&evt)) {
 			switch (evt.type) {
 				case TWM_EVENT_RAWMOUSE_MOVE: {
@@ -148,20 +151,23 @@ int main(int argc, char** argv) {
 
 		// Draw Graphics
 
-		frame_time = twm_fps_limit(60, start_time);
+		time += twm_frame_pacer_wait(&pacer);
 
-		fps++;
-		time += frame_time;
+		twm_stats_frame();
 
 		if (time >= 1.0) {
-			static char title[100];
+			static char title[200];
 
-			snprintf(title, sizeof(title), "TINY Window Manager - Game Loop Peek Events - FPS: %d / Frame Time: %.2f ms", fps, frame_time * 1000);
+			twm_stats stats;
+			twm_get_stats(&stats);
+
+			snprintf(title, sizeof(title), "TINY Window Manager - Game Loop Peek Events - FPS: %.0f / p50: %.2f ms / p99: %.2f ms / Events: %.1f per frame", stats.fps, stats.frame_time_p50 * 1000, stats.frame_time_p99 * 1000, stats.events_per_frame);
 
 			twm_title_window(window, title);
 
+			twm_stats_reset();
+
 			time -= 1.0f;
-			fps = 0;
 		}
 	}
 
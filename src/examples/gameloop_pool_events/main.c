@@ -8,14 +8,16 @@ int main(int argc, char** argv) {
 
 	twm_show_window(window, true);
 
+	twm_frame_pacer pacer;
+	twm_frame_pacer_init(&pacer, 60);
+	twm_frame_pacer_lock_refresh(&pacer, window);
+
 	int fps = 0;
 	double time = 0.0, frame_time = 0.0;
 
 	twm_event evt;
 
 	while (!twm_window_was_closed(window)) {
-		double start_time = twm_time();
-
 		twm_pool_events();
 
 		if (twm_key_state(TWM_KEY_ESCAPE)) {
@@ -51,15 +53,18 @@ int main(int argc, char** argv) {
 
 		// Draw Graphics
 
-		frame_time = twm_fps_limit(60, start_time);
+		frame_time = twm_frame_pacer_wait(&pacer);
 
 		fps++;
 		time += frame_time;
 
 		if (time >= 1.0) {
-			static char title[100];
+			static char title[160];
+
+			twm_frame_stats stats;
+			twm_frame_pacer_stats(&pacer, &stats);
 
-			snprintf(title, sizeof(title), "TINY Window Manager - Game Loop Pool Events - FPS: %d / Frame Time: %.2f ms", fps, frame_time * 1000);
+			snprintf(title, sizeof(title), "TINY Window Manager - Game Loop Pool Events - FPS: %d / Frame Time: %.2f ms / Jitter: %.3f ms", fps, frame_time * 1000, stats.jitter_stddev * 1000);
 
 			twm_title_window(window, title);
 
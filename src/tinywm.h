@@ -18,11 +18,18 @@
 
 #define TWM_NULL 0
 
+// Strict ISO modes (-std=c17) hide POSIX declarations such as nanosleep and clock_gettime,
+// GNU modes already expose them and must not be narrowed by defining the macro here
+#if !defined(TWM_WIN32) && defined(__STRICT_ANSI__) && !defined(_POSIX_C_SOURCE)
+	#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
 #include <limits.h>
+#include <math.h>
 
 #if defined(TWM_WIN32)
 
@@ -50,11 +57,28 @@
 	#include <X11/extensions/XInput2.h>
 	#include <X11/extensions/Xinerama.h>
 	#include <X11/extensions/Xrandr.h>
+	#include <X11/extensions/XShm.h>
+	#include <sys/ipc.h>
+	#include <sys/shm.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
 	#include <time.h>
+	#include <errno.h>
 	#include <unistd.h>
+	#include <sched.h>
 	#include <sys/time.h>
+	#include <poll.h>
+	#include <fcntl.h>
 	#include <locale.h>
 
+	#ifdef __linux__
+		#include <sys/eventfd.h>
+	#endif
+
+	#ifdef TWM_PRESENT
+		#include <X11/extensions/Xpresent.h>
+	#endif
+
 	#ifdef TWM_GL
 		#include <GL/glx.h>
 		#include <GL/glext.h>
@@ -79,7 +103,11 @@
 
 	#include <time.h>
 	#include <unistd.h>
+	#include <sched.h>
+	#include <fcntl.h>
 	#include <sys/time.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
 	#include <locale.h>
 
 	#if defined(TWM_GL) && defined(__OBJC__)
@@ -91,6 +119,26 @@
 		#include <vulkan/vulkan_macos.h>
 	#endif
 
+#elif defined(TWM_HEADLESS)
+
+	#if defined(TWM_GL) || defined(TWM_VULKAN)
+		#error "TWM_HEADLESS has no graphics API support"
+	#endif
+
+	#include <time.h>
+	#include <errno.h>
+	#include <unistd.h>
+	#include <sched.h>
+	#include <sys/time.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <poll.h>
+	#include <fcntl.h>
+
+	#ifdef __linux__
+		#include <sys/eventfd.h>
+	#endif
+
 #endif
 
 // =====================[ Base Types ]=====================
@@ -105,11 +153,16 @@
 		typedef BOOL(WINAPI* PFNWGLCHOOSEPIXELFORMATARBPROC)(HDC hdc, const int* piAttribIList,const FLOAT* pfAttribFList,UINT nMaxFormats,int* piFormats,UINT* nNumFormats);
 		typedef BOOL(WINAPI* PFNWGLSWAPINTERVALEXTPROC)(int interval);
 		typedef int(WINAPI* PFNWGLGETSWAPINTERVALEXTPROC)(void);
+		typedef const char*(WINAPI* PFNWGLGETEXTENSIONSSTRINGARBPROC)(HDC hdc);
+		typedef BOOL(WINAPI* PFNWGLGETSYNCVALUESOMLPROC)(HDC hdc, INT64* ust, INT64* msc, INT64* sbc);
+		typedef INT64(WINAPI* PFNWGLSWAPBUFFERSMSCOMLPROC)(HDC hdc, INT64 target_msc, INT64 divisor, INT64 remainder);
+		typedef BOOL(WINAPI* PFNWGLWAITFORSBCOMLPROC)(HDC hdc, INT64 target_sbc, INT64* ust, INT64* msc, INT64* sbc);
 
 		typedef struct _twm_gl_context {
 			HWND hwnd;
 			HDC hdc;
 			HGLRC hglrc;
+			bool offscreen;
 		} _twm_gl_context;
 
 		typedef _twm_gl_context* twm_gl_context;
@@ -122,11 +175,13 @@
 
 	typedef enum twm_x11_atom {
 		TWM_X11_ATOM_DELETE,
-		TWM_X11_ATOM_CHAR,
 		TWM_X11_ATOM_NET_WM_STATE,
 		TWM_X11_ATOM_NET_WM_STATE_HIDDEN,
 		TWM_X11_ATOM_NET_WM_STATE_MAX_HORZ,
 		TWM_X11_ATOM_NET_WM_STATE_MAX_VERT,
+		TWM_X11_ATOM_NET_WM_STATE_FULLSCREEN,
+		TWM_X11_ATOM_MOTIF_WM_HINTS,
+		TWM_X11_ATOM_COUNT,
 	} twm_x11_atom;
 
 	typedef enum twm_x11_cursor {
@@ -134,12 +189,30 @@
 		TWM_X11_CURSOR_DEFAULT,
 	} twm_x11_cursor;
 
+	typedef enum twm_x11_keymod {
+		TWM_X11_KEYMOD_LSHIFT,
+		TWM_X11_KEYMOD_RSHIFT,
+		TWM_X11_KEYMOD_LCTRL,
+		TWM_X11_KEYMOD_RCTRL,
+		TWM_X11_KEYMOD_LALT,
+		TWM_X11_KEYMOD_RALT,
+		TWM_X11_KEYMOD_LWIN,
+		TWM_X11_KEYMOD_RWIN,
+		TWM_X11_KEYMOD_MENU,
+		TWM_X11_KEYMOD_NUMLOCK,
+		TWM_X11_KEYMOD_SCROLLLOCK,
+		TWM_X11_KEYMOD_CAPSLOCK,
+		TWM_X11_KEYMOD_COUNT,
+	} twm_x11_keymod;
+
 	#ifdef TWM_GL
 
+		// window is the drawable made current, the pbuffer itself for offscreen contexts.
+		// The colormap belongs to the window, so deleting a context never frees it
 		typedef struct _twm_gl_context {
-			Colormap colormap;
 			GLXContext context;
 			Window window;
+			GLXPbuffer pbuffer;
 		} _twm_gl_context;
 
 		typedef _twm_gl_context * twm_gl_context;
@@ -203,8 +276,17 @@
 
 	#endif
 
+#elif defined(TWM_HEADLESS)
+
+	// Windows only exist in memory
+	typedef struct _twm_window* twm_window;
+
 #endif
 
+// CPU-writable XRGB8888 pixels presented to a window
+typedef struct _twm_framebuffer _twm_framebuffer;
+typedef _twm_framebuffer* twm_framebuffer;
+
 #ifdef TWM_GL
 
 	#ifndef TWM_GL_PIXEL_ATTRIBS_SIZE
@@ -241,10 +323,19 @@ typedef struct twm_rect {
 	int width, height;
 } twm_rect;
 
+typedef enum twm_screen_mode_flags {
+	TWM_SCREEN_MODE_PREFERRED = 1 << 0,
+	TWM_SCREEN_MODE_INTERLACED = 1 << 1,
+	TWM_SCREEN_MODE_DOUBLESCAN = 1 << 2,
+} twm_screen_mode_flags;
+
+// hz is rounded for display and exact matching, refresh_rate is exact (59.94 rather than 60)
 typedef struct twm_screen_mode {
 	int width, height;
 	int bpp;
 	int hz;
+	double refresh_rate;
+	twm_screen_mode_flags flags;
 
 	#if defined(TWM_WIN32)
 		DEVMODE devmode;
@@ -277,6 +368,68 @@ typedef struct twm_screen {
 	#endif
 } twm_screen;
 
+typedef struct twm_frame_stats {
+	long long frames;
+	long long missed;
+	double frame_time;
+	double jitter_mean;
+	double jitter_stddev;
+	double jitter_max;
+} twm_frame_stats;
+
+// ust is the driver clock in microseconds, msc counts vertical retraces and sbc completed swaps
+typedef struct twm_gl_sync_values {
+	long long ust;
+	long long msc;
+	long long sbc;
+} twm_gl_sync_values;
+
+// Frame times are bucketed by TWM_STATS_BUCKET_NS, the last bucket holds everything slower
+#ifndef TWM_STATS_HISTOGRAM_SIZE
+	#define TWM_STATS_HISTOGRAM_SIZE 256
+#endif
+
+#ifndef TWM_STATS_BUCKET_NS
+	#define TWM_STATS_BUCKET_NS 250000
+#endif
+
+// Times are in seconds, event_time and swap_time are averages per frame
+typedef struct twm_stats {
+	long long frames;
+	long long events;
+	double fps;
+	double frame_time;
+	double frame_time_mean;
+	double frame_time_p50;
+	double frame_time_p99;
+	double frame_time_max;
+	double events_per_frame;
+	int frame_events;
+	double event_time;
+	double swap_time;
+	long long dropped_events;
+	unsigned int histogram[TWM_STATS_HISTOGRAM_SIZE];
+} twm_stats;
+
+// Upper bound for the frame pacer spin, in nanoseconds
+#ifndef TWM_FRAME_PACER_MAX_SLACK
+#define TWM_FRAME_PACER_MAX_SLACK 2000000
+#endif
+
+// Times are in nanoseconds on the twm_time_ns clock
+typedef struct twm_frame_pacer {
+	long long period;
+	long long deadline;
+	long long last;
+	long long slack;
+	struct {
+		long long frames;
+		long long missed;
+		double mean, m2, max;
+		double frame_time;
+	} stats;
+} twm_frame_pacer;
+
 typedef enum twm_window_flags {
 	TWM_WINDOW_DIALOG = 0,
 	TWM_WINDOW_RESIZABLE = 1 << 0,
@@ -285,87 +438,6 @@ typedef enum twm_window_flags {
 	TWM_WINDOW_DEFAULT = (TWM_WINDOW_DIALOG | TWM_WINDOW_RESIZABLE),
 } twm_window_flags;
 
-typedef struct twm_data {
-	struct {
-		int x, y;
-		int dx, dy;
-		bool buttons[5];
-	} mouse;
-
-	struct {
-		bool keys[512];
-		unsigned char modifiers;
-	} keyboard;
-
-	struct {
-		int count;
-		twm_screen* screen;
-		#if defined(TWM_X11)
-			XRRScreenResources* screen_res;
-		#elif defined(TWM_COCOA)
-			CGDirectDisplayID* display_ids;
-		#endif
-	} screen;
-
-	#if defined(TWM_WIN32)
-
-		HINSTANCE hInstance;
-		WNDCLASSEX wndClass;
-		double frequency;
-		HWND clip;
-
-		#ifdef TWM_GL
-			int pixel_attribs[TWM_GL_PIXEL_ATTRIBS_SIZE];
-			PFNWGLCHOOSEPIXELFORMATARBPROC wglChoosePixelFormatARB;
-			PFNWGLCREATECONTEXTATTRIBSARBPROC wglCreateContextAttribsARB;
-			PFNWGLSWAPINTERVALEXTPROC wglSwapIntervalEXT;
-			PFNWGLGETSWAPINTERVALEXTPROC wglGetSwapIntervalEXT;
-		#endif
-
-	#elif defined(TWM_X11)
-
-		Display* display;
-		XIM xim;
-		XIC xic;
-		Atom atom[6];
-		Cursor cursor[2];
-		int opcode;
-		XContext window_context;
-		bool cursor_visible;
-
-		#ifdef TWM_GL
-			int pixel_attribs[TWM_GL_PIXEL_ATTRIBS_SIZE];
-			PFNGLXCREATECONTEXTATTRIBSARBPROC glXCreateContextAttribsARB;
-			PFNGLXSWAPINTERVALEXTPROC glXSwapIntervalEXT;
-			int swap_interval;
-		#endif
-
-	#elif defined(TWM_COCOA)
-		
-		#ifdef __OBJC__
-
-			NSApplication* app;
-            twm_window clip_window;
-            int clip_x, clip_y;
-            bool cursor_visible;
-
-			#ifdef TWM_GL
-			#pragma clang diagnostic push
-			#pragma clang diagnostic ignored "-Wdeprecated-declarations"
-				NSOpenGLPixelFormatAttribute pixel_attribs[TWM_GL_PIXEL_ATTRIBS_SIZE];
-                int swap_interval;
-                double refresh_rate;
-			#pragma clang diagnostic pop
-			#endif
-
-		#endif
-
-	#endif
-
-} twm_data;
-
-TWM_EXTERN_C(extern twm_data _twm_data;)
-
 // =====================[ Event Key Codes ]=====================
 
 #if defined(TWM_WIN32)
@@ -634,6 +706,91 @@ typedef enum twm_key
 	TWM_KEY_RIGHT_BRACKET = 30,
 	TWM_KEY_APOSTROPHE = 39
 } twm_key;
+
+#elif defined(TWM_HEADLESS)
+
+typedef enum twm_key
+{
+	TWM_KEY_UNKNOWN = 0,
+
+	TWM_KEY_A = 'A', TWM_KEY_B = 'B', TWM_KEY_C = 'C', TWM_KEY_D = 'D',
+	TWM_KEY_E = 'E', TWM_KEY_F = 'F', TWM_KEY_G = 'G', TWM_KEY_H = 'H',
+	TWM_KEY_I = 'I', TWM_KEY_J = 'J', TWM_KEY_K = 'K', TWM_KEY_L = 'L',
+	TWM_KEY_M = 'M', TWM_KEY_N = 'N', TWM_KEY_O = 'O', TWM_KEY_P = 'P',
+	TWM_KEY_Q = 'Q', TWM_KEY_R = 'R', TWM_KEY_S = 'S', TWM_KEY_T = 'T',
+	TWM_KEY_U = 'U', TWM_KEY_V = 'V', TWM_KEY_W = 'W', TWM_KEY_X = 'X',
+	TWM_KEY_Y = 'Y', TWM_KEY_Z = 'Z',
+
+	TWM_KEY_0 = '0', TWM_KEY_1 = '1', TWM_KEY_2 = '2', TWM_KEY_3 = '3',
+	TWM_KEY_4 = '4', TWM_KEY_5 = '5', TWM_KEY_6 = '6', TWM_KEY_7 = '7',
+	TWM_KEY_8 = '8', TWM_KEY_9 = '9',
+
+	TWM_KEY_SPACE          = ' ',
+	TWM_KEY_SEMICOLON      = ';',
+	TWM_KEY_EQUAL          = '=',
+	TWM_KEY_COMMA          = ',',
+	TWM_KEY_MINUS          = '-',
+	TWM_KEY_PERIOD         = '.',
+	TWM_KEY_SLASH          = '/',
+	TWM_KEY_GRAVE          = '`',
+	TWM_KEY_LEFT_BRACKET   = '[',
+	TWM_KEY_BACKSLASH      = '\\',
+	TWM_KEY_RIGHT_BRACKET  = ']',
+	TWM_KEY_APOSTROPHE     = '\'',
+
+	TWM_KEY_ESCAPE = 0x100,
+	TWM_KEY_TAB,
+	TWM_KEY_CAPSLOCK,
+	TWM_KEY_LSHIFT,
+	TWM_KEY_RSHIFT,
+	TWM_KEY_LCONTROL,
+	TWM_KEY_RCONTROL,
+	TWM_KEY_MENU,
+	TWM_KEY_LALT,
+	TWM_KEY_RALT,
+	TWM_KEY_LSUPER,
+	TWM_KEY_RSUPER,
+	TWM_KEY_ENTER,
+	TWM_KEY_BACKSPACE,
+	TWM_KEY_INSERT,
+	TWM_KEY_DELETE,
+	TWM_KEY_HOME,
+	TWM_KEY_END,
+	TWM_KEY_PAGEUP,
+	TWM_KEY_PAGEDOWN,
+	TWM_KEY_PRINTSCREEN,
+	TWM_KEY_SCROLLLOCK,
+	TWM_KEY_PAUSE,
+
+	TWM_KEY_LEFT,
+	TWM_KEY_RIGHT,
+	TWM_KEY_UP,
+	TWM_KEY_DOWN,
+
+	TWM_KEY_F1, TWM_KEY_F2, TWM_KEY_F3, TWM_KEY_F4,
+	TWM_KEY_F5, TWM_KEY_F6, TWM_KEY_F7, TWM_KEY_F8,
+	TWM_KEY_F9, TWM_KEY_F10, TWM_KEY_F11, TWM_KEY_F12,
+
+	TWM_KEY_NUMLOCK,
+	TWM_KEY_NUMPAD0,
+	TWM_KEY_NUMPAD1,
+	TWM_KEY_NUMPAD2,
+	TWM_KEY_NUMPAD3,
+	TWM_KEY_NUMPAD4,
+	TWM_KEY_NUMPAD5,
+	TWM_KEY_NUMPAD6,
+	TWM_KEY_NUMPAD7,
+	TWM_KEY_NUMPAD8,
+	TWM_KEY_NUMPAD9,
+	TWM_KEY_NUMPAD_ADD,
+	TWM_KEY_NUMPAD_SUBTRACT,
+	TWM_KEY_NUMPAD_MULTIPLY,
+	TWM_KEY_NUMPAD_DIVIDE,
+	TWM_KEY_NUMPAD_DECIMAL,
+	TWM_KEY_NUMPAD_ENTER
+
+} twm_key;
+
 #endif
 
 // =====================[ Event ]=====================
@@ -683,10 +840,20 @@ typedef enum twm_event_type {
 	TWM_EVENT_MOUSE_DOWN,
 	TWM_EVENT_MOUSE_UP,
 
+	TWM_EVENT_FD_READY,
+
+	TWM_EVENT_USER,
+
+	TWM_EVENT_FRAME_PRESENTED,
+
+	TWM_EVENT_SCREEN_CHANGED,
+
 } twm_event_type;
 
 typedef struct twm_window_event {
 	twm_event_type type;
+	double time;
+	unsigned long server_time;
 	twm_window window;
 	int x;
 	int y;
@@ -697,6 +864,8 @@ typedef struct twm_window_event {
 
 typedef struct twm_keyboard_event {
 	twm_event_type type;
+	double time;
+	unsigned long server_time;
 	twm_window window;
 	unsigned short key;
 	char chr[5];
@@ -713,29 +882,335 @@ typedef enum twm_mouse_button {
 
 typedef struct twm_rawmouse_event {
 	twm_event_type type;
+	double time;
+	unsigned long server_time;
 	twm_window window;
 	int dx;
 	int dy;
+	double fdx;
+	double fdy;
 } twm_rawmouse_event;
 
 typedef struct twm_mouse_event {
 	twm_event_type type;
+	double time;
+	unsigned long server_time;
 	twm_window window;
 	twm_mouse_button button;
 	int x;
 	int y;
 	int z;
 	int w;
+	double fx;
+	double fy;
 } twm_mouse_event;
 
+typedef struct twm_fd_event {
+	twm_event_type type;
+	double time;
+	unsigned long server_time;
+	int fd;
+} twm_fd_event;
+
+typedef struct twm_user_event {
+	twm_event_type type;
+	double time;
+	unsigned long server_time;
+	twm_window window;
+	int code;
+	void* data;
+} twm_user_event;
+
+// ust is the presentation time in microseconds and msc the vblank counter, present_time is
+// ust in seconds (the twm_time clock on Linux), missed counts vblanks skipped since the previous frame
+typedef struct twm_frame_event {
+	twm_event_type type;
+	double time;
+	unsigned long server_time;
+	twm_window window;
+	unsigned int serial;
+	unsigned long long ust;
+	unsigned long long msc;
+	double present_time;
+	int missed;
+} twm_frame_event;
+
+typedef enum twm_screen_change {
+	TWM_SCREEN_ADDED = 1 << 0,
+	TWM_SCREEN_REMOVED = 1 << 1,
+	TWM_SCREEN_GEOMETRY = 1 << 2,
+	TWM_SCREEN_MODE = 1 << 3,
+} twm_screen_change;
+
+// screen is the index into the screen table after the change, or the index it had before being
+// removed, later screens then shift down by one. Pointers from twm_screen_info are invalidated
+typedef struct twm_screen_event {
+	twm_event_type type;
+	double time;
+	unsigned long server_time;
+	int screen;
+	twm_screen_change change;
+	twm_rect rect;
+} twm_screen_event;
+
+// Every event starts with these fields: the time it was dequeued (same clock as twm_time)
+// and the backend's own timestamp in milliseconds, or 0 when the backend provides none
+typedef struct twm_common_event {
+	twm_event_type type;
+	double time;
+	unsigned long server_time;
+} twm_common_event;
+
 typedef union twm_event {
 	twm_event_type type;
+	twm_common_event common;
 	twm_window_event window;
 	twm_mouse_event mouse;
 	twm_rawmouse_event rawmouse;
 	twm_keyboard_event keyboard;
+	twm_fd_event fd;
+	twm_user_event user;
+	twm_frame_event frame;
+	twm_screen_event screen;
 } twm_event;
 
+// =====================[ Data ]=====================
+
+#ifndef TWM_EVENT_QUEUE_SIZE
+	#define TWM_EVENT_QUEUE_SIZE 64
+#endif
+
+// Must be a power of two
+#ifndef TWM_POST_QUEUE_SIZE
+	#define TWM_POST_QUEUE_SIZE 256
+#endif
+
+// Initial capacity of the window registry, it doubles whenever it fills up
+#ifndef TWM_INITIAL_WINDOWS
+	#define TWM_INITIAL_WINDOWS 32
+#endif
+
+#ifndef TWM_MAX_WATCH_FDS
+	#define TWM_MAX_WATCH_FDS 16
+#endif
+
+#ifndef TWM_RECORD_BUFFER_SIZE
+	#define TWM_RECORD_BUFFER_SIZE 65536
+#endif
+
+typedef struct twm_data {
+	struct {
+		int x, y;
+		double fx, fy;
+		int dx, dy;
+		double fdx, fdy;
+		bool buttons[5];
+
+		struct {
+			bool coalesce;
+			bool master_only;
+			bool pending;
+			twm_window window;
+			unsigned long server_time;
+			double dx, dy;
+			double remainder_x, remainder_y;
+		} raw;
+	} mouse;
+
+	struct {
+		bool keys[512];
+		unsigned int modifiers;
+	} keyboard;
+
+	struct {
+		bool coalesce;
+	} window;
+
+	struct {
+		int head, count;
+		twm_event event[TWM_EVENT_QUEUE_SIZE];
+	} queue;
+
+	// Bounded MPSC queue filled by twm_post_event from any thread
+	struct {
+		volatile long enqueue;
+		long dequeue;
+		struct {
+			volatile long sequence;
+			twm_event event;
+		} cell[TWM_POST_QUEUE_SIZE];
+	} post;
+
+	struct {
+		bool valid;
+		double offset;
+		unsigned long last;
+		double epoch;
+	} server_clock;
+
+	// Counters since the last twm_stats_reset, times in nanoseconds
+	struct {
+		bool enabled;
+		int depth;
+		long long last_frame;
+		long long frames;
+		long long events;
+		int frame_events;
+		long long frame_time;
+		long long total_time;
+		long long max_time;
+		long long event_time;
+		long long swap_time;
+		long long dropped_events;
+		unsigned int histogram[TWM_STATS_HISTOGRAM_SIZE];
+	} stats;
+
+	struct {
+		FILE* file;
+		double start;
+		int used;
+		unsigned char buffer[TWM_RECORD_BUFFER_SIZE];
+	} record;
+
+	// The log stays mapped while replaying, offset is the next record
+	struct {
+		const unsigned char* data;
+		size_t size;
+		size_t offset;
+		double start;
+		double speed;
+		twm_window window;
+		#if defined(TWM_WIN32)
+			HANDLE file;
+			HANDLE mapping;
+		#endif
+	} replay;
+
+	struct {
+		int count;
+		twm_screen* screen;
+		#if defined(TWM_X11)
+			XRRScreenResources* screen_res;
+		#elif defined(TWM_COCOA)
+			CGDirectDisplayID* display_ids;
+		#endif
+	} screen;
+
+	#if defined(TWM_WIN32)
+
+		HINSTANCE hInstance;
+		WNDCLASSEX wndClass;
+		double frequency;
+		long long counter_frequency;
+		DWORD thread_id;
+		HWND clip;
+
+		#ifdef TWM_GL
+			int pixel_attribs[TWM_GL_PIXEL_ATTRIBS_SIZE];
+			PFNWGLCHOOSEPIXELFORMATARBPROC wglChoosePixelFormatARB;
+			PFNWGLCREATECONTEXTATTRIBSARBPROC wglCreateContextAttribsARB;
+			PFNWGLSWAPINTERVALEXTPROC wglSwapIntervalEXT;
+			PFNWGLGETSWAPINTERVALEXTPROC wglGetSwapIntervalEXT;
+			PFNWGLGETSYNCVALUESOMLPROC wglGetSyncValuesOML;
+			PFNWGLSWAPBUFFERSMSCOMLPROC wglSwapBuffersMscOML;
+			PFNWGLWAITFORSBCOMLPROC wglWaitForSbcOML;
+			bool swap_control_tear;
+		#endif
+
+	#elif defined(TWM_X11)
+
+		Display* display;
+		XIM xim;
+		XIC xic;
+		Atom atom[TWM_X11_ATOM_COUNT];
+		Cursor cursor[2];
+		int opcode;
+		bool xi2;
+		int shm_event;
+		int present_opcode;
+		struct _twm_framebuffer* framebuffers;
+
+		struct {
+			Window focus;
+			bool grabbed;
+			int selected;
+		} raw_input;
+
+		int xkb_event;
+		int rr_event;
+		bool cursor_visible;
+
+		struct {
+			KeyCode keycode[TWM_X11_KEYMOD_COUNT];
+			unsigned int mask[TWM_X11_KEYMOD_COUNT];
+			unsigned int held;
+			unsigned int locked;
+		} keymods;
+
+		struct {
+			int count;
+			int next;
+			int fd[TWM_MAX_WATCH_FDS];
+		} watch;
+
+		int wakeup[2];
+
+		#ifdef TWM_GL
+			int pixel_attribs[TWM_GL_PIXEL_ATTRIBS_SIZE];
+			PFNGLXCREATECONTEXTATTRIBSARBPROC glXCreateContextAttribsARB;
+			PFNGLXSWAPINTERVALEXTPROC glXSwapIntervalEXT;
+			PFNGLXGETSYNCVALUESOMLPROC glXGetSyncValuesOML;
+			PFNGLXSWAPBUFFERSMSCOMLPROC glXSwapBuffersMscOML;
+			PFNGLXWAITFORSBCOMLPROC glXWaitForSbcOML;
+			bool swap_control_tear;
+			int swap_interval;
+			GLXFBConfig* fbconfigs;
+			int fbconfig_count;
+			struct _twm_gl_config* configs;
+			int config_count;
+		#endif
+
+	#elif defined(TWM_COCOA)
+		
+		#ifdef __OBJC__
+
+			NSApplication* app;
+            twm_window clip_window;
+            int clip_x, clip_y;
+            bool cursor_visible;
+
+			#ifdef TWM_GL
+			#pragma clang diagnostic push
+			#pragma clang diagnostic ignored "-Wdeprecated-declarations"
+				NSOpenGLPixelFormatAttribute pixel_attribs[TWM_GL_PIXEL_ATTRIBS_SIZE];
+                int swap_interval;
+                double refresh_rate;
+			#pragma clang diagnostic pop
+			#endif
+
+		#endif
+
+	#elif defined(TWM_HEADLESS)
+
+		struct _twm_window* windows;
+		twm_window clip;
+		int cursor_x, cursor_y;
+		bool cursor_visible;
+
+		struct {
+			int count;
+			int next;
+			int fd[TWM_MAX_WATCH_FDS];
+		} watch;
+
+		int wakeup[2];
+
+	#endif
+
+} twm_data;
+
+TWM_EXTERN_C(extern twm_data _twm_data;)
+
 // =====================[ Functions ]=====================
 
 TWM_EXTERN_C_BEGIN
@@ -753,6 +1228,7 @@ TWM_EXTERN_C_BEGIN
 	extern int twm_screen_mode_count(int screen_index);
 	extern const twm_screen_mode* twm_screen_mode_info(int screen_index, int mode_index);
 	extern int twm_select_screen_mode(int screen_index, int width, int height, int bpp, int hz);
+	extern int twm_best_screen_mode(int screen_index, int width, int height, double refresh_rate);
 	extern int twm_screen_width(int index);
 	extern int twm_screen_height(int index);
 	extern void twm_screen_size(int index, int* width, int* height);
@@ -793,13 +1269,48 @@ TWM_EXTERN_C_BEGIN
 	extern void twm_unclip_cursor();
 	extern void twm_show_cursor(bool show);
 	extern bool twm_cursor_is_visible();
+	extern void twm_rawmouse_master_only(bool enable);
 
 	extern void twm_wait_event(twm_event* evt);
+	extern int twm_wait_event_timeout(twm_event* evt, double seconds);
+	extern int twm_connection_fd();
+	extern bool twm_watch_fd(int fd);
+	extern void twm_unwatch_fd(int fd);
 	extern int twm_peek_event(twm_event* evt);
+	extern int twm_peek_events(twm_event* events, int max);
+	extern bool twm_post_event(const twm_event* evt);
+	extern double twm_server_time_to_time(unsigned long server_time);
 
-	#ifdef TWM_GL
-		extern void twm_gl_set_pixel_attribs(int pixel_attribs[]);
+	#ifdef TWM_HEADLESS
+		extern bool twm_inject_event(const twm_event* evt);
+	#endif
+
+	#ifdef TWM_X11
+		extern Display* twm_x11_display();
+	#endif
+
+	extern void twm_stats_enable(bool enable);
+	extern void twm_stats_frame();
+	extern void twm_stats_reset();
+	extern void twm_get_stats(twm_stats* stats);
+	extern void twm_stats_write_csv(FILE* file, bool header);
+
+	extern bool twm_record_begin(const char* path);
+	extern void twm_record_end();
+	extern bool twm_replay_begin(const char* path, twm_window window, double speed);
+	extern void twm_replay_end();
+
+	extern twm_framebuffer twm_create_framebuffer(twm_window window);
+	extern void twm_destroy_framebuffer(twm_framebuffer framebuffer);
+	extern unsigned int* twm_framebuffer_pixels(twm_framebuffer framebuffer, int* width, int* height, int* stride);
+	extern void twm_present_framebuffer(twm_framebuffer framebuffer);
+	extern bool twm_window_present_feedback(twm_window window, bool enable);
+
+	#ifdef TWM_GL
+		extern void twm_gl_set_pixel_attribs(int pixel_attribs[]);
 		extern twm_gl_context twm_gl_create_context(twm_window window, int* attribs);
+		extern twm_gl_context twm_gl_create_shared_context(twm_window window, int* attribs, twm_gl_context share);
+		extern twm_gl_context twm_gl_create_offscreen_context(int* attribs, twm_gl_context share);
 		extern void twm_gl_delete_context(twm_gl_context context);
 
 		#ifdef TWM_COCOA
@@ -808,6 +1319,11 @@ TWM_EXTERN_C_BEGIN
 			extern void twm_gl_swap_buffers(twm_gl_context context);
 			extern void twm_gl_set_swap_interval(twm_gl_context context, int interval);
 			extern int twm_gl_get_swap_interval(twm_gl_context context);
+			extern bool twm_gl_adaptive_vsync_supported();
+			extern bool twm_gl_sync_control_supported();
+			extern bool twm_gl_get_sync_values(twm_gl_context context, twm_gl_sync_values* values);
+			extern long long twm_gl_swap_buffers_msc(twm_gl_context context, long long target_msc, long long divisor, long long remainder);
+			extern bool twm_gl_wait_for_sbc(twm_gl_context context, long long target_sbc, twm_gl_sync_values* values);
 		#endif
 	#endif
 
@@ -829,16 +1345,63 @@ TWM_EXTERN_C_END
 		return (double)counter.QuadPart / _twm_data.frequency;
 	}
 
+	static inline long long twm_time_ns() {
+		LARGE_INTEGER counter;
+
+		QueryPerformanceCounter(&counter);
+
+		// Split to avoid overflowing counter * 1e9 on long uptimes
+		long long seconds = counter.QuadPart / _twm_data.counter_frequency;
+		long long remainder = counter.QuadPart % _twm_data.counter_frequency;
+
+		return seconds * 1000000000LL + remainder * 1000000000LL / _twm_data.counter_frequency;
+	}
+
 	static inline void twm_sleep(int milliseconds) {
 		Sleep(milliseconds);
 	}
 
+	static inline void twm_sleep_until(long long time_ns) {
+		long long remaining = time_ns - twm_time_ns();
+
+		if (remaining > 0) Sleep((DWORD)(remaining / 1000000));
+	}
+
+	// Gives up the rest of the time slice, used while spinning on a deadline
+	static inline void _twm_yield() {
+		SwitchToThread();
+	}
+
 #else
 
+	// CLOCK_MONOTONIC is the clock X server timestamps and clock_nanosleep(TIMER_ABSTIME) use,
+	// define TWM_CLOCK_ID as CLOCK_MONOTONIC_RAW to ignore NTP slewing instead
+	#if defined(CLOCK_MONOTONIC) && !defined(TWM_CLOCK_ID)
+		#define TWM_CLOCK_ID CLOCK_MONOTONIC
+	#endif
+
+	static inline long long twm_time_ns() {
+		#ifdef TWM_CLOCK_ID
+			struct timespec ts;
+			clock_gettime(TWM_CLOCK_ID, &ts);
+			return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+		#else
+			struct timeval stime;
+			gettimeofday(&stime, 0x0);
+			return (long long)stime.tv_sec * 1000000000LL + (long long)stime.tv_usec * 1000;
+		#endif
+	}
+
 	static inline double twm_time() {
-		struct timeval stime;
-		gettimeofday(&stime, 0x0);
-		return (double)stime.tv_sec + ((double)stime.tv_usec) / 1000000;
+		#ifdef TWM_CLOCK_ID
+			struct timespec ts;
+			clock_gettime(TWM_CLOCK_ID, &ts);
+			return (double)ts.tv_sec + ((double)ts.tv_nsec) / 1000000000;
+		#else
+			struct timeval stime;
+			gettimeofday(&stime, 0x0);
+			return (double)stime.tv_sec + ((double)stime.tv_usec) / 1000000;
+		#endif
 	}
 
 	static inline void twm_sleep(int milliseconds) {
@@ -854,13 +1417,46 @@ TWM_EXTERN_C_END
 		#endif
 	}
 
+	static inline void twm_sleep_until(long long time_ns) {
+		#if defined(TWM_CLOCK_ID) && defined(TIMER_ABSTIME) && !defined(__APPLE__)
+			if (TWM_CLOCK_ID == CLOCK_MONOTONIC) {
+				struct timespec ts;
+				ts.tv_sec = (time_t)(time_ns / 1000000000LL);
+				ts.tv_nsec = (long)(time_ns % 1000000000LL);
+
+				while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR);
+
+				return;
+			}
+		#endif
+
+		long long remaining = time_ns - twm_time_ns();
+
+		if (remaining > 0) {
+			#if _POSIX_C_SOURCE >= 199309L
+				struct timespec ts;
+				ts.tv_sec = (time_t)(remaining / 1000000000LL);
+				ts.tv_nsec = (long)(remaining % 1000000000LL);
+				nanosleep(&ts, NULL);
+			#else
+				usleep((useconds_t)(remaining / 1000));
+			#endif
+		}
+	}
+
+	// Gives up the rest of the time slice, used while spinning on a deadline
+	static inline void _twm_yield() {
+		sched_yield();
+	}
+
 #endif
 
 static inline void twm_pool_events() {
 	_twm_data.mouse.dx = _twm_data.mouse.dy = 0;
+	_twm_data.mouse.fdx = _twm_data.mouse.fdy = 0.0;
 	
-	twm_event evt;
-	while (twm_peek_event(&evt));
+	twm_event events[16];
+	while (twm_peek_events(events, 16) == 16);
 }
 
 static inline int twm_round(double x) {
@@ -883,6 +1479,44 @@ static inline int twm_mouse_dy() {
 	return _twm_data.mouse.dy;
 }
 
+static inline double twm_mouse_fx() {
+	return _twm_data.mouse.fx;
+}
+
+static inline double twm_mouse_fy() {
+	return _twm_data.mouse.fy;
+}
+
+static inline double twm_mouse_fdx() {
+	return _twm_data.mouse.fdx;
+}
+
+static inline double twm_mouse_fdy() {
+	return _twm_data.mouse.fdy;
+}
+
+// When enabled, raw motion is summed and reported as one TWM_EVENT_RAWMOUSE_MOVE per drain
+static inline void twm_coalesce_rawmouse(bool enable) {
+	_twm_data.mouse.raw.coalesce = enable;
+}
+
+static inline bool twm_rawmouse_is_coalesced() {
+	return _twm_data.mouse.raw.coalesce;
+}
+
+static inline bool twm_rawmouse_is_master_only() {
+	return _twm_data.mouse.raw.master_only;
+}
+
+// Only the final size/move of each window is reported per drain of the event queue
+static inline void twm_coalesce_window_events(bool enable) {
+	_twm_data.window.coalesce = enable;
+}
+
+static inline bool twm_window_events_are_coalesced() {
+	return _twm_data.window.coalesce;
+}
+
 static inline bool twm_mb_state(twm_mouse_button button) {
 	return _twm_data.mouse.buttons[button];
 }
@@ -935,6 +1569,159 @@ static inline double twm_fps_limit(int fps, double start_time) {
 	return frame_time;
 }
 
+static inline void twm_frame_pacer_reset_stats(twm_frame_pacer* pacer) {
+	memset(&pacer->stats, 0, sizeof(pacer->stats));
+}
+
+static inline void twm_frame_pacer_init(twm_frame_pacer* pacer, int fps) {
+	memset(pacer, 0, sizeof(*pacer));
+
+	pacer->period = fps > 0 ? 1000000000LL / fps : 0;
+	pacer->slack = 500000;
+}
+
+static inline void twm_frame_pacer_set_fps(twm_frame_pacer* pacer, int fps) {
+	pacer->period = fps > 0 ? 1000000000LL / fps : 0;
+	pacer->deadline = 0;
+}
+
+// Fractional rates matter here: pacing 59.94 Hz as 60 drifts a whole frame every ~17 seconds
+static inline void twm_frame_pacer_set_rate(twm_frame_pacer* pacer, double rate) {
+	pacer->period = rate > 0.0 ? (long long)(1000000000.0 / rate + 0.5) : 0;
+	pacer->deadline = 0;
+}
+
+// Paces to the refresh rate of the screen the window is on, returns false if it is unknown
+static inline bool twm_frame_pacer_lock_refresh(twm_frame_pacer* pacer, twm_window window) {
+	int index = twm_screen_from_window(window);
+	const twm_screen* screen = twm_screen_info(index);
+
+	const twm_screen_mode* mode = screen ? twm_screen_mode_info(index, screen->modes.current) : NULL;
+
+	if (!mode || mode->refresh_rate <= 0.0) return false;
+
+	twm_frame_pacer_set_rate(pacer, mode->refresh_rate);
+
+	return true;
+}
+
+// Sleeps until the next absolute deadline and returns the time since the previous frame in seconds
+static inline double twm_frame_pacer_wait(twm_frame_pacer* pacer) {
+	long long now = twm_time_ns();
+
+	// Unpaced, only measure the frame time
+	if (pacer->period <= 0) {
+		if (pacer->last != 0) pacer->stats.frame_time = (now - pacer->last) / 1000000000.0;
+
+		pacer->last = now;
+
+		return pacer->stats.frame_time;
+	}
+
+	if (pacer->deadline == 0) {
+		pacer->deadline = now + pacer->period;
+	}
+
+	if (now < pacer->deadline) {
+		long long target = pacer->deadline - pacer->slack;
+
+		if (target > now) {
+			twm_sleep_until(target);
+
+			// Grow quickly when the OS oversleeps, shrink slowly when it is on time
+			long long overshoot = twm_time_ns() - target;
+			long long error = overshoot - pacer->slack;
+
+			pacer->slack += error > 0 ? error / 2 : error / 16;
+
+			if (pacer->slack < 0) pacer->slack = 0;
+			if (pacer->slack > TWM_FRAME_PACER_MAX_SLACK) pacer->slack = TWM_FRAME_PACER_MAX_SLACK;
+			if (pacer->slack > pacer->period / 2) pacer->slack = pacer->period / 2;
+		}
+
+		while ((now = twm_time_ns()) < pacer->deadline) _twm_yield();
+
+		pacer->deadline += pacer->period;
+	}
+	else {
+		// Missed the deadline, schedule from now instead of trying to catch up
+		pacer->stats.missed++;
+		pacer->deadline = now + pacer->period;
+	}
+
+	if (pacer->last != 0) {
+		double frame_time = (now - pacer->last) / 1000000000.0;
+		double jitter = frame_time - pacer->period / 1000000000.0;
+		double delta = jitter - pacer->stats.mean;
+
+		pacer->stats.frames++;
+		pacer->stats.frame_time = frame_time;
+		pacer->stats.mean += delta / pacer->stats.frames;
+		pacer->stats.m2 += delta * (jitter - pacer->stats.mean);
+
+		if (jitter < 0) jitter = -jitter;
+		if (jitter > pacer->stats.max) pacer->stats.max = jitter;
+	}
+
+	pacer->last = now;
+
+	return pacer->stats.frame_time;
+}
+
+// Moves the next deadline onto the vblank grid given by a presentation timestamp in seconds
+static inline void twm_frame_pacer_sync(twm_frame_pacer* pacer, double present_time) {
+	if (pacer->period <= 0) return;
+
+	long long vblank = (long long)(present_time * 1000000000.0);
+	long long now = twm_time_ns();
+
+	if (vblank > now) return;
+
+	pacer->deadline = vblank + ((now - vblank) / pacer->period + 1) * pacer->period;
+}
+
+static inline void twm_frame_pacer_stats(const twm_frame_pacer* pacer, twm_frame_stats* stats) {
+	stats->frames = pacer->stats.frames;
+	stats->missed = pacer->stats.missed;
+	stats->frame_time = pacer->stats.frame_time;
+	stats->jitter_mean = pacer->stats.mean;
+	stats->jitter_stddev = pacer->stats.frames > 1 ? sqrt(pacer->stats.m2 / (pacer->stats.frames - 1)) : 0.0;
+	stats->jitter_max = pacer->stats.max;
+}
+
+static inline bool twm_stats_is_enabled() {
+	return _twm_data.stats.enabled;
+}
+
+static inline bool twm_record_is_active() {
+	return _twm_data.record.file != NULL;
+}
+
+static inline bool twm_replay_is_active() {
+	return _twm_data.replay.data != NULL;
+}
+
+// Nested calls (twm_wait_event polling twm_peek_event) are only timed at the outermost level
+static inline long long _twm_stats_begin() {
+	if (!_twm_data.stats.enabled || _twm_data.stats.depth++ > 0) return 0;
+
+	return twm_time_ns();
+}
+
+static inline void _twm_stats_end_events(long long start, int count) {
+	if (!_twm_data.stats.enabled || --_twm_data.stats.depth > 0) return;
+
+	_twm_data.stats.event_time += twm_time_ns() - start;
+	_twm_data.stats.events += count;
+	_twm_data.stats.frame_events += count;
+}
+
+static inline void _twm_stats_end_swap(long long start) {
+	if (!_twm_data.stats.enabled || --_twm_data.stats.depth > 0) return;
+
+	_twm_data.stats.swap_time += twm_time_ns() - start;
+}
+
 static inline void twm_grab_cursor(twm_window window) {
 	twm_clip_cursor(window);
 	twm_show_cursor(false);
@@ -960,10 +1747,17 @@ static inline void twm_ungrab_cursor() {
 		}
 
 		static inline void twm_gl_swap_buffers(twm_gl_context context) {
+			long long start = _twm_stats_begin();
+
 			SwapBuffers(context->hdc);
+
+			_twm_stats_end_swap(start);
 		}
 
+		// Negative intervals ask for adaptive vsync, falling back to regular vsync without swap_control_tear
 		static inline void twm_gl_set_swap_interval(twm_gl_context context, int interval) {
+			if (interval < 0 && !_twm_data.swap_control_tear) interval = -interval;
+
 			_twm_data.wglSwapIntervalEXT(interval);
 		}
 
@@ -971,33 +1765,136 @@ static inline void twm_ungrab_cursor() {
 			return _twm_data.wglGetSwapIntervalEXT();
 		}
 
+		static inline bool twm_gl_adaptive_vsync_supported() {
+			return _twm_data.swap_control_tear;
+		}
+
+		static inline bool twm_gl_sync_control_supported() {
+			return _twm_data.wglGetSyncValuesOML != NULL;
+		}
+
+		static inline bool twm_gl_get_sync_values(twm_gl_context context, twm_gl_sync_values* values) {
+			INT64 ust, msc, sbc;
+
+			if (_twm_data.wglGetSyncValuesOML == NULL || !_twm_data.wglGetSyncValuesOML(context->hdc, &ust, &msc, &sbc)) return false;
+
+			values->ust = ust;
+			values->msc = msc;
+			values->sbc = sbc;
+
+			return true;
+		}
+
+		// Swaps at target_msc, or once msc % divisor == remainder if already past it. Returns the swap's sbc, -1 on failure
+		static inline long long twm_gl_swap_buffers_msc(twm_gl_context context, long long target_msc, long long divisor, long long remainder) {
+			if (_twm_data.wglSwapBuffersMscOML == NULL) return -1;
+
+			long long start = _twm_stats_begin();
+
+			long long sbc = _twm_data.wglSwapBuffersMscOML(context->hdc, target_msc, divisor, remainder);
+
+			_twm_stats_end_swap(start);
+
+			return sbc;
+		}
+
+		// Blocks until swap target_sbc has completed, values then hold exactly when it reached the screen
+		static inline bool twm_gl_wait_for_sbc(twm_gl_context context, long long target_sbc, twm_gl_sync_values* values) {
+			INT64 ust, msc, sbc;
+
+			if (_twm_data.wglWaitForSbcOML == NULL || !_twm_data.wglWaitForSbcOML(context->hdc, target_sbc, &ust, &msc, &sbc)) return false;
+
+			values->ust = ust;
+			values->msc = msc;
+			values->sbc = sbc;
+
+			return true;
+		}
+
 	#endif
 
 #elif defined(TWM_X11)
 
 	#ifdef TWM_GL
 
+		// Binds to the calling thread, so worker threads can each keep their own offscreen context current
 		static inline void twm_gl_make_current(twm_gl_context context) {
 			if (context != NULL) {
-				glXMakeCurrent(_twm_data.display, context->window, context->context);
+				glXMakeContextCurrent(_twm_data.display, context->window, context->window, context->context);
 			}
 			else {
-				glXMakeCurrent(NULL, None, 0);
+				glXMakeContextCurrent(_twm_data.display, None, None, NULL);
 			}
 		}
 
 		static inline void twm_gl_swap_buffers(twm_gl_context context) {
+			long long start = _twm_stats_begin();
+
 			glXSwapBuffers(_twm_data.display, context->window);
+
+			_twm_stats_end_swap(start);
 		}
 
+		// Negative intervals ask for adaptive vsync, falling back to regular vsync without swap_control_tear
 		static inline void twm_gl_set_swap_interval(twm_gl_context context, int interval) {
+			if (interval < 0 && !_twm_data.swap_control_tear) interval = -interval;
+
+			if (_twm_data.glXSwapIntervalEXT == NULL) return;
+
 			_twm_data.glXSwapIntervalEXT(_twm_data.display, context->window, interval);
+			_twm_data.swap_interval = interval;
 		}
 
 		static inline int twm_gl_get_swap_interval(twm_gl_context context) {
 			return _twm_data.swap_interval;
 		}
 
+		static inline bool twm_gl_adaptive_vsync_supported() {
+			return _twm_data.swap_control_tear;
+		}
+
+		static inline bool twm_gl_sync_control_supported() {
+			return _twm_data.glXGetSyncValuesOML != NULL;
+		}
+
+		static inline bool twm_gl_get_sync_values(twm_gl_context context, twm_gl_sync_values* values) {
+			int64_t ust, msc, sbc;
+
+			if (_twm_data.glXGetSyncValuesOML == NULL || !_twm_data.glXGetSyncValuesOML(_twm_data.display, context->window, &ust, &msc, &sbc)) return false;
+
+			values->ust = ust;
+			values->msc = msc;
+			values->sbc = sbc;
+
+			return true;
+		}
+
+		// Swaps at target_msc, or once msc % divisor == remainder if already past it. Returns the swap's sbc, -1 on failure
+		static inline long long twm_gl_swap_buffers_msc(twm_gl_context context, long long target_msc, long long divisor, long long remainder) {
+			if (_twm_data.glXSwapBuffersMscOML == NULL) return -1;
+
+			long long start = _twm_stats_begin();
+
+			long long sbc = _twm_data.glXSwapBuffersMscOML(_twm_data.display, context->window, target_msc, divisor, remainder);
+
+			_twm_stats_end_swap(start);
+
+			return sbc;
+		}
+
+		// Blocks until swap target_sbc has completed, values then hold exactly when it reached the screen
+		static inline bool twm_gl_wait_for_sbc(twm_gl_context context, long long target_sbc, twm_gl_sync_values* values) {
+			int64_t ust, msc, sbc;
+
+			if (_twm_data.glXWaitForSbcOML == NULL || !_twm_data.glXWaitForSbcOML(_twm_data.display, context->window, target_sbc, &ust, &msc, &sbc)) return false;
+
+			values->ust = ust;
+			values->msc = msc;
+			values->sbc = sbc;
+
+			return true;
+		}
+
 	#endif
 
 #endif
@@ -1232,21 +2129,38 @@ int twm_current_screen_mode(int screen_index) {
 	return _twm_data.screen.screen[screen_index].modes.current;
 }
 
+#if defined(TWM_X11)
+	static void _twm_x11_decode_screen_modes(twm_screen* screen);
+#endif
+
+// X11 only decodes a screen's mode list the first time it is asked for
+static twm_screen_mode* _twm_screen_modes(twm_screen* screen) {
+#if defined(TWM_X11)
+	if (screen->modes.mode == NULL && screen->modes.count > 0) _twm_x11_decode_screen_modes(screen);
+#endif
+
+	return screen->modes.mode;
+}
+
 const twm_screen_mode* twm_screen_mode_info(int screen_index, int mode_index) {
 	if (screen_index < 0 || screen_index >= _twm_data.screen.count || mode_index < 0) return NULL;
 
-	const twm_screen* screen = &_twm_data.screen.screen[screen_index];
+	twm_screen* screen = &_twm_data.screen.screen[screen_index];
 
 	if (mode_index >= screen->modes.count) return NULL;
 
-	return &_twm_data.screen.screen[screen_index].modes.mode[mode_index];
+	twm_screen_mode* modes = _twm_screen_modes(screen);
+
+	return modes ? &modes[mode_index] : NULL;
 }
 
 int twm_select_screen_mode(int screen_index, int width, int height, int bpp, int hz) {
 	if (screen_index < 0 || screen_index >= _twm_data.screen.count) return -1;
 
-	for (int i = 0; i < _twm_data.screen.screen[screen_index].modes.count; i++) {
-		const twm_screen_mode* mode = &_twm_data.screen.screen[screen_index].modes.mode[i];
+	twm_screen_mode* modes = _twm_screen_modes(&_twm_data.screen.screen[screen_index]);
+
+	for (int i = 0; modes && i < _twm_data.screen.screen[screen_index].modes.count; i++) {
+		const twm_screen_mode* mode = &modes[i];
 
 		if (mode->width == width && mode->height == height && mode->bpp == bpp && mode->hz == hz) {
 			return i;
@@ -1256,6 +2170,47 @@ int twm_select_screen_mode(int screen_index, int width, int height, int bpp, int
 	return -1;
 }
 
+// Closest size first, then the refresh rate closest to the requested one (the highest if refresh_rate <= 0),
+// then the preferred mode. TWM_CURRENT keeps the current size, interlaced and doublescan modes are never picked
+int twm_best_screen_mode(int screen_index, int width, int height, double refresh_rate) {
+	if (screen_index < 0 || screen_index >= _twm_data.screen.count) return -1;
+
+	twm_screen* screen = &_twm_data.screen.screen[screen_index];
+	twm_screen_mode* modes = _twm_screen_modes(screen);
+
+	if (modes == NULL) return -1;
+
+	if (width == TWM_CURRENT) width = screen->width;
+	if (height == TWM_CURRENT) height = screen->height;
+
+	int best = -1;
+	long long best_size = LLONG_MAX;
+	double best_rate = INFINITY;
+	bool best_preferred = false;
+
+	for (int i = 0; i < screen->modes.count; i++) {
+		const twm_screen_mode* mode = &modes[i];
+
+		if (mode->flags & (TWM_SCREEN_MODE_INTERLACED | TWM_SCREEN_MODE_DOUBLESCAN)) continue;
+
+		long long dw = mode->width - width, dh = mode->height - height;
+		long long size = dw * dw + dh * dh;
+		double rate = refresh_rate > 0.0 ? fabs(mode->refresh_rate - refresh_rate) : -mode->refresh_rate;
+		bool preferred = mode->flags & TWM_SCREEN_MODE_PREFERRED;
+
+		if (size < best_size ||
+			(size == best_size && (rate < best_rate - 0.001 ||
+			(fabs(rate - best_rate) <= 0.001 && preferred && !best_preferred)))) {
+			best = i;
+			best_size = size;
+			best_rate = rate;
+			best_preferred = preferred;
+		}
+	}
+
+	return best;
+}
+
 int twm_screen_width(int index) {
 	if (index < 0 || index >= _twm_data.screen.count) return -1;
 
@@ -1315,2570 +2270,2177 @@ void twm_screen_rect(int index, twm_rect* rect) {
 	rect->height = _twm_data.screen.screen[index].height;
 }
 
-#if defined(TWM_WIN32)
+// The last slot is kept for _twm_push_event_front, events that do not fit are counted in twm_stats.dropped_events
+static inline bool _twm_push_event(const twm_event* evt) {
+	if (_twm_data.queue.count >= TWM_EVENT_QUEUE_SIZE - 1) {
+		_twm_data.stats.dropped_events++;
 
-twm_data _twm_data = { 0 };
+		return false;
+	}
 
-#define WM_WINDOW_CLOSE (WM_APP + 0xF0)
-#define WM_WINDOW_SIZE (WM_APP + 0xF1)
-#define WM_WINDOW_MOVE (WM_APP + 0xF2)
-#define WM_WINDOW_MAXIMIZE (WM_APP + 0xF3)
-#define WM_WINDOW_MINIMIZE (WM_APP + 0xF4)
-#define WM_WINDOW_RESTORE (WM_APP + 0xF5)
-#define WM_WINDOW_ACTIVE (WM_APP + 0xF6)
-#define WM_WINDOW_INACTIVE (WM_APP + 0xF7)
-#define WM_MOUSE_ENTER (WM_APP + 0xF8)
-#define WM_MOUSE_LEAVE (WM_APP + 0xF9)
+	int tail = (_twm_data.queue.head + _twm_data.queue.count) % TWM_EVENT_QUEUE_SIZE;
+	_twm_data.queue.event[tail] = *evt;
+	_twm_data.queue.count++;
 
-typedef struct twm_window_data {
-	twm_window_flags flags;
-	unsigned long style;
-	BOOL dragging;
-	BOOL resizing;
-	POINT last_mouse;
-	RECT original_rect;
-	int resize_edge;
-	int last_state;
-	int width;
-	int height;
-	int x;
-	int y;
-	BOOL tracking_mouse;
-	BOOL disable_events;
-	BOOL was_closed;
-	BOOL was_resized;
-	void * ptr;
-} twm_window_data;
+	return true;
+}
 
-static LRESULT CALLBACK _twm_window_proc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
+// Queues evt ahead of events already pushed, for translations that must deliver something before them
+static inline bool _twm_push_event_front(const twm_event* evt) {
+	if (_twm_data.queue.count == TWM_EVENT_QUEUE_SIZE) return false;
 
-#ifdef TWM_GL
+	_twm_data.queue.head = (_twm_data.queue.head + TWM_EVENT_QUEUE_SIZE - 1) % TWM_EVENT_QUEUE_SIZE;
+	_twm_data.queue.event[_twm_data.queue.head] = *evt;
+	_twm_data.queue.count++;
 
-	#define WGL_DRAW_TO_WINDOW_ARB              0x2001
-	#define WGL_SUPPORT_OPENGL_ARB              0x2010
-	#define WGL_DOUBLE_BUFFER_ARB               0x2011
-	#define WGL_PIXEL_TYPE_ARB                  0x2013
-	#define WGL_COLOR_BITS_ARB                  0x2014
-	#define WGL_ALPHA_BITS_ARB					0x201B
-	#define WGL_DEPTH_BITS_ARB                  0x2022
-	#define WGL_STENCIL_BITS_ARB                0x2023
-	#define WGL_TYPE_RGBA_ARB                   0x202B
-	#define WGL_FRAMEBUFFER_SRGB_CAPABLE_ARB    0x20A9
-	#define WGL_SAMPLE_BUFFERS_ARB              0x2041
-	#define WGL_SAMPLES_ARB                     0x2042
+	return true;
+}
 
-	#define WGL_CONTEXT_MAJOR_VERSION_ARB       0x2091
-	#define WGL_CONTEXT_MINOR_VERSION_ARB       0x2092
-	#define WGL_CONTEXT_PROFILE_MASK_ARB        0x9126
-	#define WGL_CONTEXT_CORE_PROFILE_BIT_ARB    0x00000001
-	#define WGL_CONTEXT_COMPATIBILITY_PROFILE_BIT_ARB 0x00000002
+#if defined(TWM_WIN32)
 
-#endif
+	static inline long _twm_atomic_load(volatile long* value) {
+		return InterlockedOr(value, 0);
+	}
 
-static BOOL CALLBACK _twm_monitor_count_proc(HMONITOR hMonitor, HDC hdc, LPRECT lprcMonitor, LPARAM lParam) {
-	(*(int*)lParam)++;
+	static inline void _twm_atomic_store(volatile long* value, long desired) {
+		InterlockedExchange(value, desired);
+	}
 
-	return TRUE;
-}
+	static inline bool _twm_atomic_cas(volatile long* value, long* expected, long desired) {
+		long previous = InterlockedCompareExchange(value, desired, *expected);
 
-static BOOL CALLBACK _twm_monitor_proc(HMONITOR hMonitor, HDC hdc, LPRECT lprcMonitor, LPARAM lParam) {
-	int* index = (int*)lParam;
-	
-	twm_screen* screen = &_twm_data.screen.screen[*index];
+		if (previous == *expected) return true;
 
-	screen->hmonitor = hMonitor;
-	screen->x = lprcMonitor->left;
-	screen->y = lprcMonitor->top;
-	screen->width = lprcMonitor->right - lprcMonitor->left;
-	screen->height = lprcMonitor->bottom - lprcMonitor->top;
+		*expected = previous;
 
-	MONITORINFOEX mi;
-	mi.cbSize = sizeof(mi);
+		return false;
+	}
 
-	if (GetMonitorInfo(hMonitor, (MONITORINFO*)&mi)) {
-		strncpy(screen->szDevice, mi.szDevice, sizeof(screen->szDevice));
+#else
 
-		DISPLAY_DEVICE monitor = { .cb = sizeof(monitor) };
-		EnumDisplayDevices(mi.szDevice, 0, &monitor, 0);
+	static inline long _twm_atomic_load(volatile long* value) {
+		return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+	}
 
-		strncpy(screen->name, monitor.DeviceString, sizeof(screen->name));
+	static inline void _twm_atomic_store(volatile long* value, long desired) {
+		__atomic_store_n(value, desired, __ATOMIC_RELEASE);
+	}
 
-		DEVMODE currentDevMode = { 0 };
-		currentDevMode.dmSize = sizeof(DEVMODE);
+	static inline bool _twm_atomic_cas(volatile long* value, long* expected, long desired) {
+		return __atomic_compare_exchange_n(value, expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+	}
 
-		EnumDisplaySettings(mi.szDevice, ENUM_CURRENT_SETTINGS, &currentDevMode);
+#endif
 
-		DEVMODE devMode = { 0 };
-		devMode.dmSize = sizeof(DEVMODE);
-		
-		screen->modes.count = 0;
-		while (EnumDisplaySettings(mi.szDevice, screen->modes.count, &devMode)) screen->modes.count++;
+static inline void _twm_init_post_queue() {
+	_twm_data.post.enqueue = 0;
+	_twm_data.post.dequeue = 0;
 
-		screen->modes.mode = (twm_screen_mode*)malloc(sizeof(twm_screen_mode) * screen->modes.count);
+	for (long i = 0; i < TWM_POST_QUEUE_SIZE; i++) {
+		_twm_data.post.cell[i].sequence = i;
+	}
+}
 
-		int modeIndex = 0;
-		while (EnumDisplaySettings(mi.szDevice, modeIndex, &devMode)) {
-			twm_screen_mode* model = &screen->modes.mode[modeIndex];
-			
-			if (currentDevMode.dmPelsWidth == devMode.dmPelsWidth &&
-				currentDevMode.dmPelsHeight == devMode.dmPelsHeight &&
-				currentDevMode.dmBitsPerPel == devMode.dmBitsPerPel &&
-				currentDevMode.dmDisplayFrequency == devMode.dmDisplayFrequency &&
-				currentDevMode.dmDisplayFlags == devMode.dmDisplayFlags) {
-				screen->modes.current = modeIndex;
-			}
-			
-			memcpy(&model->devmode, &devMode, sizeof(devMode));
+// Each cell's sequence tells producers and the consumer whose turn it is, so no locks are needed
+static inline bool _twm_post_push(const twm_event* evt) {
+	long pos = _twm_atomic_load(&_twm_data.post.enqueue);
 
-			model->width = devMode.dmPelsWidth;
-			model->height = devMode.dmPelsHeight;
-			model->bpp = devMode.dmBitsPerPel;
-			model->hz = devMode.dmDisplayFrequency;
+	for (;;) {
+		volatile long* sequence = &_twm_data.post.cell[pos & (TWM_POST_QUEUE_SIZE - 1)].sequence;
+		long diff = (long)((unsigned long)_twm_atomic_load(sequence) - (unsigned long)pos);
 
-			modeIndex++;
+		if (diff == 0) {
+			if (_twm_atomic_cas(&_twm_data.post.enqueue, &pos, (long)((unsigned long)pos + 1))) break;
+		}
+		else if (diff < 0) {
+			return false;
+		}
+		else {
+			pos = _twm_atomic_load(&_twm_data.post.enqueue);
 		}
 	}
 
-	(*index)++;
+	_twm_data.post.cell[pos & (TWM_POST_QUEUE_SIZE - 1)].event = *evt;
+	_twm_data.post.cell[pos & (TWM_POST_QUEUE_SIZE - 1)].event.common.server_time = 0;
+	_twm_atomic_store(&_twm_data.post.cell[pos & (TWM_POST_QUEUE_SIZE - 1)].sequence, (long)((unsigned long)pos + 1));
 
-	return TRUE;
+	return true;
 }
 
-int twm_init() {
-	timeBeginPeriod(1);
+static inline bool _twm_post_pop(twm_event* evt) {
+	long pos = _twm_data.post.dequeue;
+	volatile long* sequence = &_twm_data.post.cell[pos & (TWM_POST_QUEUE_SIZE - 1)].sequence;
 
-	LARGE_INTEGER frequencyCounter;
-	QueryPerformanceFrequency(&frequencyCounter);
-	_twm_data.frequency = (double)frequencyCounter.QuadPart;
+	if (_twm_atomic_load(sequence) != (long)((unsigned long)pos + 1)) return false;
 
-	if (!SetProcessDpiAwarenessContext(DPI_AWARENESS_CONTEXT_PER_MONITOR_AWARE_V2)) {
-		if (FAILED(SetProcessDpiAwareness(PROCESS_PER_MONITOR_DPI_AWARE))) {
-			SetProcessDPIAware();
-		}
-	}
+	*evt = _twm_data.post.cell[pos & (TWM_POST_QUEUE_SIZE - 1)].event;
+	evt->common.time = twm_time();
 
-	_twm_data.hInstance = GetModuleHandle(NULL);
+	_twm_data.post.dequeue = (long)((unsigned long)pos + 1);
+	_twm_atomic_store(sequence, (long)((unsigned long)pos + TWM_POST_QUEUE_SIZE));
 
-	SetConsoleOutputCP(CP_UTF8);
-	SetConsoleCP(CP_UTF8);
+	return true;
+}
 
-	EnumDisplayMonitors(NULL, NULL, _twm_monitor_count_proc, (LPARAM)&_twm_data.screen.count);
-	_twm_data.screen.screen = (twm_screen*)malloc(sizeof(twm_screen) * _twm_data.screen.count);
-	memset(_twm_data.screen.screen, 0, sizeof(twm_screen) * _twm_data.screen.count);
+static inline bool _twm_pop_event(twm_event* evt) {
+	if (_twm_data.queue.count == 0) return _twm_post_pop(evt);
 
-	int screen_index = 0;
-	EnumDisplayMonitors(NULL, NULL, _twm_monitor_proc, (LPARAM)&screen_index);
+	*evt = _twm_data.queue.event[_twm_data.queue.head];
+	_twm_data.queue.head = (_twm_data.queue.head + 1) % TWM_EVENT_QUEUE_SIZE;
+	_twm_data.queue.count--;
 
-	memset(&_twm_data.wndClass, 0, sizeof(_twm_data.wndClass));
+	return true;
+}
 
-	_twm_data.wndClass.cbSize = sizeof(WNDCLASSEX);
-	_twm_data.wndClass.style = CS_OWNDC;
-	_twm_data.wndClass.lpfnWndProc = &_twm_window_proc;
-	_twm_data.wndClass.hInstance = _twm_data.hInstance;
-	_twm_data.wndClass.hIcon = LoadIcon(NULL, IDI_APPLICATION);
-	_twm_data.wndClass.hIcon = LoadIcon(NULL, IDI_APPLICATION);
-	_twm_data.wndClass.hCursor = LoadCursor(NULL, IDC_ARROW);
-	_twm_data.wndClass.hbrBackground = (HBRUSH)GetStockObject(BLACK_BRUSH);
-	_twm_data.wndClass.lpszClassName = TEXT("twm_class");
+// Server clocks are 32-bit millisecond counters, so they are unwrapped relative to the last one seen
+static inline double _twm_unwrap_server_time(unsigned long server_time, double epoch, unsigned long last) {
+	server_time &= 0xFFFFFFFFUL;
 
-	if (!RegisterClassEx(&_twm_data.wndClass))
-	{
-		return 0;
-	}
+	if (server_time < last && last - server_time > 0x80000000UL) epoch += 4294967296.0;
+	else if (server_time > last && server_time - last > 0x80000000UL) epoch -= 4294967296.0;
 
-#ifdef TWM_GL
-	{
-		HWND hwnd = CreateWindowEx(0, TEXT("twm_class"), TEXT(""), WS_OVERLAPPEDWINDOW, 0, 0, 1, 1, NULL, NULL, _twm_data.hInstance, NULL);
+	return (epoch + server_time) / 1000.0;
+}
 
-		HDC hdc = GetDC(hwnd);
+double twm_server_time_to_time(unsigned long server_time) {
+	if (!_twm_data.server_clock.valid) return 0.0;
 
-		PIXELFORMATDESCRIPTOR pfd = {
-			sizeof(PIXELFORMATDESCRIPTOR), 1,
-			PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL | PFD_DOUBLEBUFFER,
-			PFD_TYPE_RGBA, 32,
-			0, 0, 0, 0, 0, 0,
-			0, 0, 0, 0, 0, 0, 0,
-			24, 8, 0,
-			PFD_MAIN_PLANE, 0, 0, 0, 0
-		};
+	return _twm_unwrap_server_time(server_time, _twm_data.server_clock.epoch, _twm_data.server_clock.last) + _twm_data.server_clock.offset;
+}
 
-		int pf = ChoosePixelFormat(hdc, &pfd);
-		SetPixelFormat(hdc, pf, &pfd);
-		HGLRC temp_context = wglCreateContext(hdc);
-		wglMakeCurrent(hdc, temp_context);
+void twm_stats_enable(bool enable) {
+	_twm_data.stats.enabled = enable;
+	_twm_data.stats.depth = 0;
+	_twm_data.stats.last_frame = 0;
+}
 
-		_twm_data.wglChoosePixelFormatARB = (PFNWGLCHOOSEPIXELFORMATARBPROC) wglGetProcAddress("wglChoosePixelFormatARB");
-		_twm_data.wglCreateContextAttribsARB = (PFNWGLCREATECONTEXTATTRIBSARBPROC) wglGetProcAddress("wglCreateContextAttribsARB");
-		_twm_data.wglSwapIntervalEXT = (PFNWGLSWAPINTERVALEXTPROC) wglGetProcAddress("wglSwapIntervalEXT");
-		_twm_data.wglGetSwapIntervalEXT = (PFNWGLGETSWAPINTERVALEXTPROC)wglGetProcAddress("wglGetSwapIntervalEXT");;
+// Marks the end of a frame, call it once per iteration of the main loop
+void twm_stats_frame() {
+	if (!_twm_data.stats.enabled) return;
 
-		wglMakeCurrent(NULL, NULL);
-		wglDeleteContext(temp_context);
+	long long now = twm_time_ns();
 
-		ReleaseDC(hwnd, hdc);
-		DestroyWindow(hwnd);
+	if (_twm_data.stats.last_frame != 0) {
+		long long frame_time = now - _twm_data.stats.last_frame;
+		long long bucket = frame_time / TWM_STATS_BUCKET_NS;
 
-		int pixel_attribs[] = {
-			WGL_DRAW_TO_WINDOW_ARB, 1,
-			WGL_SUPPORT_OPENGL_ARB, 1,
-			WGL_PIXEL_TYPE_ARB, WGL_TYPE_RGBA_ARB,
-			WGL_DOUBLE_BUFFER_ARB, 1,
-			WGL_COLOR_BITS_ARB, 32,
-			WGL_ALPHA_BITS_ARB, 8,
-			WGL_DEPTH_BITS_ARB, 24,
-			WGL_STENCIL_BITS_ARB, 8,
-			WGL_FRAMEBUFFER_SRGB_CAPABLE_ARB, 1,
-			WGL_SAMPLE_BUFFERS_ARB, 0,
-			WGL_SAMPLES_ARB, 1,
-			0
-		};
+		if (bucket >= TWM_STATS_HISTOGRAM_SIZE) bucket = TWM_STATS_HISTOGRAM_SIZE - 1;
 
-		memcpy(_twm_data.pixel_attribs, pixel_attribs, sizeof(pixel_attribs));
+		_twm_data.stats.histogram[bucket]++;
+		_twm_data.stats.frames++;
+		_twm_data.stats.frame_time = frame_time;
+		_twm_data.stats.total_time += frame_time;
+
+		if (frame_time > _twm_data.stats.max_time) _twm_data.stats.max_time = frame_time;
 	}
-#endif
 
-	return 1;
+	_twm_data.stats.last_frame = now;
+	_twm_data.stats.frame_events = 0;
 }
 
-void twm_finalize() {
-	for (int i = 0; i < _twm_data.screen.count; i++) {
-		free(_twm_data.screen.screen[i].modes.mode);
-	}
-	free(_twm_data.screen.screen);
-	
-	UnregisterClass(_twm_data.wndClass.lpszClassName, _twm_data.hInstance);
+// Keeps the current frame running so the next twm_stats_frame still measures a whole frame
+void twm_stats_reset() {
+	_twm_data.stats.frames = 0;
+	_twm_data.stats.events = 0;
+	_twm_data.stats.frame_time = 0;
+	_twm_data.stats.total_time = 0;
+	_twm_data.stats.max_time = 0;
+	_twm_data.stats.event_time = 0;
+	_twm_data.stats.swap_time = 0;
+	_twm_data.stats.dropped_events = 0;
 
-	timeEndPeriod(1);
+	memset(_twm_data.stats.histogram, 0, sizeof(_twm_data.stats.histogram));
 }
 
-bool twm_change_screen_mode(int screen_index, int mode_index) {
-	if (screen_index < 0 || screen_index >= _twm_data.screen.count || mode_index < 0) return false;
+// Upper edge of the bucket holding the given fraction of frames, the overflow bucket reports the max
+static double _twm_stats_percentile(double fraction) {
+	long long target = (long long)ceil(_twm_data.stats.frames * fraction);
+	long long count = 0;
 
-	twm_screen* screen = &_twm_data.screen.screen[screen_index];
+	if (target < 1) target = 1;
 
-	if (mode_index >= screen->modes.count) return false;
+	for (int i = 0; i < TWM_STATS_HISTOGRAM_SIZE - 1; i++) {
+		count += _twm_data.stats.histogram[i];
 
-	if (ChangeDisplaySettingsEx(screen->szDevice, &screen->modes.mode[mode_index].devmode, NULL, CDS_FULLSCREEN, NULL) != DISP_CHANGE_SUCCESSFUL) return false;
+		if (count >= target) {
+			long long edge = (i + 1) * (long long)TWM_STATS_BUCKET_NS;
 
-	screen->modes.current = mode_index;
+			return (edge < _twm_data.stats.max_time ? edge : _twm_data.stats.max_time) / 1000000000.0;
+		}
+	}
 
-	return true;
+	return _twm_data.stats.max_time / 1000000000.0;
 }
 
-twm_window twm_create_window(const char* title, int x, int y, int width, int height, twm_window_flags flags) {
-	int screen = twm_screen_from_cursor();
-	twm_rect screen_rect;
-	twm_screen_rect(screen, &screen_rect);
-
-	LONG style = WS_OVERLAPPED | WS_CAPTION | WS_SYSMENU | WS_MINIMIZEBOX;
-
-	if (flags & TWM_WINDOW_RESIZABLE && !(flags & TWM_WINDOW_BORDERLESS)) {
-		style |= WS_THICKFRAME | WS_MAXIMIZEBOX;
-	}
+void twm_get_stats(twm_stats* stats) {
+	long long frames = _twm_data.stats.frames;
 
-	RECT rc = { 0, 0, width, height };
-	AdjustWindowRectEx(&rc, (flags & TWM_WINDOW_BORDERLESS) ? WS_POPUP : WS_OVERLAPPEDWINDOW, 0, WS_EX_APPWINDOW);
+	memset(stats, 0, sizeof(*stats));
 
-	twm_window_data* data = (twm_window_data*)malloc(sizeof(twm_window_data));
-	if (data == NULL) return NULL;
+	stats->frames = frames;
+	stats->events = _twm_data.stats.events;
+	stats->frame_events = _twm_data.stats.frame_events;
+	stats->frame_time = _twm_data.stats.frame_time / 1000000000.0;
+	stats->dropped_events = _twm_data.stats.dropped_events;
 
-	memset(data, 0, sizeof(twm_window_data));
+	memcpy(stats->histogram, _twm_data.stats.histogram, sizeof(stats->histogram));
 
-	data->flags = flags;
-	data->style = style;
-	data->width = width;
-	data->height = height;
+	if (frames == 0) return;
 
-	auto bw = rc.right - rc.left;
-	auto bh = rc.bottom - rc.top;
+	stats->fps = frames * 1000000000.0 / _twm_data.stats.total_time;
+	stats->frame_time_mean = _twm_data.stats.total_time / 1000000000.0 / frames;
+	stats->frame_time_p50 = _twm_stats_percentile(0.50);
+	stats->frame_time_p99 = _twm_stats_percentile(0.99);
+	stats->frame_time_max = _twm_data.stats.max_time / 1000000000.0;
+	stats->events_per_frame = (double)_twm_data.stats.events / frames;
+	stats->event_time = _twm_data.stats.event_time / 1000000000.0 / frames;
+	stats->swap_time = _twm_data.stats.swap_time / 1000000000.0 / frames;
+}
 
-	data->x = x == TWM_CENTER ? (screen_rect.x + (screen_rect.width - bw)) >> 1 : x;
-	data->y = y == TWM_CENTER ? (screen_rect.y + (screen_rect.height - bh)) >> 1 : y;
+// One row per call with times in milliseconds, the histogram is left out
+void twm_stats_write_csv(FILE* file, bool header) {
+	twm_stats stats;
+	twm_get_stats(&stats);
 
-	HWND hwnd = CreateWindowEx
-	(
-		0, _twm_data.wndClass.lpszClassName, title, style,
-		data->x, data->y, bw, bh,
-		HWND_DESKTOP, NULL, _twm_data.hInstance, NULL
-	);
+	if (header) {
+		fprintf(file, "time,frames,fps,frame_ms,mean_ms,p50_ms,p99_ms,max_ms,events,events_per_frame,event_ms,swap_ms,dropped\n");
+	}
 
-	if (hwnd == NULL) return NULL;
+	fprintf(file, "%.6f,%lld,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%lld,%.3f,%.3f,%.3f,%lld\n",
+		twm_time(),
+		stats.frames,
+		stats.fps,
+		stats.frame_time * 1000.0,
+		stats.frame_time_mean * 1000.0,
+		stats.frame_time_p50 * 1000.0,
+		stats.frame_time_p99 * 1000.0,
+		stats.frame_time_max * 1000.0,
+		stats.events,
+		stats.events_per_frame,
+		stats.event_time * 1000.0,
+		stats.swap_time * 1000.0,
+		stats.dropped_events);
+}
 
-	BOOL dark = TRUE;
-	DwmSetWindowAttribute(hwnd, DWMWA_USE_IMMERSIVE_DARK_MODE, &dark, sizeof(dark));
+static inline void _twm_stamp_event(twm_event* evt, unsigned long server_time) {
+	evt->common.time = twm_time();
+	evt->common.server_time = server_time;
 
-	DWORD corner = 2; // DWMWCP_ROUND
-	DwmSetWindowAttribute(hwnd, DWMWA_WINDOW_CORNER_PREFERENCE, &corner, sizeof(corner));
+	if (server_time == 0) return;
 
-	DWORD backdrop = 2; // Mica
-	DwmSetWindowAttribute(hwnd, DWMWA_SYSTEMBACKDROP_TYPE, &backdrop, sizeof(backdrop));
+	server_time &= 0xFFFFFFFFUL;
 
-	// Fix Flickering on switch to borderless
-	SetWindowLong(hwnd, GWL_STYLE, WS_POPUP);
-	SetWindowLong(hwnd, GWL_EXSTYLE, 0);
+	double server_seconds = _twm_unwrap_server_time(server_time, _twm_data.server_clock.epoch, _twm_data.server_clock.last);
+	_twm_data.server_clock.epoch = server_seconds * 1000.0 - server_time;
+	_twm_data.server_clock.last = server_time;
 
-	SetWindowPos(hwnd, NULL, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE | SWP_NOZORDER | SWP_FRAMECHANGED);
+	// Delivery latency only ever adds to the difference, so the smallest one is the best offset estimate
+	double offset = evt->common.time - server_seconds;
 
-	if (!(flags & TWM_WINDOW_BORDERLESS)) {
-		SetWindowLong(hwnd, GWL_STYLE, style);
-		SetWindowLong(hwnd, GWL_EXSTYLE, WS_EX_APPWINDOW);
-		SetWindowPos(hwnd, NULL, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE | SWP_NOZORDER | SWP_FRAMECHANGED);
+	if (!_twm_data.server_clock.valid || offset < _twm_data.server_clock.offset) {
+		_twm_data.server_clock.offset = offset;
+		_twm_data.server_clock.valid = true;
 	}
+}
 
-	SetWindowLongPtr(hwnd, GWLP_USERDATA, (LONG_PTR)data);
+// The fractional part is carried into the next event so integer deltas don't drift
+static inline void _twm_emit_rawmouse(twm_event* evt, twm_window window, double dx, double dy) {
+	double x = dx + _twm_data.mouse.raw.remainder_x;
+	double y = dy + _twm_data.mouse.raw.remainder_y;
 
-	RAWINPUTDEVICE Rid[1];
-	Rid[0].usUsagePage = HID_USAGE_PAGE_GENERIC;
-	Rid[0].usUsage = HID_USAGE_GENERIC_MOUSE;
-	Rid[0].dwFlags = RIDEV_INPUTSINK;
-	Rid[0].hwndTarget = hwnd;
-	RegisterRawInputDevices(Rid, 1, sizeof(Rid[0]));
+	evt->type = TWM_EVENT_RAWMOUSE_MOVE;
+	evt->rawmouse.window = window;
+	evt->rawmouse.dx = _twm_data.mouse.dx = (int)x;
+	evt->rawmouse.dy = _twm_data.mouse.dy = (int)y;
+	evt->rawmouse.fdx = _twm_data.mouse.fdx = dx;
+	evt->rawmouse.fdy = _twm_data.mouse.fdy = dy;
 
-	return hwnd;
+	_twm_data.mouse.raw.remainder_x = x - evt->rawmouse.dx;
+	_twm_data.mouse.raw.remainder_y = y - evt->rawmouse.dy;
 }
 
-static inline twm_window_data* twm_get_window_data(twm_window window) {
-	return (twm_window_data*)GetWindowLongPtr(window, GWLP_USERDATA);
-}
+static inline int _twm_translate_rawmouse(twm_event* evt, twm_window window, double dx, double dy) {
+	if (!_twm_data.mouse.raw.coalesce) {
+		_twm_emit_rawmouse(evt, window, dx, dy);
 
-void twm_destroy_window(twm_window window) {
-	DestroyWindow(window);
-}
+		return 1;
+	}
 
-void twm_show_window(twm_window window, bool visible) {
-	ShowWindow(window, visible ? SW_SHOW : SW_HIDE);
-}
+	_twm_data.mouse.raw.window = window;
+	_twm_data.mouse.raw.server_time = evt->common.server_time;
+	_twm_data.mouse.raw.dx += dx;
+	_twm_data.mouse.raw.dy += dy;
+	_twm_data.mouse.raw.pending = true;
 
-bool twm_window_is_visible(twm_window window) {
-	return IsWindowVisible(window);
+	return 0;
 }
 
-void twm_move_window(twm_window window, int x, int y, int width, int height) {
-	twm_window_data* data = twm_get_window_data(window);
-	
-	int new_x = x, new_y = y;
-	int new_width = width, new_height = height;
-
-	if (x == TWM_CURRENT || x == TWM_CENTER) new_x = data->x;
-	if (y == TWM_CURRENT || y == TWM_CENTER) new_y = data->y;
+static inline int _twm_flush_rawmouse(twm_event* evt) {
+	if (!_twm_data.mouse.raw.pending) return 0;
 
-	int screen = twm_screen_from_position(new_x, new_y);
-	twm_rect screen_rect;
-	twm_screen_rect(screen, &screen_rect);
+	_twm_stamp_event(evt, _twm_data.mouse.raw.server_time);
+	_twm_emit_rawmouse(evt, _twm_data.mouse.raw.window, _twm_data.mouse.raw.dx, _twm_data.mouse.raw.dy);
 
-	if (width == TWM_CURRENT || width == TWM_STRETCH) new_width = data->width;
-	if (height == TWM_CURRENT || height == TWM_STRETCH) new_height = data->height;
+	_twm_data.mouse.raw.dx = _twm_data.mouse.raw.dy = 0.0;
+	_twm_data.mouse.raw.pending = false;
 
-	RECT rc = { 0, 0, new_width, new_height };
-	AdjustWindowRectEx(&rc, GetWindowLong(window, GWL_STYLE), FALSE, GetWindowLong(window, GWL_EXSTYLE));
+	return 1;
+}
 
-	new_width = rc.right - rc.left;
-	new_height = rc.bottom - rc.top;
+// Keeps the polled input state in step with events that did not come through a backend's translation
+static inline void _twm_apply_input_state(const twm_event* evt) {
+	switch (evt->type) {
+		case TWM_EVENT_KEY_DOWN:
+		case TWM_EVENT_KEY_UP:
+			_twm_data.keyboard.keys[evt->keyboard.key & 0x1FF] = evt->type == TWM_EVENT_KEY_DOWN;
+			_twm_data.keyboard.modifiers = evt->keyboard.modifiers;
+			break;
 
-	if (width == TWM_STRETCH) new_width = screen_rect.width - new_x - rc.left;
-	if (height == TWM_STRETCH) new_height = screen_rect.height - new_y - rc.top;
+		case TWM_EVENT_RAWMOUSE_MOVE:
+			_twm_data.mouse.dx = evt->rawmouse.dx;
+			_twm_data.mouse.dy = evt->rawmouse.dy;
+			_twm_data.mouse.fdx = evt->rawmouse.fdx;
+			_twm_data.mouse.fdy = evt->rawmouse.fdy;
+			break;
 
-	if (x == TWM_CENTER) new_x = (screen_rect.x + (screen_rect.width - new_width)) >> 1;
-	if (y == TWM_CENTER) new_y = (screen_rect.y + (screen_rect.height - new_height)) >> 1;
+		case TWM_EVENT_MOUSE_DOWN:
+		case TWM_EVENT_MOUSE_UP:
+			// Replayed and injected buttons come from outside, never index past the array with them
+			if ((unsigned int)evt->mouse.button < sizeof(_twm_data.mouse.buttons) / sizeof(_twm_data.mouse.buttons[0])) {
+				_twm_data.mouse.buttons[evt->mouse.button] = evt->type == TWM_EVENT_MOUSE_DOWN;
+			}
+			// fall through
 
-	SetWindowPos(window, NULL, new_x, new_y, new_width, new_height, SWP_NOZORDER | SWP_NOACTIVATE | SWP_FRAMECHANGED);
+		case TWM_EVENT_MOUSE_MOVE:
+			_twm_data.mouse.x = evt->mouse.x;
+			_twm_data.mouse.y = evt->mouse.y;
+			_twm_data.mouse.fx = evt->mouse.fx;
+			_twm_data.mouse.fy = evt->mouse.fy;
+			break;
 
-	data->x = new_x;
-	data->y = new_y;
+		default:
+			break;
+	}
 }
 
-int twm_window_width(twm_window window) {
-	return twm_get_window_data(window)->width;
+// Log layout: "TWMR", version, sizeof(twm_event), then one record per event:
+// type, payload size, server time, time since twm_record_begin in ns, and the event past its common fields
+#define TWM_RECORD_MAGIC "TWMR"
+#define TWM_RECORD_VERSION 1
+#define TWM_RECORD_HEADER_SIZE 8
+#define TWM_RECORD_ENTRY_SIZE 16
+
+static inline int _twm_record_payload_size(twm_event_type type) {
+	switch (type) {
+		case TWM_EVENT_WINDOW_CLOSE:
+		case TWM_EVENT_WINDOW_SIZE:
+		case TWM_EVENT_WINDOW_MOVE:
+		case TWM_EVENT_WINDOW_MAXIMIZE:
+		case TWM_EVENT_WINDOW_MINIMIZE:
+		case TWM_EVENT_WINDOW_RESTORE:
+		case TWM_EVENT_WINDOW_ACTIVE:
+		case TWM_EVENT_WINDOW_INACTIVE:
+			return sizeof(twm_window_event) - sizeof(twm_common_event);
+
+		case TWM_EVENT_KEY_DOWN:
+		case TWM_EVENT_KEY_UP:
+		case TWM_EVENT_KEY_CHAR:
+			return sizeof(twm_keyboard_event) - sizeof(twm_common_event);
+
+		case TWM_EVENT_RAWMOUSE_MOVE:
+			return sizeof(twm_rawmouse_event) - sizeof(twm_common_event);
+
+		case TWM_EVENT_MOUSE_MOVE:
+		case TWM_EVENT_MOUSE_ENTER:
+		case TWM_EVENT_MOUSE_LEAVE:
+		case TWM_EVENT_MOUSE_WHEEL:
+		case TWM_EVENT_MOUSE_DOWN:
+		case TWM_EVENT_MOUSE_UP:
+			return sizeof(twm_mouse_event) - sizeof(twm_common_event);
+
+		// fd, user and frame events refer to state that does not survive the session
+		default:
+			return -1;
+	}
 }
 
-int twm_window_height(twm_window window) {
-	return twm_get_window_data(window)->height;
-}
+static void _twm_record_flush() {
+	if (_twm_data.record.used > 0) {
+		fwrite(_twm_data.record.buffer, 1, _twm_data.record.used, _twm_data.record.file);
 
-void twm_window_size(twm_window window, int* width, int* height) {
-	twm_window_data* data = twm_get_window_data(window);
-	*width = data->width;
-	*height = data->height;
+		_twm_data.record.used = 0;
+	}
 }
 
-int twm_window_x(twm_window window) {
-	return twm_get_window_data(window)->x;
-}
+static inline void _twm_record_write(const void* data, int size) {
+	if (_twm_data.record.used + size > TWM_RECORD_BUFFER_SIZE) _twm_record_flush();
 
-int twm_window_y(twm_window window) {
-	return twm_get_window_data(window)->y;
+	memcpy(_twm_data.record.buffer + _twm_data.record.used, data, size);
+	_twm_data.record.used += size;
 }
 
-void twm_window_position(twm_window window, int* x, int* y) {
-	twm_window_data* data = twm_get_window_data(window);
-	*x = data->x;
-	*y = data->y;
-}
+static inline void _twm_record_events(const twm_event* events, int count) {
+	if (!_twm_data.record.file) return;
 
-void twm_window_rect(twm_window window, twm_rect* rect) {
-	twm_window_data* data = twm_get_window_data(window);
-	rect->x = data->x;
-	rect->y = data->y;
-	rect->width = data->width;
-	rect->height = data->height;
-}
+	for (int i = 0; i < count; i++) {
+		const twm_event* evt = &events[i];
+		int size = _twm_record_payload_size(evt->type);
 
-void twm_title_window(twm_window window, const char * title) {
-	SetWindowText(window, title);
-}
+		if (size < 0) continue;
 
-bool twm_window_was_closed(twm_window window) {
-	twm_window_data* data = twm_get_window_data(window);
+		unsigned char entry[TWM_RECORD_ENTRY_SIZE];
+		unsigned short type = (unsigned short)evt->type, payload = (unsigned short)size;
+		unsigned int server_time = (unsigned int)evt->common.server_time;
+		long long time = (long long)((evt->common.time - _twm_data.record.start) * 1000000000.0);
 
-	if (!data->was_closed) return false;
-	
-	data->was_closed = false;
+		memcpy(entry, &type, 2);
+		memcpy(entry + 2, &payload, 2);
+		memcpy(entry + 4, &server_time, 4);
+		memcpy(entry + 8, &time, 8);
 
-	return true;
+		_twm_record_write(entry, TWM_RECORD_ENTRY_SIZE);
+		_twm_record_write((const unsigned char*)evt + sizeof(twm_common_event), size);
+	}
 }
 
-bool twm_window_was_resized(twm_window window, int * width, int * height) {
-	twm_window_data* data = twm_get_window_data(window);
+bool twm_record_begin(const char* path) {
+	twm_record_end();
 
-	if (!data->was_resized) return false;
+	_twm_data.record.file = fopen(path, "wb");
 
-	data->was_resized = false;
+	if (!_twm_data.record.file) return false;
 
-	*width = data->width;
-	*height = data->height;
+	unsigned char header[TWM_RECORD_HEADER_SIZE];
+	unsigned short version = TWM_RECORD_VERSION, size = (unsigned short)sizeof(twm_event);
+
+	memcpy(header, TWM_RECORD_MAGIC, 4);
+	memcpy(header + 4, &version, 2);
+	memcpy(header + 6, &size, 2);
+
+	_twm_data.record.used = 0;
+	_twm_data.record.start = twm_time();
+
+	_twm_record_write(header, TWM_RECORD_HEADER_SIZE);
 
 	return true;
 }
 
-void twm_window_borderless(twm_window window, bool enable) {
-	twm_window_data* data = twm_get_window_data(window);
-
-	data->disable_events = TRUE;
+void twm_record_end() {
+	if (!_twm_data.record.file) return;
 
-	RECT clientRect;
-	GetClientRect(window, &clientRect);
+	_twm_record_flush();
 
-	POINT topLeft = { 0, 0 };
-	ClientToScreen(window, &topLeft);
+	fclose(_twm_data.record.file);
+	_twm_data.record.file = NULL;
+}
 
-	if (enable) {
-		LONG style = GetWindowLong(window, GWL_STYLE);
-		style &= ~(WS_CAPTION | WS_THICKFRAME | WS_OVERLAPPEDWINDOW);
-		style |= WS_POPUP;
-		SetWindowLong(window, GWL_STYLE, style);
+// A speed of 1 keeps the original timing, 2 plays twice as fast and 0 or less delivers events as fast as they are read.
+// Window events are retargeted to the given window unless it is TWM_NULL, recorded handles mean nothing in a new session
+bool twm_replay_begin(const char* path, twm_window window, double speed) {
+	twm_replay_end();
 
-		LONG exStyle = GetWindowLong(window, GWL_EXSTYLE);
-		exStyle &= ~(WS_EX_DLGMODALFRAME | WS_EX_WINDOWEDGE | WS_EX_CLIENTEDGE | WS_EX_STATICEDGE);
-		exStyle |= WS_EX_APPWINDOW;
-		SetWindowLong(window, GWL_EXSTYLE, exStyle);
+	const unsigned char* data = NULL;
+	size_t size = 0;
 
-		data->x = topLeft.x;
-		data->y = topLeft.y;
-		data->width = clientRect.right - clientRect.left;
-		data->height = clientRect.bottom - clientRect.top;
-		data->flags |= TWM_WINDOW_BORDERLESS;
-	}
-	else {
-		SetWindowLong(window, GWL_STYLE, data->style);
+	#if defined(TWM_WIN32)
+		HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
 
-		LONG exStyle = GetWindowLong(window, GWL_EXSTYLE);
-		exStyle |= (WS_EX_APPWINDOW);
-		SetWindowLong(window, GWL_EXSTYLE, exStyle);
+		if (file == INVALID_HANDLE_VALUE) return false;
 
-		RECT windowRect = { 0, 0, clientRect.right - clientRect.left, clientRect.bottom - clientRect.top };
-		AdjustWindowRectEx(&windowRect, data->style, FALSE, exStyle);
+		LARGE_INTEGER file_size;
+		HANDLE mapping = NULL;
 
-		data->x = topLeft.x + windowRect.left;
-		data->y = topLeft.y + windowRect.top;
-		data->width = windowRect.right - windowRect.left;
-		data->height = windowRect.bottom - windowRect.top;
-		data->flags &= ~TWM_WINDOW_BORDERLESS;
-	}
+		if (GetFileSizeEx(file, &file_size) && file_size.QuadPart >= TWM_RECORD_HEADER_SIZE) {
+			mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		}
 
-	SetWindowPos(window, NULL, data->x, data->y, data->width, data->height, SWP_NOZORDER | SWP_NOACTIVATE | SWP_FRAMECHANGED | SWP_SHOWWINDOW);
+		if (mapping) data = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
 
-	data->disable_events = FALSE;
-}
+		if (!data) {
+			if (mapping) CloseHandle(mapping);
+			CloseHandle(file);
 
-bool twm_window_is_borderless(twm_window window) {
-	return twm_get_window_data(window)->flags & TWM_WINDOW_BORDERLESS;
-}
+			return false;
+		}
 
-void twm_window_fullscreen(twm_window window, bool enable) {
-	twm_window_borderless(window, enable);
+		size = (size_t)file_size.QuadPart;
 
-	HMONITOR monitor = MonitorFromWindow(window, MONITOR_DEFAULTTONEAREST);
-	MONITORINFO mi = { .cbSize = sizeof(mi) };
-	GetMonitorInfo(monitor, &mi);
+		_twm_data.replay.file = file;
+		_twm_data.replay.mapping = mapping;
+	#else
+		int fd = open(path, O_RDONLY);
 
-	twm_window_data* data = twm_get_window_data(window);
+		if (fd < 0) return false;
 
-	if (enable) {
-		data->original_rect = (RECT){ data->x, data->y, data->x + data->width, data->y + data->height };
+		struct stat st;
 
-		SetWindowPos(window, HWND_TOP,
-			mi.rcMonitor.left, mi.rcMonitor.top,
-			mi.rcMonitor.right - mi.rcMonitor.left,
-			mi.rcMonitor.bottom - mi.rcMonitor.top,
-			SWP_NOOWNERZORDER | SWP_FRAMECHANGED);
+		if (fstat(fd, &st) == 0 && st.st_size >= TWM_RECORD_HEADER_SIZE) {
+			void* mapped = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
 
-		data->flags |= TWM_WINDOW_FULLSCREEN;
-	}
-	else {
-		AdjustWindowRectEx(&data->original_rect, GetWindowLong(window, GWL_STYLE), FALSE, GetWindowLong(window, GWL_EXSTYLE));
+			if (mapped != MAP_FAILED) {
+				data = (const unsigned char*)mapped;
+				size = (size_t)st.st_size;
+			}
+		}
 
-		SetWindowPos(window, HWND_TOP,
-			data->original_rect.left, data->original_rect.top,
-			data->original_rect.right - data->original_rect.left,
-			data->original_rect.bottom - data->original_rect.top,
-			SWP_NOOWNERZORDER | SWP_FRAMECHANGED);
+		close(fd);
 
-		data->flags &= ~TWM_WINDOW_FULLSCREEN;
-	}
-}
+		if (!data) return false;
+	#endif
 
-bool twm_window_is_fullscreen(twm_window window) {
-	return twm_get_window_data(window)->flags & TWM_WINDOW_FULLSCREEN;
-}
+	_twm_data.replay.data = data;
+	_twm_data.replay.size = size;
 
-void twm_set_window_ptr(twm_window window, void * ptr) {
-	twm_get_window_data(window)->ptr = ptr;
-}
+	unsigned short version, event_size;
+	memcpy(&version, data + 4, 2);
+	memcpy(&event_size, data + 6, 2);
 
-void * twm_get_window_ptr(twm_window window) {
-	return twm_get_window_data(window)->ptr;
-}
+	// Logs store raw event structs, so they only replay on builds with the same layout
+	if (memcmp(data, TWM_RECORD_MAGIC, 4) != 0 || version != TWM_RECORD_VERSION || event_size != sizeof(twm_event)) {
+		twm_replay_end();
 
-void twm_set_window_property(twm_window window, const char * name, int size, const void* value) {
-	void* data = (void*)GetProp(window, name);
-	if (!data) {
-		data = malloc(size);
+		return false;
 	}
 
-	memcpy(data, value, size);
+	_twm_data.replay.offset = TWM_RECORD_HEADER_SIZE;
+	_twm_data.replay.start = twm_time();
+	_twm_data.replay.speed = speed;
+	_twm_data.replay.window = window;
 
-	SetProp(window, name, (HANDLE)data);
+	return true;
 }
 
-bool twm_get_window_property(twm_window window, const char * name, int size, void* value) {
-	void* data = (void*)GetProp(window, name);
-	if (!data) return 0;
-
-	memcpy(value, data, size);
-
-	return 1;
-}
+void twm_replay_end() {
+	if (!_twm_data.replay.data) return;
 
-void twm_free_window_property(twm_window window, const char* name) {
-	void* data = (void*)GetProp(window, name);
-	if (!data) return;
+	#if defined(TWM_WIN32)
+		UnmapViewOfFile(_twm_data.replay.data);
+		CloseHandle(_twm_data.replay.mapping);
+		CloseHandle(_twm_data.replay.file);
+	#else
+		munmap((void*)_twm_data.replay.data, _twm_data.replay.size);
+	#endif
 
-	free(data);
+	_twm_data.replay.data = NULL;
 }
 
-void twm_cursor_position(int* x, int* y) {
-	POINT p;
-	GetCursorPos(&p);
+// Returns the next recorded event once it is due, otherwise *due is the wait in seconds (negative when the log is done)
+static inline bool _twm_replay_pop(twm_event* evt, double* due) {
+	if (due) *due = -1.0;
 
-	*x = p.x;
-	*y = p.y;
-}
+	if (!_twm_data.replay.data) return false;
 
-void twm_move_cursor(int x, int y) {
-	SetCursorPos(x, y);
-}
+	if (_twm_data.replay.offset + TWM_RECORD_ENTRY_SIZE > _twm_data.replay.size) {
+		twm_replay_end();
 
-void twm_clip_cursor(twm_window window) {
-	_twm_data.clip = window;
-	
-	RECT clientRect;
-	GetClientRect(window, &clientRect);
-	POINT tl = { clientRect.left, clientRect.top };
-	POINT br = { clientRect.right, clientRect.bottom };
+		return false;
+	}
 
-	ClientToScreen(window, &tl);
-	ClientToScreen(window, &br);
+	const unsigned char* entry = _twm_data.replay.data + _twm_data.replay.offset;
+	unsigned short type, payload;
+	unsigned int server_time;
+	long long time;
 
-	RECT screenRect = { tl.x, tl.y, br.x, br.y };
-	ClipCursor(&screenRect);
-}
+	memcpy(&type, entry, 2);
+	memcpy(&payload, entry + 2, 2);
+	memcpy(&server_time, entry + 4, 4);
+	memcpy(&time, entry + 8, 8);
 
-void twm_unclip_cursor() {
-	_twm_data.clip = NULL;
-	
-	ClipCursor(NULL);
-}
+	// A record whose size does not match its type is corrupt or from another event layout
+	if (payload != _twm_record_payload_size((twm_event_type)type) || _twm_data.replay.offset + TWM_RECORD_ENTRY_SIZE + payload > _twm_data.replay.size) {
+		twm_replay_end();
 
-void twm_show_cursor(bool flag) {
-	if (flag) {
-		while (ShowCursor(true) < 0);
-	}
-	
-	else {
-		while (ShowCursor(false) >= 0);
+		return false;
 	}
-}
-
-bool twm_cursor_is_visible() {
-	CURSORINFO ci;
-	ci.cbSize = sizeof(CURSORINFO);
-	return GetCursorInfo(&ci)&& (ci.flags & CURSOR_SHOWING);
-}
 
-static inline unsigned short twm_resolve_key(WORD keyFlags, WPARAM wParam, LPARAM lParam) {
-	WORD vkCode = LOWORD(wParam);
-	WORD scanCode = LOBYTE(keyFlags);
+	if (_twm_data.replay.speed > 0.0) {
+		double wait = _twm_data.replay.start + time / 1000000000.0 / _twm_data.replay.speed - twm_time();
 
-	BOOL isExtendedKey = (keyFlags & KF_EXTENDED) == KF_EXTENDED;
+		if (wait > 0.0) {
+			if (due) *due = wait;
 
-	if (isExtendedKey) {
-		scanCode = MAKEWORD(scanCode, 0xE0);
+			return false;
+		}
 	}
 
-	if (vkCode == 0) {
-		vkCode = MapVirtualKey(scanCode, MAPVK_VSC_TO_VK_EX);
-	}
+	memset(evt, 0, sizeof(*evt));
+	memcpy((unsigned char*)evt + sizeof(twm_common_event), entry + TWM_RECORD_ENTRY_SIZE, payload);
 
-	switch (vkCode) {
-	case VK_SHIFT:
-		vkCode = (scanCode == MapVirtualKey(VK_LSHIFT, MAPVK_VK_TO_VSC)) ? VK_LSHIFT : VK_RSHIFT;
-		break;
+	evt->type = (twm_event_type)type;
+	evt->common.time = twm_time();
+	evt->common.server_time = server_time;
 
-	case VK_CONTROL:
-		vkCode = isExtendedKey ? VK_RCONTROL : VK_LCONTROL;
-		break;
+	if (_twm_data.replay.window) evt->window.window = _twm_data.replay.window;
 
-	case VK_MENU:
-		vkCode = isExtendedKey ? VK_RMENU : VK_LMENU;
-		break;
+	_twm_data.replay.offset += TWM_RECORD_ENTRY_SIZE + payload;
 
-	case VK_RETURN:
-		vkCode = isExtendedKey ? TWM_KEY_NUMPAD_ENTER : TWM_KEY_ENTER;
-		break;
-	}
+	_twm_apply_input_state(evt);
 
-	return vkCode;
+	return true;
 }
 
-static inline twm_keymod twm_get_keymods() {
-	twm_keymod mods = 0;
+#if defined(TWM_GL) && !defined(TWM_COCOA)
+	// Extension strings are space separated, so a plain strstr would match prefixes of longer names
+	static bool _twm_gl_has_extension(const char* extensions, const char* name) {
+		if (extensions == NULL) return false;
 
-	if (GetAsyncKeyState(VK_LSHIFT) & 0x8000)
-		mods |= TWM_KEYMOD_SHIFT | TWM_KEYMOD_LSHIFT;
-	if (GetAsyncKeyState(VK_RSHIFT) & 0x8000)
-		mods |= TWM_KEYMOD_SHIFT | TWM_KEYMOD_RSHIFT;
+		size_t length = strlen(name);
 
-	if (GetAsyncKeyState(VK_LCONTROL) & 0x8000)
-		mods |= TWM_KEYMOD_CTRL | TWM_KEYMOD_LCTRL;
-	if (GetAsyncKeyState(VK_RCONTROL) & 0x8000)
-		mods |= TWM_KEYMOD_CTRL | TWM_KEYMOD_RCTRL;
+		for (const char* found = strstr(extensions, name); found; found = strstr(found + length, name)) {
+			if ((found == extensions || found[-1] == ' ') && (found[length] == ' ' || found[length] == '\0')) return true;
+		}
 
-	if (GetAsyncKeyState(VK_LMENU) & 0x8000)
-		mods |= TWM_KEYMOD_ALT | TWM_KEYMOD_LALT;
-	if (GetAsyncKeyState(VK_RMENU) & 0x8000)
-		mods |= TWM_KEYMOD_ALT | TWM_KEYMOD_RALT;
+		return false;
+	}
+#endif
 
-	if (GetAsyncKeyState(VK_LWIN) & 0x8000)
-		mods |= TWM_KEYMOD_LWIN;
-	if (GetAsyncKeyState(VK_RWIN) & 0x8000)
-		mods |= TWM_KEYMOD_RWIN;
+// Implemented by each backend, the public versions wrap them with twm_stats timing and record/replay
+#if !defined(TWM_COCOA) || defined(__OBJC__)
+	static void _twm_platform_wait_event(twm_event* evt);
+	static int _twm_platform_wait_event_timeout(twm_event* evt, double seconds);
+	static int _twm_platform_peek_event(twm_event* evt);
+	static int _twm_platform_peek_events(twm_event* events, int max);
+#endif
 
-	if (GetAsyncKeyState(VK_APPS) & 0x8000)
-		mods |= TWM_KEYMOD_MENU;
+#if defined(TWM_WIN32)
 
-	if (GetKeyState(VK_NUMLOCK) & 0x1)
-		mods |= TWM_KEYMOD_NUMLOCK;
-	if (GetKeyState(VK_SCROLL) & 0x1)
-		mods |= TWM_KEYMOD_SCROLLLOCK;
-	if (GetKeyState(VK_CAPITAL) & 0x1)
-		mods |= TWM_KEYMOD_CAPSLOCK;
+twm_data _twm_data = { 0 };
 
-	return mods;
-}
+#define WM_WINDOW_CLOSE (WM_APP + 0xF0)
+#define WM_WINDOW_SIZE (WM_APP + 0xF1)
+#define WM_WINDOW_MOVE (WM_APP + 0xF2)
+#define WM_WINDOW_MAXIMIZE (WM_APP + 0xF3)
+#define WM_WINDOW_MINIMIZE (WM_APP + 0xF4)
+#define WM_WINDOW_RESTORE (WM_APP + 0xF5)
+#define WM_WINDOW_ACTIVE (WM_APP + 0xF6)
+#define WM_WINDOW_INACTIVE (WM_APP + 0xF7)
+#define WM_MOUSE_ENTER (WM_APP + 0xF8)
+#define WM_MOUSE_LEAVE (WM_APP + 0xF9)
 
-static inline int _twm_translate_event(MSG* msg, twm_event* evt) {
-	TranslateMessage(msg);
-	DispatchMessage(msg);
+typedef struct twm_window_data {
+	twm_window_flags flags;
+	unsigned long style;
+	BOOL dragging;
+	BOOL resizing;
+	POINT last_mouse;
+	RECT original_rect;
+	int resize_edge;
+	int last_state;
+	int width;
+	int height;
+	int x;
+	int y;
+	BOOL tracking_mouse;
+	BOOL disable_events;
+	BOOL was_closed;
+	BOOL was_resized;
+	void * ptr;
+} twm_window_data;
 
-	switch (msg->message)
-	{
-		case WM_INPUT:
-		{
-			UINT dwSize = sizeof(RAWINPUT);
-			static BYTE lpb[sizeof(RAWINPUT)];
+static LRESULT CALLBACK _twm_window_proc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
 
-			GetRawInputData((HRAWINPUT)msg->lParam, RID_INPUT, lpb, &dwSize, sizeof(RAWINPUTHEADER));
+#ifdef TWM_GL
 
-			RAWINPUT* raw = (RAWINPUT*)lpb;
+	#define WGL_DRAW_TO_WINDOW_ARB              0x2001
+	#define WGL_SUPPORT_OPENGL_ARB              0x2010
+	#define WGL_DOUBLE_BUFFER_ARB               0x2011
+	#define WGL_PIXEL_TYPE_ARB                  0x2013
+	#define WGL_COLOR_BITS_ARB                  0x2014
+	#define WGL_ALPHA_BITS_ARB					0x201B
+	#define WGL_DEPTH_BITS_ARB                  0x2022
+	#define WGL_STENCIL_BITS_ARB                0x2023
+	#define WGL_TYPE_RGBA_ARB                   0x202B
+	#define WGL_FRAMEBUFFER_SRGB_CAPABLE_ARB    0x20A9
+	#define WGL_SAMPLE_BUFFERS_ARB              0x2041
+	#define WGL_SAMPLES_ARB                     0x2042
 
-			if (raw->header.dwType == RIM_TYPEMOUSE)
-			{
-				LONG dx = raw->data.mouse.lLastX;
-				LONG dy = raw->data.mouse.lLastY;
+	#define WGL_CONTEXT_MAJOR_VERSION_ARB       0x2091
+	#define WGL_CONTEXT_MINOR_VERSION_ARB       0x2092
+	#define WGL_CONTEXT_PROFILE_MASK_ARB        0x9126
+	#define WGL_CONTEXT_CORE_PROFILE_BIT_ARB    0x00000001
+	#define WGL_CONTEXT_COMPATIBILITY_PROFILE_BIT_ARB 0x00000002
 
-				if (dx || dy) {
-					evt->type = TWM_EVENT_RAWMOUSE_MOVE;
-					evt->rawmouse.window = msg->hwnd;
-					evt->rawmouse.dx = _twm_data.mouse.dx = dx;
-					evt->rawmouse.dy = _twm_data.mouse.dy = dy;
+#endif
 
-					return 1;
-				}
-			}
-			break;
-		}
+static BOOL CALLBACK _twm_monitor_count_proc(HMONITOR hMonitor, HDC hdc, LPRECT lprcMonitor, LPARAM lParam) {
+	(*(int*)lParam)++;
 
-		case WM_WINDOW_CLOSE:
-		{
-			evt->type = TWM_EVENT_WINDOW_CLOSE;
-			evt->window.window = msg->hwnd;
+	return TRUE;
+}
 
-			return 1;
-		}
+static BOOL CALLBACK _twm_monitor_proc(HMONITOR hMonitor, HDC hdc, LPRECT lprcMonitor, LPARAM lParam) {
+	int* index = (int*)lParam;
+	
+	twm_screen* screen = &_twm_data.screen.screen[*index];
 
-		case WM_WINDOW_MOVE:
-		{
-			evt->type = TWM_EVENT_WINDOW_MOVE;
-			evt->window.window = msg->hwnd;
-			evt->window.x = (int)msg->wParam;
-			evt->window.y = (int)msg->lParam;
+	screen->hmonitor = hMonitor;
+	screen->x = lprcMonitor->left;
+	screen->y = lprcMonitor->top;
+	screen->width = lprcMonitor->right - lprcMonitor->left;
+	screen->height = lprcMonitor->bottom - lprcMonitor->top;
 
-			return 1;
-		}
+	MONITORINFOEX mi;
+	mi.cbSize = sizeof(mi);
 
-		case WM_WINDOW_SIZE:
-		{
-			evt->type = TWM_EVENT_WINDOW_SIZE;
-			evt->window.window = msg->hwnd;
-			evt->window.width = (int)msg->wParam;
-			evt->window.height = (int)msg->lParam;
+	if (GetMonitorInfo(hMonitor, (MONITORINFO*)&mi)) {
+		strncpy(screen->szDevice, mi.szDevice, sizeof(screen->szDevice));
 
-			return 1;
-		}
+		DISPLAY_DEVICE monitor = { .cb = sizeof(monitor) };
+		EnumDisplayDevices(mi.szDevice, 0, &monitor, 0);
 
-		case WM_WINDOW_MAXIMIZE:
-		{
-			evt->type = TWM_EVENT_WINDOW_MAXIMIZE;
-			evt->window.window = msg->hwnd;
-			evt->window.width = (int)msg->wParam;
-			evt->window.height = (int)msg->lParam;
+		strncpy(screen->name, monitor.DeviceString, sizeof(screen->name));
 
-			return 1;
-		}
+		DEVMODE currentDevMode = { 0 };
+		currentDevMode.dmSize = sizeof(DEVMODE);
 
-		case WM_WINDOW_MINIMIZE:
-		{
-			evt->type = TWM_EVENT_WINDOW_MINIMIZE;
-			evt->window.window = msg->hwnd;
-			evt->window.width = (int)msg->wParam;
-			evt->window.height = (int)msg->lParam;
+		EnumDisplaySettings(mi.szDevice, ENUM_CURRENT_SETTINGS, &currentDevMode);
 
-			return 1;
-		}
+		DEVMODE devMode = { 0 };
+		devMode.dmSize = sizeof(DEVMODE);
+		
+		screen->modes.count = 0;
+		while (EnumDisplaySettings(mi.szDevice, screen->modes.count, &devMode)) screen->modes.count++;
 
-		case WM_WINDOW_RESTORE:
-		{
-			evt->type = TWM_EVENT_WINDOW_RESTORE;
-			evt->window.window = msg->hwnd;
-			evt->window.width = (int)msg->wParam;
-			evt->window.height = (int)msg->lParam;
+		screen->modes.mode = (twm_screen_mode*)malloc(sizeof(twm_screen_mode) * screen->modes.count);
 
-			return 1;
-		}
+		int modeIndex = 0;
+		while (EnumDisplaySettings(mi.szDevice, modeIndex, &devMode)) {
+			twm_screen_mode* model = &screen->modes.mode[modeIndex];
+			
+			if (currentDevMode.dmPelsWidth == devMode.dmPelsWidth &&
+				currentDevMode.dmPelsHeight == devMode.dmPelsHeight &&
+				currentDevMode.dmBitsPerPel == devMode.dmBitsPerPel &&
+				currentDevMode.dmDisplayFrequency == devMode.dmDisplayFrequency &&
+				currentDevMode.dmDisplayFlags == devMode.dmDisplayFlags) {
+				screen->modes.current = modeIndex;
+			}
+			
+			memcpy(&model->devmode, &devMode, sizeof(devMode));
 
-		case WM_MOUSEHOVER:
-		{
-			evt->type = TWM_EVENT_MOUSE_ENTER;
-			evt->window.window = msg->hwnd;
+			model->width = devMode.dmPelsWidth;
+			model->height = devMode.dmPelsHeight;
+			model->bpp = devMode.dmBitsPerPel;
+			model->hz = devMode.dmDisplayFrequency;
+			model->refresh_rate = devMode.dmDisplayFrequency;
+			model->flags = (devMode.dmDisplayFlags & DM_INTERLACED) ? TWM_SCREEN_MODE_INTERLACED : 0;
 
-			return 1;
+			modeIndex++;
 		}
+	}
 
-		case WM_MOUSELEAVE:
-		{
-			evt->type = TWM_EVENT_MOUSE_LEAVE;
-			evt->window.window = msg->hwnd;
+	(*index)++;
 
-			memset(_twm_data.mouse.buttons, 0, sizeof(_twm_data.mouse.buttons));
+	return TRUE;
+}
 
-			return 1;
-		}
+int twm_init() {
+	timeBeginPeriod(1);
 
-		case WM_WINDOW_ACTIVE:
-		{
-			evt->type = TWM_EVENT_WINDOW_ACTIVE;
-			evt->window.window = msg->hwnd;
+	LARGE_INTEGER frequencyCounter;
+	QueryPerformanceFrequency(&frequencyCounter);
+	_twm_data.frequency = (double)frequencyCounter.QuadPart;
+	_twm_data.counter_frequency = frequencyCounter.QuadPart;
+	_twm_data.thread_id = GetCurrentThreadId();
 
-			return 1;
-		}
+	_twm_init_post_queue();
 
-		case WM_WINDOW_INACTIVE:
-		{
-			evt->type = TWM_EVENT_WINDOW_INACTIVE;
-			evt->window.window = msg->hwnd;
+	if (!SetProcessDpiAwarenessContext(DPI_AWARENESS_CONTEXT_PER_MONITOR_AWARE_V2)) {
+		if (FAILED(SetProcessDpiAwareness(PROCESS_PER_MONITOR_DPI_AWARE))) {
+			SetProcessDPIAware();
+		}
+	}
 
-			memset(_twm_data.mouse.buttons, 0, sizeof(_twm_data.mouse.buttons));
-			memset(_twm_data.keyboard.keys, 0, sizeof(_twm_data.keyboard.keys));
-			_twm_data.keyboard.modifiers = 0;
+	_twm_data.hInstance = GetModuleHandle(NULL);
 
-			return 1;
-		}
+	SetConsoleOutputCP(CP_UTF8);
+	SetConsoleCP(CP_UTF8);
 
-		case WM_MOUSEMOVE:
-		{
-			POINT pt = { GET_X_LPARAM(msg->lParam), GET_Y_LPARAM(msg->lParam) };
-			RECT clientRect;
-			GetClientRect(msg->hwnd, &clientRect);
+	EnumDisplayMonitors(NULL, NULL, _twm_monitor_count_proc, (LPARAM)&_twm_data.screen.count);
+	_twm_data.screen.screen = (twm_screen*)malloc(sizeof(twm_screen) * _twm_data.screen.count);
+	memset(_twm_data.screen.screen, 0, sizeof(twm_screen) * _twm_data.screen.count);
 
-			if (PtInRect(&clientRect, pt)) {
+	int screen_index = 0;
+	EnumDisplayMonitors(NULL, NULL, _twm_monitor_proc, (LPARAM)&screen_index);
 
-				evt->type = TWM_EVENT_MOUSE_MOVE;
-				evt->mouse.window = msg->hwnd;
-				evt->mouse.x = _twm_data.mouse.x = GET_X_LPARAM(msg->lParam);
-				evt->mouse.y = _twm_data.mouse.y = GET_Y_LPARAM(msg->lParam);
-				evt->mouse.z = 0;
-				evt->mouse.w = 0;
+	memset(&_twm_data.wndClass, 0, sizeof(_twm_data.wndClass));
 
-				return 1;
-			}
+	_twm_data.wndClass.cbSize = sizeof(WNDCLASSEX);
+	_twm_data.wndClass.style = CS_OWNDC;
+	_twm_data.wndClass.lpfnWndProc = &_twm_window_proc;
+	_twm_data.wndClass.hInstance = _twm_data.hInstance;
+	_twm_data.wndClass.hIcon = LoadIcon(NULL, IDI_APPLICATION);
+	_twm_data.wndClass.hIcon = LoadIcon(NULL, IDI_APPLICATION);
+	_twm_data.wndClass.hCursor = LoadCursor(NULL, IDC_ARROW);
+	_twm_data.wndClass.hbrBackground = (HBRUSH)GetStockObject(BLACK_BRUSH);
+	_twm_data.wndClass.lpszClassName = TEXT("twm_class");
 
-			break;
-		}
+	if (!RegisterClassEx(&_twm_data.wndClass))
+	{
+		return 0;
+	}
 
-		case WM_MOUSEWHEEL:
-		{
-			#define WHEEL_DELTA 120
+#ifdef TWM_GL
+	{
+		HWND hwnd = CreateWindowEx(0, TEXT("twm_class"), TEXT(""), WS_OVERLAPPEDWINDOW, 0, 0, 1, 1, NULL, NULL, _twm_data.hInstance, NULL);
 
-			evt->type = TWM_EVENT_MOUSE_WHEEL;
+		HDC hdc = GetDC(hwnd);
 
-			evt->mouse.x = GET_X_LPARAM(msg->lParam);
-			evt->mouse.y = GET_Y_LPARAM(msg->lParam);
-			evt->mouse.z = GET_WHEEL_DELTA_WPARAM(msg->wParam) / WHEEL_DELTA;
-			evt->mouse.w = 0;
+		PIXELFORMATDESCRIPTOR pfd = {
+			sizeof(PIXELFORMATDESCRIPTOR), 1,
+			PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL | PFD_DOUBLEBUFFER,
+			PFD_TYPE_RGBA, 32,
+			0, 0, 0, 0, 0, 0,
+			0, 0, 0, 0, 0, 0, 0,
+			24, 8, 0,
+			PFD_MAIN_PLANE, 0, 0, 0, 0
+		};
 
-			return 1;
-		}
+		int pf = ChoosePixelFormat(hdc, &pfd);
+		SetPixelFormat(hdc, pf, &pfd);
+		HGLRC temp_context = wglCreateContext(hdc);
+		wglMakeCurrent(hdc, temp_context);
 
-		case WM_MOUSEHWHEEL:
-		{
-			#define WHEEL_DELTA 120
+		_twm_data.wglChoosePixelFormatARB = (PFNWGLCHOOSEPIXELFORMATARBPROC) wglGetProcAddress("wglChoosePixelFormatARB");
+		_twm_data.wglCreateContextAttribsARB = (PFNWGLCREATECONTEXTATTRIBSARBPROC) wglGetProcAddress("wglCreateContextAttribsARB");
+		_twm_data.wglSwapIntervalEXT = (PFNWGLSWAPINTERVALEXTPROC) wglGetProcAddress("wglSwapIntervalEXT");
+		_twm_data.wglGetSwapIntervalEXT = (PFNWGLGETSWAPINTERVALEXTPROC)wglGetProcAddress("wglGetSwapIntervalEXT");;
 
-			evt->type = TWM_EVENT_MOUSE_WHEEL;
+		PFNWGLGETEXTENSIONSSTRINGARBPROC wglGetExtensionsStringARB = (PFNWGLGETEXTENSIONSSTRINGARBPROC)wglGetProcAddress("wglGetExtensionsStringARB");
+		const char* extensions = wglGetExtensionsStringARB ? wglGetExtensionsStringARB(hdc) : NULL;
 
-			evt->mouse.x = GET_X_LPARAM(msg->lParam);
-			evt->mouse.y = GET_Y_LPARAM(msg->lParam);
-			evt->mouse.w = GET_WHEEL_DELTA_WPARAM(msg->wParam) / WHEEL_DELTA;
-			evt->mouse.z = 0;
+		_twm_data.swap_control_tear = _twm_gl_has_extension(extensions, "WGL_EXT_swap_control_tear");
 
-			return 1;
+		if (_twm_gl_has_extension(extensions, "WGL_OML_sync_control")) {
+			_twm_data.wglGetSyncValuesOML = (PFNWGLGETSYNCVALUESOMLPROC)wglGetProcAddress("wglGetSyncValuesOML");
+			_twm_data.wglSwapBuffersMscOML = (PFNWGLSWAPBUFFERSMSCOMLPROC)wglGetProcAddress("wglSwapBuffersMscOML");
+			_twm_data.wglWaitForSbcOML = (PFNWGLWAITFORSBCOMLPROC)wglGetProcAddress("wglWaitForSbcOML");
 		}
 
-		case WM_LBUTTONDOWN:
-		{
-			POINT pt = { GET_X_LPARAM(msg->lParam), GET_Y_LPARAM(msg->lParam) };
-			RECT clientRect;
-			GetClientRect(msg->hwnd, &clientRect);
+		wglMakeCurrent(NULL, NULL);
+		wglDeleteContext(temp_context);
 
-			if (PtInRect(&clientRect, pt)) {
-				evt->type = TWM_EVENT_MOUSE_DOWN;
-				evt->mouse.window = msg->hwnd;
-				evt->mouse.button = TWM_MB_LEFT;
-				evt->mouse.x = pt.x;
-				evt->mouse.y = pt.y;
-				evt->mouse.z = 0;
-				evt->mouse.w = 0;
+		ReleaseDC(hwnd, hdc);
+		DestroyWindow(hwnd);
 
-				_twm_data.mouse.buttons[evt->mouse.button] = true;
+		int pixel_attribs[] = {
+			WGL_DRAW_TO_WINDOW_ARB, 1,
+			WGL_SUPPORT_OPENGL_ARB, 1,
+			WGL_PIXEL_TYPE_ARB, WGL_TYPE_RGBA_ARB,
+			WGL_DOUBLE_BUFFER_ARB, 1,
+			WGL_COLOR_BITS_ARB, 32,
+			WGL_ALPHA_BITS_ARB, 8,
+			WGL_DEPTH_BITS_ARB, 24,
+			WGL_STENCIL_BITS_ARB, 8,
+			WGL_FRAMEBUFFER_SRGB_CAPABLE_ARB, 1,
+			WGL_SAMPLE_BUFFERS_ARB, 0,
+			WGL_SAMPLES_ARB, 1,
+			0
+		};
 
-				return 1;
-			}
+		memcpy(_twm_data.pixel_attribs, pixel_attribs, sizeof(pixel_attribs));
+	}
+#endif
 
-			break;
-		}
+	return 1;
+}
 
-		case WM_MBUTTONDOWN:
-		{
-			POINT pt = { GET_X_LPARAM(msg->lParam), GET_Y_LPARAM(msg->lParam) };
-			RECT clientRect;
-			GetClientRect(msg->hwnd, &clientRect);
+void twm_finalize() {
+	twm_record_end();
+	twm_replay_end();
 
-			if (PtInRect(&clientRect, pt)) {
-				evt->type = TWM_EVENT_MOUSE_DOWN;
-				evt->mouse.window = msg->hwnd;
-				evt->mouse.button = TWM_MB_MIDDLE;
-				evt->mouse.x = pt.x;
-				evt->mouse.y = pt.y;
-				evt->mouse.z = 0;
-				evt->mouse.w = 0;
+	for (int i = 0; i < _twm_data.screen.count; i++) {
+		free(_twm_data.screen.screen[i].modes.mode);
+	}
+	free(_twm_data.screen.screen);
+	
+	UnregisterClass(_twm_data.wndClass.lpszClassName, _twm_data.hInstance);
 
-				_twm_data.mouse.buttons[evt->mouse.button] = true;
+	timeEndPeriod(1);
+}
 
-				return 1;
-			}
+bool twm_change_screen_mode(int screen_index, int mode_index) {
+	if (screen_index < 0 || screen_index >= _twm_data.screen.count || mode_index < 0) return false;
 
-			break;
-		}
+	twm_screen* screen = &_twm_data.screen.screen[screen_index];
 
-		case WM_RBUTTONDOWN:
-		{
-			POINT pt = { GET_X_LPARAM(msg->lParam), GET_Y_LPARAM(msg->lParam) };
-			RECT clientRect;
-			GetClientRect(msg->hwnd, &clientRect);
+	if (mode_index >= screen->modes.count) return false;
 
-			if (PtInRect(&clientRect, pt)) {
-				evt->type = TWM_EVENT_MOUSE_DOWN;
-				evt->mouse.window = msg->hwnd;
-				evt->mouse.button = TWM_MB_RIGHT;
-				evt->mouse.x = pt.x;
-				evt->mouse.y = pt.y;
-				evt->mouse.z = 0;
-				evt->mouse.w = 0;
+	if (ChangeDisplaySettingsEx(screen->szDevice, &screen->modes.mode[mode_index].devmode, NULL, CDS_FULLSCREEN, NULL) != DISP_CHANGE_SUCCESSFUL) return false;
 
-				_twm_data.mouse.buttons[evt->mouse.button] = true;
+	screen->modes.current = mode_index;
 
-				return 1;
-			}
+	return true;
+}
 
-			break;
-		}
+twm_window twm_create_window(const char* title, int x, int y, int width, int height, twm_window_flags flags) {
+	int screen = twm_screen_from_cursor();
+	twm_rect screen_rect;
+	twm_screen_rect(screen, &screen_rect);
 
-		case WM_XBUTTONDOWN:
-		{
-			POINT pt = { GET_X_LPARAM(msg->lParam), GET_Y_LPARAM(msg->lParam) };
-			RECT clientRect;
-			GetClientRect(msg->hwnd, &clientRect);
+	LONG style = WS_OVERLAPPED | WS_CAPTION | WS_SYSMENU | WS_MINIMIZEBOX;
 
-			if (PtInRect(&clientRect, pt)) {
-				WORD xbtn = GET_XBUTTON_WPARAM(msg->wParam);
+	if (flags & TWM_WINDOW_RESIZABLE && !(flags & TWM_WINDOW_BORDERLESS)) {
+		style |= WS_THICKFRAME | WS_MAXIMIZEBOX;
+	}
 
-				evt->type = TWM_EVENT_MOUSE_DOWN;
-				evt->mouse.window = msg->hwnd;
-				evt->mouse.button = (twm_mouse_button)(TWM_MB_X1 - 1 + xbtn);
-				evt->mouse.x = pt.x;
-				evt->mouse.y = pt.y;
-				evt->mouse.z = 0;
-				evt->mouse.w = 0;
+	RECT rc = { 0, 0, width, height };
+	AdjustWindowRectEx(&rc, (flags & TWM_WINDOW_BORDERLESS) ? WS_POPUP : WS_OVERLAPPEDWINDOW, 0, WS_EX_APPWINDOW);
 
-				_twm_data.mouse.buttons[evt->mouse.button] = true;
+	twm_window_data* data = (twm_window_data*)malloc(sizeof(twm_window_data));
+	if (data == NULL) return NULL;
 
-				return 1;
-			}
+	memset(data, 0, sizeof(twm_window_data));
 
-			break;
-		}
+	data->flags = flags;
+	data->style = style;
+	data->width = width;
+	data->height = height;
 
-		case WM_LBUTTONUP:
-		{
-			POINT pt = { GET_X_LPARAM(msg->lParam), GET_Y_LPARAM(msg->lParam) };
-			RECT clientRect;
-			GetClientRect(msg->hwnd, &clientRect);
+	auto bw = rc.right - rc.left;
+	auto bh = rc.bottom - rc.top;
 
-			if (PtInRect(&clientRect, pt) || twm_mb_state(TWM_MB_LEFT)) {
-				evt->type = TWM_EVENT_MOUSE_UP;
-				evt->mouse.window = msg->hwnd;
-				evt->mouse.button = TWM_MB_LEFT;
-				evt->mouse.x = pt.x;
-				evt->mouse.y = pt.y;
-				evt->mouse.z = 0;
-				evt->mouse.w = 0;
+	data->x = x == TWM_CENTER ? (screen_rect.x + (screen_rect.width - bw)) >> 1 : x;
+	data->y = y == TWM_CENTER ? (screen_rect.y + (screen_rect.height - bh)) >> 1 : y;
 
-				_twm_data.mouse.buttons[evt->mouse.button] = false;
+	HWND hwnd = CreateWindowEx
+	(
+		0, _twm_data.wndClass.lpszClassName, title, style,
+		data->x, data->y, bw, bh,
+		HWND_DESKTOP, NULL, _twm_data.hInstance, NULL
+	);
 
-				return 1;
-			}
+	if (hwnd == NULL) return NULL;
 
-			break;
-		}
+	BOOL dark = TRUE;
+	DwmSetWindowAttribute(hwnd, DWMWA_USE_IMMERSIVE_DARK_MODE, &dark, sizeof(dark));
 
-		case WM_MBUTTONUP:
-		{
-			POINT pt = { GET_X_LPARAM(msg->lParam), GET_Y_LPARAM(msg->lParam) };
-			RECT clientRect;
-			GetClientRect(msg->hwnd, &clientRect);
+	DWORD corner = 2; // DWMWCP_ROUND
+	DwmSetWindowAttribute(hwnd, DWMWA_WINDOW_CORNER_PREFERENCE, &corner, sizeof(corner));
 
-			if (PtInRect(&clientRect, pt) || twm_mb_state(TWM_MB_MIDDLE)) {
-				evt->type = TWM_EVENT_MOUSE_UP;
-				evt->mouse.window = msg->hwnd;
-				evt->mouse.button = TWM_MB_MIDDLE;
-				evt->mouse.x = pt.x;
-				evt->mouse.y = pt.y;
-				evt->mouse.z = 0;
-				evt->mouse.w = 0;
+	DWORD backdrop = 2; // Mica
+	DwmSetWindowAttribute(hwnd, DWMWA_SYSTEMBACKDROP_TYPE, &backdrop, sizeof(backdrop));
 
-				_twm_data.mouse.buttons[evt->mouse.button] = false;
+	// Fix Flickering on switch to borderless
+	SetWindowLong(hwnd, GWL_STYLE, WS_POPUP);
+	SetWindowLong(hwnd, GWL_EXSTYLE, 0);
 
-				return 1;
-			}
+	SetWindowPos(hwnd, NULL, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE | SWP_NOZORDER | SWP_FRAMECHANGED);
 
-			break;
-		}
+	if (!(flags & TWM_WINDOW_BORDERLESS)) {
+		SetWindowLong(hwnd, GWL_STYLE, style);
+		SetWindowLong(hwnd, GWL_EXSTYLE, WS_EX_APPWINDOW);
+		SetWindowPos(hwnd, NULL, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE | SWP_NOZORDER | SWP_FRAMECHANGED);
+	}
 
-		case WM_XBUTTONUP:
-		{
-			POINT pt = { GET_X_LPARAM(msg->lParam), GET_Y_LPARAM(msg->lParam) };
-			RECT clientRect;
-			GetClientRect(msg->hwnd, &clientRect);
+	SetWindowLongPtr(hwnd, GWLP_USERDATA, (LONG_PTR)data);
 
-			WORD xbtn = GET_XBUTTON_WPARAM(msg->wParam);
-			twm_mouse_button button = (twm_mouse_button)(TWM_MB_X1 - 1 + xbtn);
+	RAWINPUTDEVICE Rid[1];
+	Rid[0].usUsagePage = HID_USAGE_PAGE_GENERIC;
+	Rid[0].usUsage = HID_USAGE_GENERIC_MOUSE;
+	Rid[0].dwFlags = RIDEV_INPUTSINK;
+	Rid[0].hwndTarget = hwnd;
+	RegisterRawInputDevices(Rid, 1, sizeof(Rid[0]));
 
-			if (PtInRect(&clientRect, pt) || twm_mb_state(TWM_MB_MIDDLE)) {
-				evt->type = TWM_EVENT_MOUSE_UP;
-				evt->mouse.window = msg->hwnd;
-				evt->mouse.button = button;
-				evt->mouse.x = pt.x;
-				evt->mouse.y = pt.y;
-				evt->mouse.z = 0;
-				evt->mouse.w = 0;
+	return hwnd;
+}
 
-				_twm_data.mouse.buttons[evt->mouse.button] = false;
+static inline twm_window_data* twm_get_window_data(twm_window window) {
+	return (twm_window_data*)GetWindowLongPtr(window, GWLP_USERDATA);
+}
 
-				return 1;
-			}
+void twm_destroy_window(twm_window window) {
+	twm_window_data* data = twm_get_window_data(window);
 
-			break;
-		}
-
-		case WM_RBUTTONUP:
-		{
-			POINT pt = { GET_X_LPARAM(msg->lParam), GET_Y_LPARAM(msg->lParam) };
-			RECT clientRect;
-			GetClientRect(msg->hwnd, &clientRect);
+	DestroyWindow(window);
+	free(data);
+}
 
-			if (PtInRect(&clientRect, pt) || twm_mb_state(TWM_MB_RIGHT)) {
-				evt->type = TWM_EVENT_MOUSE_UP;
-				evt->mouse.window = msg->hwnd;
-				evt->mouse.button = TWM_MB_RIGHT;
-				evt->mouse.x = pt.x;
-				evt->mouse.y = pt.y;
-				evt->mouse.z = 0;
-				evt->mouse.w = 0;
+void twm_show_window(twm_window window, bool visible) {
+	ShowWindow(window, visible ? SW_SHOW : SW_HIDE);
+}
 
-				_twm_data.mouse.buttons[evt->mouse.button] = false;
+bool twm_window_is_visible(twm_window window) {
+	return IsWindowVisible(window);
+}
 
-				return 1;
-			}
+void twm_move_window(twm_window window, int x, int y, int width, int height) {
+	twm_window_data* data = twm_get_window_data(window);
+	
+	int new_x = x, new_y = y;
+	int new_width = width, new_height = height;
 
-			break;
-		}
+	if (x == TWM_CURRENT || x == TWM_CENTER) new_x = data->x;
+	if (y == TWM_CURRENT || y == TWM_CENTER) new_y = data->y;
 
-		case WM_SYSKEYDOWN:
-		case WM_KEYDOWN: {
-			WORD keyFlags = HIWORD(msg->lParam);
+	int screen = twm_screen_from_position(new_x, new_y);
+	twm_rect screen_rect;
+	twm_screen_rect(screen, &screen_rect);
 
-			BOOL wasKeyDown = (keyFlags & KF_REPEAT) == KF_REPEAT;
+	if (width == TWM_CURRENT || width == TWM_STRETCH) new_width = data->width;
+	if (height == TWM_CURRENT || height == TWM_STRETCH) new_height = data->height;
 
-			if (wasKeyDown) return 0;
+	RECT rc = { 0, 0, new_width, new_height };
+	AdjustWindowRectEx(&rc, GetWindowLong(window, GWL_STYLE), FALSE, GetWindowLong(window, GWL_EXSTYLE));
 
-			unsigned short vkCode = twm_resolve_key(keyFlags, msg->wParam, msg->lParam);
+	new_width = rc.right - rc.left;
+	new_height = rc.bottom - rc.top;
 
-			if (vkCode == VK_LCONTROL && GetAsyncKeyState(VK_RMENU) & 0x8000) return 0;
+	if (width == TWM_STRETCH) new_width = screen_rect.width - new_x - rc.left;
+	if (height == TWM_STRETCH) new_height = screen_rect.height - new_y - rc.top;
 
-			evt->type = TWM_EVENT_KEY_DOWN;
-			evt->keyboard.window = msg->hwnd;
-			evt->keyboard.key = vkCode;
-			evt->keyboard.modifiers = _twm_data.keyboard.modifiers = twm_get_keymods();
+	if (x == TWM_CENTER) new_x = (screen_rect.x + (screen_rect.width - new_width)) >> 1;
+	if (y == TWM_CENTER) new_y = (screen_rect.y + (screen_rect.height - new_height)) >> 1;
 
-			_twm_data.keyboard.keys[vkCode] = true;
+	SetWindowPos(window, NULL, new_x, new_y, new_width, new_height, SWP_NOZORDER | SWP_NOACTIVATE | SWP_FRAMECHANGED);
 
-			return 1;
-		}
+	data->x = new_x;
+	data->y = new_y;
+}
 
-		case WM_SYSKEYUP:
-		case WM_KEYUP: {
-			unsigned short vkCode = twm_resolve_key(HIWORD(msg->lParam), msg->wParam, msg->lParam);
+int twm_window_width(twm_window window) {
+	return twm_get_window_data(window)->width;
+}
 
-			if (vkCode == VK_LCONTROL && GetAsyncKeyState(VK_RMENU)) return 0;
+int twm_window_height(twm_window window) {
+	return twm_get_window_data(window)->height;
+}
 
-			evt->type = TWM_EVENT_KEY_UP;
-			evt->keyboard.window = msg->hwnd;
-			evt->keyboard.key = vkCode;
-			evt->keyboard.modifiers = _twm_data.keyboard.modifiers = twm_get_keymods();
+void twm_window_size(twm_window window, int* width, int* height) {
+	twm_window_data* data = twm_get_window_data(window);
+	*width = data->width;
+	*height = data->height;
+}
 
-			_twm_data.keyboard.keys[vkCode] = false;
+int twm_window_x(twm_window window) {
+	return twm_get_window_data(window)->x;
+}
 
-			return 1;
-		}
+int twm_window_y(twm_window window) {
+	return twm_get_window_data(window)->y;
+}
 
-		case WM_SYSCHAR:
-		case WM_CHAR: {
-			evt->type = TWM_EVENT_KEY_CHAR;
-			evt->keyboard.window = msg->hwnd;
-			evt->keyboard.key = twm_resolve_key(HIWORD(msg->lParam), msg->wParam, msg->lParam);
-			evt->keyboard.modifiers = twm_get_keymods();
+void twm_window_position(twm_window window, int* x, int* y) {
+	twm_window_data* data = twm_get_window_data(window);
+	*x = data->x;
+	*y = data->y;
+}
 
-			wchar_t wstr = (wchar_t)msg->wParam;
+void twm_window_rect(twm_window window, twm_rect* rect) {
+	twm_window_data* data = twm_get_window_data(window);
+	rect->x = data->x;
+	rect->y = data->y;
+	rect->width = data->width;
+	rect->height = data->height;
+}
 
-			if (wstr) {
-				WideCharToMultiByte(CP_UTF8, 0, &wstr, -1, evt->keyboard.chr, 2, NULL, NULL);
-			}
+void twm_title_window(twm_window window, const char * title) {
+	SetWindowText(window, title);
+}
 
-			return 1;
-		}
+bool twm_window_was_closed(twm_window window) {
+	twm_window_data* data = twm_get_window_data(window);
 
-		default:
-			break;
-	}
+	if (!data->was_closed) return false;
+	
+	data->was_closed = false;
 
-	return 0;
+	return true;
 }
 
-void twm_wait_event(twm_event* evt) {
-	MSG msg;
-	while (GetMessage(&msg, NULL, 0, 0)) {
-		if (_twm_translate_event(&msg, evt)) return;
-	}
-}
+bool twm_window_was_resized(twm_window window, int * width, int * height) {
+	twm_window_data* data = twm_get_window_data(window);
 
-int twm_peek_event(twm_event* evt) {
-	MSG msg;
-	while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE)) {
-		if (_twm_translate_event(&msg, evt)) return 1;
-	}
+	if (!data->was_resized) return false;
 
-	return 0;
+	data->was_resized = false;
+
+	*width = data->width;
+	*height = data->height;
+
+	return true;
 }
 
-LRESULT CALLBACK _twm_window_proc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
-	twm_window_data* data = twm_get_window_data(hWnd);
+void twm_window_borderless(twm_window window, bool enable) {
+	twm_window_data* data = twm_get_window_data(window);
 
-	switch (uMsg) {
-	case WM_ACTIVATE: {
-		WORD state = LOWORD(wParam);
+	data->disable_events = TRUE;
 
-		if (state == WA_ACTIVE || state == WA_CLICKACTIVE) {
-			if (!IsIconic(hWnd)) {
-				PostMessage(hWnd, WM_WINDOW_ACTIVE, wParam, lParam);
-			}
-		}
-		else if (state == WA_INACTIVE) {
-			PostMessage(hWnd, WM_WINDOW_INACTIVE, wParam, lParam);
-		}
-		break;
-	}
+	RECT clientRect;
+	GetClientRect(window, &clientRect);
 
-	case WM_NCHITTEST: {
-		if (!(data->flags & TWM_WINDOW_RESIZABLE) || _twm_data.clip != NULL) break;
+	POINT topLeft = { 0, 0 };
+	ClientToScreen(window, &topLeft);
 
-		POINT pt = { GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam) };
-		ScreenToClient(hWnd, &pt);
+	if (enable) {
+		LONG style = GetWindowLong(window, GWL_STYLE);
+		style &= ~(WS_CAPTION | WS_THICKFRAME | WS_OVERLAPPEDWINDOW);
+		style |= WS_POPUP;
+		SetWindowLong(window, GWL_STYLE, style);
 
-		RECT rc;
-		GetClientRect(hWnd, &rc);
+		LONG exStyle = GetWindowLong(window, GWL_EXSTYLE);
+		exStyle &= ~(WS_EX_DLGMODALFRAME | WS_EX_WINDOWEDGE | WS_EX_CLIENTEDGE | WS_EX_STATICEDGE);
+		exStyle |= WS_EX_APPWINDOW;
+		SetWindowLong(window, GWL_EXSTYLE, exStyle);
 
-		int borderX = GetSystemMetrics(SM_CXSIZEFRAME);
-		int borderY = GetSystemMetrics(SM_CYSIZEFRAME);
+		data->x = topLeft.x;
+		data->y = topLeft.y;
+		data->width = clientRect.right - clientRect.left;
+		data->height = clientRect.bottom - clientRect.top;
+		data->flags |= TWM_WINDOW_BORDERLESS;
+	}
+	else {
+		SetWindowLong(window, GWL_STYLE, data->style);
 
-		if (pt.y < borderY && pt.x < borderX) return HTTOPLEFT;
-		if (pt.y < borderY && pt.x > rc.right - borderX) return HTTOPRIGHT;
-		if (pt.y > rc.bottom - borderY && pt.x < borderX) return HTBOTTOMLEFT;
-		if (pt.y > rc.bottom - borderY && pt.x > rc.right - borderX) return HTBOTTOMRIGHT;
-		if (pt.y < -borderY) return HTTOP;
-		if (pt.y > rc.bottom) return HTBOTTOM;
-		if (pt.x < borderX) return HTLEFT;
-		if (pt.x > rc.right - borderX) return HTRIGHT;
+		LONG exStyle = GetWindowLong(window, GWL_EXSTYLE);
+		exStyle |= (WS_EX_APPWINDOW);
+		SetWindowLong(window, GWL_EXSTYLE, exStyle);
 
-		return HTCLIENT;
+		RECT windowRect = { 0, 0, clientRect.right - clientRect.left, clientRect.bottom - clientRect.top };
+		AdjustWindowRectEx(&windowRect, data->style, FALSE, exStyle);
+
+		data->x = topLeft.x + windowRect.left;
+		data->y = topLeft.y + windowRect.top;
+		data->width = windowRect.right - windowRect.left;
+		data->height = windowRect.bottom - windowRect.top;
+		data->flags &= ~TWM_WINDOW_BORDERLESS;
 	}
 
-	case WM_SIZE: {
-		if (data == NULL) break;
-		if (data->disable_events) break;
+	SetWindowPos(window, NULL, data->x, data->y, data->width, data->height, SWP_NOZORDER | SWP_NOACTIVATE | SWP_FRAMECHANGED | SWP_SHOWWINDOW);
 
-		int newWidth = LOWORD(lParam);
-		int newHeight = HIWORD(lParam);
+	data->disable_events = FALSE;
+}
 
-		if (newWidth == 0 || newHeight == 0) break;
+bool twm_window_is_borderless(twm_window window) {
+	return twm_get_window_data(window)->flags & TWM_WINDOW_BORDERLESS;
+}
 
-		switch (wParam) {
-		case SIZE_RESTORED:
-			if (data->last_state != SIZE_RESTORED || newWidth != data->width || newHeight != data->height) {
-				data->width = newWidth;
-				data->height = newHeight;
-				data->was_resized = true;
+void twm_window_fullscreen(twm_window window, bool enable) {
+	twm_window_borderless(window, enable);
 
-				PostMessage(hWnd, WM_WINDOW_SIZE, newWidth, newHeight);
-			}
+	HMONITOR monitor = MonitorFromWindow(window, MONITOR_DEFAULTTONEAREST);
+	MONITORINFO mi = { .cbSize = sizeof(mi) };
+	GetMonitorInfo(monitor, &mi);
 
-			else if (data->last_state != SIZE_RESTORED) {
-				PostMessage(hWnd, WM_WINDOW_RESTORE, newWidth, newHeight);
-			}
-			break;
-		case SIZE_MINIMIZED:
-			PostMessage(hWnd, WM_WINDOW_SIZE, newWidth, newHeight);
-			PostMessage(hWnd, WM_WINDOW_MINIMIZE, newWidth, newHeight);
-			data->width = newWidth;
-			data->height = newHeight;
-			data->was_resized = true;
-			break;
-		case SIZE_MAXIMIZED:
-			PostMessage(hWnd, WM_WINDOW_SIZE, newWidth, newHeight);
-			PostMessage(hWnd, WM_WINDOW_MAXIMIZE, newWidth, newHeight);
-			data->width = newWidth;
-			data->height = newHeight;
-			data->was_resized = true;
-			break;
-		}
+	twm_window_data* data = twm_get_window_data(window);
 
-		data->last_state = wParam;
-		break;
+	if (enable) {
+		data->original_rect = (RECT){ data->x, data->y, data->x + data->width, data->y + data->height };
+
+		SetWindowPos(window, HWND_TOP,
+			mi.rcMonitor.left, mi.rcMonitor.top,
+			mi.rcMonitor.right - mi.rcMonitor.left,
+			mi.rcMonitor.bottom - mi.rcMonitor.top,
+			SWP_NOOWNERZORDER | SWP_FRAMECHANGED);
+
+		data->flags |= TWM_WINDOW_FULLSCREEN;
 	}
+	else {
+		AdjustWindowRectEx(&data->original_rect, GetWindowLong(window, GWL_STYLE), FALSE, GetWindowLong(window, GWL_EXSTYLE));
 
-	case WM_MOVE: {
-		if (data == NULL) break;
-		if (data->disable_events) break;
-		if (IsIconic(hWnd)) break;
+		SetWindowPos(window, HWND_TOP,
+			data->original_rect.left, data->original_rect.top,
+			data->original_rect.right - data->original_rect.left,
+			data->original_rect.bottom - data->original_rect.top,
+			SWP_NOOWNERZORDER | SWP_FRAMECHANGED);
 
-		int newX = LOWORD(lParam);
-		int newY = HIWORD(lParam);
+		data->flags &= ~TWM_WINDOW_FULLSCREEN;
+	}
+}
 
-		RECT r = { 0, 0, 0, 0 };
-		AdjustWindowRectEx(& r, GetWindowLong(hWnd, GWL_STYLE), FALSE, GetWindowLong(hWnd, GWL_EXSTYLE));
+bool twm_window_is_fullscreen(twm_window window) {
+	return twm_get_window_data(window)->flags & TWM_WINDOW_FULLSCREEN;
+}
 
-		if (newX != data->x - r.left || newY != data->y - r.top) {
-			data->x = newX;
-			data->y = newY;
+void twm_set_window_ptr(twm_window window, void * ptr) {
+	twm_get_window_data(window)->ptr = ptr;
+}
 
-			if (!IsZoomed(hWnd)) {
-				newX += r.left;
-				newY += r.top;
-			}
+void * twm_get_window_ptr(twm_window window) {
+	return twm_get_window_data(window)->ptr;
+}
 
-			if (!data->resizing) {
-				PostMessage(hWnd, WM_WINDOW_MOVE, newX, newY);
-			}
-		}
-		break;
+void twm_set_window_property(twm_window window, const char * name, int size, const void* value) {
+	void* data = (void*)GetProp(window, name);
+	if (!data) {
+		data = malloc(size);
 	}
 
-	case WM_NCLBUTTONDOWN:
-		if (wParam == HTCAPTION || (wParam >= HTLEFT && wParam <= HTBOTTOMRIGHT)) {
-			GetCursorPos(&data->last_mouse);
-			GetWindowRect(hWnd, &data->original_rect);
-			SetCapture(hWnd);
+	memcpy(data, value, size);
 
-			if (wParam == HTCAPTION) {
-				data->dragging = TRUE;
-			}
-			else {
-				data->resizing = TRUE;
-				data->resize_edge = wParam;
-			}
-		}
-		break;
+	SetProp(window, name, (HANDLE)data);
+}
 
-	case WM_MOUSELEAVE:
-		data->tracking_mouse = FALSE;
-		break;
+bool twm_get_window_property(twm_window window, const char * name, int size, void* value) {
+	void* data = (void*)GetProp(window, name);
+	if (!data) return 0;
 
-	case WM_MOUSEMOVE:
-		if (!data->tracking_mouse) {
-			TRACKMOUSEEVENT tme = { 0 };
-			tme.cbSize = sizeof(tme);
-			tme.dwFlags = TME_LEAVE;
-			tme.hwndTrack = hWnd;
-			TrackMouseEvent(&tme);
-			data->tracking_mouse = TRUE;
+	memcpy(value, data, size);
 
-			PostMessage(hWnd, WM_MOUSEHOVER, wParam, lParam);
-		}
+	return 1;
+}
 
-		if (data->dragging || data->resizing) {
-			if (IsZoomed(hWnd)) return 0;
-			
-			POINT current;
-			GetCursorPos(&current);
-			int dx = current.x - data->last_mouse.x;
-			int dy = current.y - data->last_mouse.y;
+void twm_free_window_property(twm_window window, const char* name) {
+	void* data = (void*)GetProp(window, name);
+	if (!data) return;
 
-			RECT newRect = data->original_rect;
+	free(data);
+}
 
-			if (data->dragging) {
-				OffsetRect(&newRect, dx, dy);
-			}
-			else if (data->resizing) {
-				switch (data->resize_edge) {
-				case HTLEFT:       newRect.left += dx; break;
-				case HTRIGHT:      newRect.right += dx; break;
-				case HTTOP:        newRect.top += dy; break;
-				case HTBOTTOM:     newRect.bottom += dy; break;
-				case HTTOPLEFT:    newRect.left += dx; newRect.top += dy; break;
-				case HTTOPRIGHT:   newRect.right += dx; newRect.top += dy; break;
-				case HTBOTTOMLEFT: newRect.left += dx; newRect.bottom += dy; break;
-				case HTBOTTOMRIGHT:newRect.right += dx; newRect.bottom += dy; break;
-				}
-			}
+void twm_cursor_position(int* x, int* y) {
+	POINT p;
+	GetCursorPos(&p);
 
-			SetWindowPos(hWnd, NULL, newRect.left, newRect.top,
-				newRect.right - newRect.left,
-				newRect.bottom - newRect.top,
-				SWP_NOZORDER | SWP_NOACTIVATE);
+	*x = p.x;
+	*y = p.y;
+}
 
-			return 0;
-		}
-		break;
+void twm_move_cursor(int x, int y) {
+	SetCursorPos(x, y);
+}
 
-	case WM_LBUTTONDOWN:
-	case WM_MBUTTONDOWN:
-	case WM_RBUTTONDOWN:
-	case WM_XBUTTONDOWN:
-		SetCapture(hWnd);
-		break;
+void twm_clip_cursor(twm_window window) {
+	_twm_data.clip = window;
+	
+	RECT clientRect;
+	GetClientRect(window, &clientRect);
+	POINT tl = { clientRect.left, clientRect.top };
+	POINT br = { clientRect.right, clientRect.bottom };
 
-	case WM_LBUTTONUP:
-	case WM_MBUTTONUP:
-	case WM_RBUTTONUP:
-	case WM_XBUTTONUP:
-	case WM_NCLBUTTONUP:
-		data->dragging = FALSE;
-		data->resizing = FALSE;
-		ReleaseCapture();
-		break;
+	ClientToScreen(window, &tl);
+	ClientToScreen(window, &br);
 
-	case WM_CLOSE:
-		PostMessage(hWnd, WM_WINDOW_CLOSE, wParam, lParam);
-		data->was_closed = TRUE;
-		return 0;
+	RECT screenRect = { tl.x, tl.y, br.x, br.y };
+	ClipCursor(&screenRect);
+}
 
-	case WM_SYSKEYDOWN:
-		if (wParam == VK_F4 && (GetAsyncKeyState(VK_MENU) & 0x8000)) {
-			break;
-		}
-		return 0;
+void twm_unclip_cursor() {
+	_twm_data.clip = NULL;
+	
+	ClipCursor(NULL);
+}
+
+void twm_show_cursor(bool flag) {
+	if (flag) {
+		while (ShowCursor(true) < 0);
+	}
+	
+	else {
+		while (ShowCursor(false) >= 0);
 	}
+}
 
-	return DefWindowProc(hWnd, uMsg, wParam, lParam);
+bool twm_cursor_is_visible() {
+	CURSORINFO ci;
+	ci.cbSize = sizeof(CURSORINFO);
+	return GetCursorInfo(&ci)&& (ci.flags & CURSOR_SHOWING);
 }
 
-#ifdef TWM_GL
-void twm_gl_set_pixel_attribs(int pixel_attribs[]) {
-	int i = 0;
-	while (pixel_attribs[i] != 0) {
-		switch (pixel_attribs[i]) {
-		case TWM_GL_DOUBLE_BUFFER:
-			_twm_data.pixel_attribs[7] = pixel_attribs[++i];
-			break;
-		case TWM_GL_COLOR_BITS:
-			_twm_data.pixel_attribs[9] = pixel_attribs[++i];
-			break;
-		case TWM_GL_ALPHA_BITS:
-			_twm_data.pixel_attribs[11] = pixel_attribs[++i];
-			break;
-		case TWM_GL_DEPTH_BITS:
-			_twm_data.pixel_attribs[13] = pixel_attribs[++i];
-			break;
-		case TWM_GL_STENCIL_BITS:
-			_twm_data.pixel_attribs[15] = pixel_attribs[++i];
-			break;
-		case TWM_GL_SRGB_CAPABLE:
-			_twm_data.pixel_attribs[17] = pixel_attribs[++i];
-			break;
-		case TWM_GL_SAMPLE_BUFFERS:
-			_twm_data.pixel_attribs[19] = pixel_attribs[++i];
-			break;
-		case TWM_GL_SAMPLES:
-			_twm_data.pixel_attribs[21] = pixel_attribs[++i];
-			break;
-		}
-		i++;
-	}
+void twm_rawmouse_master_only(bool enable) {
+	_twm_data.mouse.raw.master_only = enable;
 }
 
-twm_gl_context twm_gl_create_context(twm_window window, int* attribs) {
-	int context_attribs[] = {
-		WGL_CONTEXT_MAJOR_VERSION_ARB, 4,
-		WGL_CONTEXT_MINOR_VERSION_ARB, 1,
-		WGL_CONTEXT_PROFILE_MASK_ARB,  WGL_CONTEXT_CORE_PROFILE_BIT_ARB,
-		0
-	};
+static inline unsigned short twm_resolve_key(WORD keyFlags, WPARAM wParam, LPARAM lParam) {
+	WORD vkCode = LOWORD(wParam);
+	WORD scanCode = LOBYTE(keyFlags);
 
-	int i = 0;
-	while (attribs[i] != 0) {
-		switch (attribs[i]) {
-		case TWM_GL_CONTEXT_MAJOR_VERSION:
-			context_attribs[1] = attribs[++i];
-			break;
+	BOOL isExtendedKey = (keyFlags & KF_EXTENDED) == KF_EXTENDED;
 
-		case TWM_GL_CONTEXT_MINOR_VERSION:
-			context_attribs[3] = attribs[++i];
-			break;
+	if (isExtendedKey) {
+		scanCode = MAKEWORD(scanCode, 0xE0);
+	}
 
-		case TWM_GL_CONTEXT_PROFILE_MASK:
-			switch (attribs[++i]) {
-			case TWM_GL_CONTEXT_CORE_PROFILE:
-				context_attribs[5] = WGL_CONTEXT_CORE_PROFILE_BIT_ARB;
-				break;
-			case TWM_GL_CONTEXT_COMPATIBILITY_PROFILE:
-				context_attribs[5] = WGL_CONTEXT_COMPATIBILITY_PROFILE_BIT_ARB;
-				break;
-			}
-			break;
-		}
-		i++;
+	if (vkCode == 0) {
+		vkCode = MapVirtualKey(scanCode, MAPVK_VSC_TO_VK_EX);
 	}
 
-	twm_gl_context context = (twm_gl_context)malloc(sizeof(struct _twm_gl_context));
-
-	if (context == NULL) return NULL;
-
-	context->hdc = GetDC(window);
+	switch (vkCode) {
+	case VK_SHIFT:
+		vkCode = (scanCode == MapVirtualKey(VK_LSHIFT, MAPVK_VK_TO_VSC)) ? VK_LSHIFT : VK_RSHIFT;
+		break;
 
-	HDC hdc = context->hdc;
+	case VK_CONTROL:
+		vkCode = isExtendedKey ? VK_RCONTROL : VK_LCONTROL;
+		break;
 
-	int format;
-	UINT numFormats;
-	_twm_data.wglChoosePixelFormatARB(context->hdc, _twm_data.pixel_attribs, NULL, 1, &format, &numFormats);
-	PIXELFORMATDESCRIPTOR pdf = { 0 };
-	SetPixelFormat(context->hdc, format, &pdf);
+	case VK_MENU:
+		vkCode = isExtendedKey ? VK_RMENU : VK_LMENU;
+		break;
 
-	context->hwnd = window;
-	context->hglrc = _twm_data.wglCreateContextAttribsARB(context->hdc, 0, context_attribs);
+	case VK_RETURN:
+		vkCode = isExtendedKey ? TWM_KEY_NUMPAD_ENTER : TWM_KEY_ENTER;
+		break;
+	}
 
-	return context;
+	return vkCode;
 }
 
-void twm_gl_delete_context(twm_gl_context context) {
-	wglDeleteContext(context->hglrc);
+static inline twm_keymod twm_get_keymods() {
+	twm_keymod mods = 0;
 
-	ReleaseDC(context->hwnd, context->hdc);
-}
-#endif
+	if (GetAsyncKeyState(VK_LSHIFT) & 0x8000)
+		mods |= TWM_KEYMOD_SHIFT | TWM_KEYMOD_LSHIFT;
+	if (GetAsyncKeyState(VK_RSHIFT) & 0x8000)
+		mods |= TWM_KEYMOD_SHIFT | TWM_KEYMOD_RSHIFT;
 
-#ifdef TWM_VULKAN
-const char** twm_vk_get_instance_extensions(int* extension_count) {
-	static const char* extensions[] = {
-		VK_KHR_SURFACE_EXTENSION_NAME,
-		VK_KHR_WIN32_SURFACE_EXTENSION_NAME
-	};
+	if (GetAsyncKeyState(VK_LCONTROL) & 0x8000)
+		mods |= TWM_KEYMOD_CTRL | TWM_KEYMOD_LCTRL;
+	if (GetAsyncKeyState(VK_RCONTROL) & 0x8000)
+		mods |= TWM_KEYMOD_CTRL | TWM_KEYMOD_RCTRL;
 
-	*extension_count = sizeof(extensions) / sizeof(extensions[0]);
+	if (GetAsyncKeyState(VK_LMENU) & 0x8000)
+		mods |= TWM_KEYMOD_ALT | TWM_KEYMOD_LALT;
+	if (GetAsyncKeyState(VK_RMENU) & 0x8000)
+		mods |= TWM_KEYMOD_ALT | TWM_KEYMOD_RALT;
 
-	return extensions;
-}
+	if (GetAsyncKeyState(VK_LWIN) & 0x8000)
+		mods |= TWM_KEYMOD_LWIN;
+	if (GetAsyncKeyState(VK_RWIN) & 0x8000)
+		mods |= TWM_KEYMOD_RWIN;
 
-VkResult twm_vk_create_surface(twm_window window, VkInstance instance, const VkAllocationCallbacks* pAllocator, VkSurfaceKHR* pSurface) {
-	VkWin32SurfaceCreateInfoKHR surface_info;
-	surface_info.sType = VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR;
-	surface_info.hinstance = _twm_data.hInstance;
-	surface_info.hwnd = window;
-	surface_info.pNext = NULL;
-	surface_info.flags = 0;
+	if (GetAsyncKeyState(VK_APPS) & 0x8000)
+		mods |= TWM_KEYMOD_MENU;
 
-	return vkCreateWin32SurfaceKHR(instance, &surface_info, NULL, pSurface);
+	if (GetKeyState(VK_NUMLOCK) & 0x1)
+		mods |= TWM_KEYMOD_NUMLOCK;
+	if (GetKeyState(VK_SCROLL) & 0x1)
+		mods |= TWM_KEYMOD_SCROLLLOCK;
+	if (GetKeyState(VK_CAPITAL) & 0x1)
+		mods |= TWM_KEYMOD_CAPSLOCK;
+
+	return mods;
 }
-#endif
 
-#elif defined(TWM_X11)
+static inline int _twm_translate_event(MSG* msg, twm_event* evt) {
+	TranslateMessage(msg);
+	DispatchMessage(msg);
 
-twm_data _twm_data = { 0 };
+	_twm_stamp_event(evt, (unsigned long)msg->time);
 
-typedef struct twm_window_data {
-	int width, height;
-	int x, y;
-	char state;
-	Bool was_closed;
-	Bool was_resized;
-	void * ptr;
-	twm_window_flags flags;
-#ifdef TWM_GL
-	Colormap colorMap;
-	XVisualInfo* visual;
-	GLXFBConfig fbconfig;
-#endif
-} twm_window_data;
+	switch (msg->message)
+	{
+		case WM_INPUT:
+		{
+			UINT dwSize = sizeof(RAWINPUT);
+			static BYTE lpb[sizeof(RAWINPUT)];
 
-int twm_init() {
-	setlocale(LC_ALL, "");
+			GetRawInputData((HRAWINPUT)msg->lParam, RID_INPUT, lpb, &dwSize, sizeof(RAWINPUTHEADER));
 
-	XSetLocaleModifiers("@im=none");
+			RAWINPUT* raw = (RAWINPUT*)lpb;
 
-	_twm_data.display = XOpenDisplay(NULL);
+			if (raw->header.dwType == RIM_TYPEMOUSE)
+			{
+				LONG dx = raw->data.mouse.lLastX;
+				LONG dy = raw->data.mouse.lLastY;
 
-	if (_twm_data.display == NULL) return 0;
+				if (dx || dy) {
+					return _twm_translate_rawmouse(evt, msg->hwnd, dx, dy);
+				}
+			}
+			break;
+		}
 
-	_twm_data.window_context = XUniqueContext();
-	_twm_data.cursor_visible = true;
+		case WM_WINDOW_CLOSE:
+		{
+			evt->type = TWM_EVENT_WINDOW_CLOSE;
+			evt->window.window = msg->hwnd;
 
-	int event, error;
-	if (!XQueryExtension(_twm_data.display, "XInputExtension", &_twm_data.opcode, &event, &error)) {
-		return 1;
-	}
+			return 1;
+		}
 
-	int major = 2, minor = 0;
-	if (XIQueryVersion(_twm_data.display, &major, &minor) != Success) {
-		return 1;
-	}
+		case WM_WINDOW_MOVE:
+		{
+			evt->type = TWM_EVENT_WINDOW_MOVE;
+			evt->window.window = msg->hwnd;
+			evt->window.x = (int)msg->wParam;
+			evt->window.y = (int)msg->lParam;
 
-	_twm_data.screen.screen_res = XRRGetScreenResources(_twm_data.display, DefaultRootWindow(_twm_data.display));
+			return 1;
+		}
 
-	if (_twm_data.screen.screen_res) {
-		_twm_data.screen.count = 0;
-		
-		for (int i = 0; i < _twm_data.screen.screen_res->noutput; i++) {
-			RROutput output = _twm_data.screen.screen_res->outputs[i];
-			XRROutputInfo * output_info = XRRGetOutputInfo(_twm_data.display, _twm_data.screen.screen_res, output);
-			if (output_info->connection == RR_Connected && output_info->crtc) {
-				XRRCrtcInfo* crtc_info = XRRGetCrtcInfo(_twm_data.display, _twm_data.screen.screen_res, output_info->crtc);
+		case WM_WINDOW_SIZE:
+		{
+			evt->type = TWM_EVENT_WINDOW_SIZE;
+			evt->window.window = msg->hwnd;
+			evt->window.width = (int)msg->wParam;
+			evt->window.height = (int)msg->lParam;
 
-				if (crtc_info) {
-					_twm_data.screen.count++;
+			return 1;
+		}
 
-					XRRFreeCrtcInfo(crtc_info);
-				}
-			}
-			XRRFreeOutputInfo(output_info);
+		case WM_WINDOW_MAXIMIZE:
+		{
+			evt->type = TWM_EVENT_WINDOW_MAXIMIZE;
+			evt->window.window = msg->hwnd;
+			evt->window.width = (int)msg->wParam;
+			evt->window.height = (int)msg->lParam;
+
+			return 1;
 		}
 
-		_twm_data.screen.screen = (twm_screen*)malloc(sizeof(twm_screen) * _twm_data.screen.count);
+		case WM_WINDOW_MINIMIZE:
+		{
+			evt->type = TWM_EVENT_WINDOW_MINIMIZE;
+			evt->window.window = msg->hwnd;
+			evt->window.width = (int)msg->wParam;
+			evt->window.height = (int)msg->lParam;
+
+			return 1;
+		}
 
-		int depth = DefaultDepth(_twm_data.display, DefaultScreen(_twm_data.display));
+		case WM_WINDOW_RESTORE:
+		{
+			evt->type = TWM_EVENT_WINDOW_RESTORE;
+			evt->window.window = msg->hwnd;
+			evt->window.width = (int)msg->wParam;
+			evt->window.height = (int)msg->lParam;
 
-		int bpp;
-		switch (depth) {
-			case 24: bpp = 32; break;
-			case 16: bpp = 16; break;
-			case 15: bpp = 16; break;
-			case 32: bpp = 32; break;
-			default: bpp = depth; break;
+			return 1;
 		}
 
-		int screen_index = 0;
-		for (int i = 0; i < _twm_data.screen.screen_res->noutput; i++) {
-			twm_screen * screen = &_twm_data.screen.screen[screen_index];
+		case WM_MOUSEHOVER:
+		{
+			evt->type = TWM_EVENT_MOUSE_ENTER;
+			evt->window.window = msg->hwnd;
 
-			screen->output = _twm_data.screen.screen_res->outputs[i];
-			screen->output_info = XRRGetOutputInfo(_twm_data.display, _twm_data.screen.screen_res, screen->output);
+			return 1;
+		}
 
-			if (screen->output_info->connection == RR_Connected && screen->output_info->crtc) {
-				screen->crtc_info = XRRGetCrtcInfo(_twm_data.display, _twm_data.screen.screen_res, screen->output_info->crtc);
-				if (screen->crtc_info) {
-					strcpy(screen->name, screen->output_info->name);
+		case WM_MOUSELEAVE:
+		{
+			evt->type = TWM_EVENT_MOUSE_LEAVE;
+			evt->window.window = msg->hwnd;
 
-					screen->x = screen->crtc_info->x;
-					screen->y = screen->crtc_info->y;
-					screen->width = screen->crtc_info->width;
-					screen->height = screen->crtc_info->height;
+			memset(_twm_data.mouse.buttons, 0, sizeof(_twm_data.mouse.buttons));
 
-					screen->modes.count = screen->output_info->nmode;
-					screen->modes.mode = (twm_screen_mode*)malloc(sizeof(twm_screen_mode) * screen->output_info->nmode);
-	
-					for (int j = 0; j < screen->output_info->nmode; j++) {
-						RRMode mode = screen->output_info->modes[j];
-						for (int k = 0; k < _twm_data.screen.screen_res->nmode; k++) {
-							if (_twm_data.screen.screen_res->modes[k].id == mode) {
-								XRRModeInfo* mi = &_twm_data.screen.screen_res->modes[k];
-
-								if (mi->id == screen->crtc_info->mode) {
-									screen->modes.current = j;
-								}
-
-								screen->modes.mode[j].mode = mode;
-								screen->modes.mode[j].width = mi->width;
-								screen->modes.mode[j].height = mi->height;
-								screen->modes.mode[j].bpp = bpp;
-								screen->modes.mode[j].hz = twm_round(mi->dotClock / (float)(mi->hTotal * mi->vTotal));
-							}
-						}
-					}
+			return 1;
+		}
 
-					screen_index++;
-				}
-			}
+		case WM_WINDOW_ACTIVE:
+		{
+			evt->type = TWM_EVENT_WINDOW_ACTIVE;
+			evt->window.window = msg->hwnd;
+
+			return 1;
 		}
-	}
 
-	XIEventMask evmask;
-	unsigned char mask[XIMaskLen(XI_LASTEVENT)] = { 0 };
+		case WM_WINDOW_INACTIVE:
+		{
+			evt->type = TWM_EVENT_WINDOW_INACTIVE;
+			evt->window.window = msg->hwnd;
 
-	evmask.deviceid = XIAllDevices;
-	evmask.mask_len = sizeof(mask);
-	evmask.mask = mask;
+			memset(_twm_data.mouse.buttons, 0, sizeof(_twm_data.mouse.buttons));
+			memset(_twm_data.keyboard.keys, 0, sizeof(_twm_data.keyboard.keys));
+			_twm_data.keyboard.modifiers = 0;
 
-	XISetMask(mask, XI_RawMotion);
+			return 1;
+		}
 
-	XISelectEvents(_twm_data.display, DefaultRootWindow(_twm_data.display), &evmask, 1);
-	XFlush(_twm_data.display);
+		case WM_MOUSEMOVE:
+		{
+			POINT pt = { GET_X_LPARAM(msg->lParam), GET_Y_LPARAM(msg->lParam) };
+			RECT clientRect;
+			GetClientRect(msg->hwnd, &clientRect);
 
-	_twm_data.atom[TWM_X11_ATOM_NET_WM_STATE] = XInternAtom(_twm_data.display, "_NET_WM_STATE", False);
-	_twm_data.atom[TWM_X11_ATOM_NET_WM_STATE_HIDDEN] = XInternAtom(_twm_data.display, "_NET_WM_STATE_HIDDEN", False);
-	_twm_data.atom[TWM_X11_ATOM_NET_WM_STATE_MAX_HORZ] = XInternAtom(_twm_data.display, "_NET_WM_STATE_MAXIMIZED_HORZ", False);
-	_twm_data.atom[TWM_X11_ATOM_NET_WM_STATE_MAX_VERT] = XInternAtom(_twm_data.display, "_NET_WM_STATE_MAXIMIZED_VERT", False);
+			if (PtInRect(&clientRect, pt)) {
 
-	_twm_data.xim = XOpenIM(_twm_data.display, NULL, NULL, NULL);
+				evt->type = TWM_EVENT_MOUSE_MOVE;
+				evt->mouse.window = msg->hwnd;
+				evt->mouse.x = _twm_data.mouse.x = GET_X_LPARAM(msg->lParam);
+				evt->mouse.y = _twm_data.mouse.y = GET_Y_LPARAM(msg->lParam);
+				evt->mouse.fx = _twm_data.mouse.fx = evt->mouse.x;
+				evt->mouse.fy = _twm_data.mouse.fy = evt->mouse.y;
+				evt->mouse.z = 0;
+				evt->mouse.w = 0;
 
-	_twm_data.atom[TWM_X11_ATOM_DELETE] = XInternAtom(_twm_data.display, "WM_DELETE_WINDOW", 1);
-	_twm_data.atom[TWM_X11_ATOM_CHAR] = XInternAtom(_twm_data.display, "TWM_CHAR", 1);
+				return 1;
+			}
 
-	char no_data[] = { 0 };
-	Pixmap blank = XCreateBitmapFromData(_twm_data.display, DefaultRootWindow(_twm_data.display), no_data, 1, 1);
+			break;
+		}
 
-	XColor dummy;
-	memset(&dummy, 0, sizeof(dummy));
-	_twm_data.cursor[TWM_X11_CURSOR_INVISIBLE] = XCreatePixmapCursor(_twm_data.display, blank, blank, &dummy, &dummy, 0, 0);
+		case WM_MOUSEWHEEL:
+		{
+			#define WHEEL_DELTA 120
 
-	XFreePixmap(_twm_data.display, blank);
+			evt->type = TWM_EVENT_MOUSE_WHEEL;
 
-	_twm_data.cursor[TWM_X11_CURSOR_DEFAULT] = XCreateFontCursor(_twm_data.display, XC_left_ptr); // cursor padrão (seta)
-	XDefineCursor(_twm_data.display, DefaultRootWindow(_twm_data.display), _twm_data.cursor[TWM_X11_CURSOR_DEFAULT]);
-	XFlush(_twm_data.display);
-
-#ifdef TWM_GL
-	{
-		int pixel_attribs[] = {
-			GLX_X_RENDERABLE, True,
-			GLX_DRAWABLE_TYPE, GLX_WINDOW_BIT,
-			GLX_RENDER_TYPE,   GLX_RGBA_BIT,
-			GLX_X_VISUAL_TYPE, GLX_TRUE_COLOR,
-			GLX_DOUBLEBUFFER,  True,
-			GLX_RED_SIZE,      8,
-			GLX_GREEN_SIZE,    8,
-			GLX_BLUE_SIZE,     8,
-			GLX_ALPHA_SIZE,    8,
-			GLX_DEPTH_SIZE,    24,
-			GLX_STENCIL_SIZE,  8,
-			GLX_FRAMEBUFFER_SRGB_CAPABLE_ARB, True,
-			GLX_SAMPLE_BUFFERS, False,
-			GLX_SAMPLES, 1,
-			None
-		};
+			evt->mouse.x = GET_X_LPARAM(msg->lParam);
+			evt->mouse.y = GET_Y_LPARAM(msg->lParam);
+			evt->mouse.fx = evt->mouse.x;
+			evt->mouse.fy = evt->mouse.y;
+			evt->mouse.z = GET_WHEEL_DELTA_WPARAM(msg->wParam) / WHEEL_DELTA;
+			evt->mouse.w = 0;
 
-		memcpy(_twm_data.pixel_attribs, pixel_attribs, sizeof(pixel_attribs));
+			return 1;
+		}
 
-		_twm_data.glXCreateContextAttribsARB = (PFNGLXCREATECONTEXTATTRIBSARBPROC)glXGetProcAddressARB((const GLubyte*)"glXCreateContextAttribsARB");
-		_twm_data.glXSwapIntervalEXT = (PFNGLXSWAPINTERVALEXTPROC) glXGetProcAddress((const GLubyte*)"glXSwapIntervalEXT");
-		_twm_data.swap_interval = 0;
-	}
-#endif
+		case WM_MOUSEHWHEEL:
+		{
+			#define WHEEL_DELTA 120
 
-	return 1;
-}
+			evt->type = TWM_EVENT_MOUSE_WHEEL;
 
-void twm_finalize() {
-	for (int i = 0; i < _twm_data.screen.count; i++) {
-		free(_twm_data.screen.screen[i].modes.mode);
+			evt->mouse.x = GET_X_LPARAM(msg->lParam);
+			evt->mouse.y = GET_Y_LPARAM(msg->lParam);
+			evt->mouse.fx = evt->mouse.x;
+			evt->mouse.fy = evt->mouse.y;
+			evt->mouse.w = GET_WHEEL_DELTA_WPARAM(msg->wParam) / WHEEL_DELTA;
+			evt->mouse.z = 0;
 
-		XRRFreeCrtcInfo(_twm_data.screen.screen[i].crtc_info);
-		XRRFreeOutputInfo(_twm_data.screen.screen[i].output_info);
-	}
-	free(_twm_data.screen.screen);
+			return 1;
+		}
 
-	XRRFreeScreenResources(_twm_data.screen.screen_res);
+		case WM_LBUTTONDOWN:
+		{
+			POINT pt = { GET_X_LPARAM(msg->lParam), GET_Y_LPARAM(msg->lParam) };
+			RECT clientRect;
+			GetClientRect(msg->hwnd, &clientRect);
 
-	XFreeCursor(_twm_data.display, _twm_data.cursor[TWM_X11_CURSOR_DEFAULT]);
-	XFreeCursor(_twm_data.display, _twm_data.cursor[TWM_X11_CURSOR_INVISIBLE]);
+			if (PtInRect(&clientRect, pt)) {
+				evt->type = TWM_EVENT_MOUSE_DOWN;
+				evt->mouse.window = msg->hwnd;
+				evt->mouse.button = TWM_MB_LEFT;
+				evt->mouse.x = pt.x;
+				evt->mouse.y = pt.y;
+				evt->mouse.fx = evt->mouse.x;
+				evt->mouse.fy = evt->mouse.y;
+				evt->mouse.z = 0;
+				evt->mouse.w = 0;
 
-	XCloseDisplay(_twm_data.display);
-}
+				_twm_data.mouse.buttons[evt->mouse.button] = true;
 
-bool twm_change_screen_mode(int screen_index, int mode_index) {
-	if (screen_index < 0 || screen_index >= _twm_data.screen.count || mode_index < 0) return false;
+				return 1;
+			}
 
-	twm_screen* screen = &_twm_data.screen.screen[screen_index];
+			break;
+		}
 
-	if (mode_index >= screen->modes.count) return false;
+		case WM_MBUTTONDOWN:
+		{
+			POINT pt = { GET_X_LPARAM(msg->lParam), GET_Y_LPARAM(msg->lParam) };
+			RECT clientRect;
+			GetClientRect(msg->hwnd, &clientRect);
 
-	twm_screen_mode * mode = &screen->modes.mode[mode_index];
+			if (PtInRect(&clientRect, pt)) {
+				evt->type = TWM_EVENT_MOUSE_DOWN;
+				evt->mouse.window = msg->hwnd;
+				evt->mouse.button = TWM_MB_MIDDLE;
+				evt->mouse.x = pt.x;
+				evt->mouse.y = pt.y;
+				evt->mouse.fx = evt->mouse.x;
+				evt->mouse.fy = evt->mouse.y;
+				evt->mouse.z = 0;
+				evt->mouse.w = 0;
 
-	XRRCrtcInfo * crtc_info = screen->crtc_info;
+				_twm_data.mouse.buttons[evt->mouse.button] = true;
 
-    return XRRSetCrtcConfig(_twm_data.display, _twm_data.screen.screen_res, screen->output_info->crtc, CurrentTime, crtc_info->x, crtc_info->y, mode->mode,crtc_info->rotation,&screen->output, 1) == Success;
-}
+				return 1;
+			}
 
-twm_window twm_create_window(const char* title, int x, int y, int width, int height, twm_window_flags flags) {
-	twm_window_data* data = (twm_window_data*)malloc(sizeof(twm_window_data));
-	memset(data, 0, sizeof(twm_window_data));
+			break;
+		}
 
-	data->width = width;
-	data->height = height;
-	data->state = 0;
-	data->flags = flags;
+		case WM_RBUTTONDOWN:
+		{
+			POINT pt = { GET_X_LPARAM(msg->lParam), GET_Y_LPARAM(msg->lParam) };
+			RECT clientRect;
+			GetClientRect(msg->hwnd, &clientRect);
 
-	int screen = twm_screen_from_cursor();
-	twm_rect screen_rect;
-	twm_screen_rect(screen, &screen_rect);
+			if (PtInRect(&clientRect, pt)) {
+				evt->type = TWM_EVENT_MOUSE_DOWN;
+				evt->mouse.window = msg->hwnd;
+				evt->mouse.button = TWM_MB_RIGHT;
+				evt->mouse.x = pt.x;
+				evt->mouse.y = pt.y;
+				evt->mouse.fx = evt->mouse.x;
+				evt->mouse.fy = evt->mouse.y;
+				evt->mouse.z = 0;
+				evt->mouse.w = 0;
 
-	data->x = x == TWM_CENTER ? screen_rect.x + screen_rect.width - data->width >> 1 : x;
-	data->y = y == TWM_CENTER ? screen_rect.y + screen_rect.height - data->height >> 1 : y;
+				_twm_data.mouse.buttons[evt->mouse.button] = true;
 
-	twm_window window;
+				return 1;
+			}
 
-	XSetWindowAttributes swa = { 0 };
-	swa.event_mask = ExposureMask | StructureNotifyMask | PropertyChangeMask | FocusChangeMask | KeyPressMask | KeyReleaseMask | KeymapStateMask | PointerMotionMask | ButtonPressMask | ButtonReleaseMask | EnterWindowMask | LeaveWindowMask;
+			break;
+		}
 
-#if defined(TWM_GL)
-	int fbcount = 0;
-	GLXFBConfig* fbconfigs = glXChooseFBConfig(_twm_data.display, DefaultScreen(_twm_data.display), _twm_data.pixel_attribs, &fbcount);
-	GLXFBConfig fbconfig = fbconfigs[0];
-	XFree(fbconfigs);
+		case WM_XBUTTONDOWN:
+		{
+			POINT pt = { GET_X_LPARAM(msg->lParam), GET_Y_LPARAM(msg->lParam) };
+			RECT clientRect;
+			GetClientRect(msg->hwnd, &clientRect);
 
-	XVisualInfo* visual = glXGetVisualFromFBConfig(_twm_data.display, fbconfig);
+			if (PtInRect(&clientRect, pt)) {
+				WORD xbtn = GET_XBUTTON_WPARAM(msg->wParam);
 
-	Colormap cmap = XCreateColormap(_twm_data.display, RootWindow(_twm_data.display, DefaultScreen(_twm_data.display)),
-		visual->visual, AllocNone);
+				evt->type = TWM_EVENT_MOUSE_DOWN;
+				evt->mouse.window = msg->hwnd;
+				evt->mouse.button = (twm_mouse_button)(TWM_MB_X1 - 1 + xbtn);
+				evt->mouse.x = pt.x;
+				evt->mouse.y = pt.y;
+				evt->mouse.fx = evt->mouse.x;
+				evt->mouse.fy = evt->mouse.y;
+				evt->mouse.z = 0;
+				evt->mouse.w = 0;
 
-	swa.colormap = cmap;
+				_twm_data.mouse.buttons[evt->mouse.button] = true;
 
-	window = XCreateWindow(_twm_data.display, RootWindow(_twm_data.display, DefaultScreen(_twm_data.display)),
-		data->x, data->y, data->width, data->height, 0,
-		visual->depth, InputOutput,
-		visual->visual,
-		CWColormap | CWEventMask, &swa);
+				return 1;
+			}
 
-	data->colorMap = cmap;
-	data->visual = visual;
-	data->fbconfig = fbconfig;
-#elif defined(TWM_VULKAN)
-	window = XCreateWindow(_twm_data.display, RootWindow(_twm_data.display, DefaultScreen(_twm_data.display)),
-		data->x, data->y, data->width, data->height, 0,
-		CopyFromParent, InputOutput,
-		CopyFromParent,
-		CWEventMask, &swa);
-#else
-    swa.background_pixel = BlackPixel(_twm_data.display, DefaultScreen(_twm_data.display));
+			break;
+		}
 
-	window = XCreateWindow(_twm_data.display, RootWindow(_twm_data.display, DefaultScreen(_twm_data.display)),
-		data->x, data->y, data->width, data->height, 0,
-		CopyFromParent, InputOutput,
-		CopyFromParent,
-		CWBackPixel | CWEventMask, &swa);
-#endif
+		case WM_LBUTTONUP:
+		{
+			POINT pt = { GET_X_LPARAM(msg->lParam), GET_Y_LPARAM(msg->lParam) };
+			RECT clientRect;
+			GetClientRect(msg->hwnd, &clientRect);
 
-	XSizeHints *hints = XAllocSizeHints();
-	hints->flags = PPosition;
-	hints->x = data->x;
-	hints->y = data->y;
+			if (PtInRect(&clientRect, pt) || twm_mb_state(TWM_MB_LEFT)) {
+				evt->type = TWM_EVENT_MOUSE_UP;
+				evt->mouse.window = msg->hwnd;
+				evt->mouse.button = TWM_MB_LEFT;
+				evt->mouse.x = pt.x;
+				evt->mouse.y = pt.y;
+				evt->mouse.fx = evt->mouse.x;
+				evt->mouse.fy = evt->mouse.y;
+				evt->mouse.z = 0;
+				evt->mouse.w = 0;
 
-	if (!(flags & TWM_WINDOW_RESIZABLE)) {
-		hints->flags |= PMinSize | PMaxSize;
+				_twm_data.mouse.buttons[evt->mouse.button] = false;
 
-		hints->min_width = hints->max_width = data->width;
-		hints->min_height = hints->max_height = data->height;
-	}
+				return 1;
+			}
 
-	XSetWMNormalHints(_twm_data.display, window, hints);
-	XFree(hints);
+			break;
+		}
 
-	if (flags & TWM_WINDOW_BORDERLESS) {
-		twm_window_borderless(window, true);
-	}
+		case WM_MBUTTONUP:
+		{
+			POINT pt = { GET_X_LPARAM(msg->lParam), GET_Y_LPARAM(msg->lParam) };
+			RECT clientRect;
+			GetClientRect(msg->hwnd, &clientRect);
 
-	XSaveContext(_twm_data.display, window, _twm_data.window_context, (XPointer)data);
+			if (PtInRect(&clientRect, pt) || twm_mb_state(TWM_MB_MIDDLE)) {
+				evt->type = TWM_EVENT_MOUSE_UP;
+				evt->mouse.window = msg->hwnd;
+				evt->mouse.button = TWM_MB_MIDDLE;
+				evt->mouse.x = pt.x;
+				evt->mouse.y = pt.y;
+				evt->mouse.fx = evt->mouse.x;
+				evt->mouse.fy = evt->mouse.y;
+				evt->mouse.z = 0;
+				evt->mouse.w = 0;
 
-	XSetWMProtocols(_twm_data.display, window, &_twm_data.atom[TWM_X11_ATOM_DELETE], 1);
+				_twm_data.mouse.buttons[evt->mouse.button] = false;
 
-	twm_title_window(window, (char*)title);
+				return 1;
+			}
 
-	_twm_data.xic = XCreateIC(_twm_data.xim, XNInputStyle, XIMPreeditNothing | XIMStatusNothing, XNClientWindow, window, NULL);
+			break;
+		}
 
-	return window;
-}
+		case WM_XBUTTONUP:
+		{
+			POINT pt = { GET_X_LPARAM(msg->lParam), GET_Y_LPARAM(msg->lParam) };
+			RECT clientRect;
+			GetClientRect(msg->hwnd, &clientRect);
 
-void twm_destroy_window(twm_window window) {
-	XDestroyWindow(_twm_data.display, window);
-}
+			WORD xbtn = GET_XBUTTON_WPARAM(msg->wParam);
+			twm_mouse_button button = (twm_mouse_button)(TWM_MB_X1 - 1 + xbtn);
 
-static inline twm_window_data * twm_get_window_data(twm_window window) {
-	XPointer out = NULL;
-	XFindContext(_twm_data.display, window, _twm_data.window_context, &out);
-	return (twm_window_data*)out;
-}
+			if (PtInRect(&clientRect, pt) || twm_mb_state(TWM_MB_MIDDLE)) {
+				evt->type = TWM_EVENT_MOUSE_UP;
+				evt->mouse.window = msg->hwnd;
+				evt->mouse.button = button;
+				evt->mouse.x = pt.x;
+				evt->mouse.y = pt.y;
+				evt->mouse.fx = evt->mouse.x;
+				evt->mouse.fy = evt->mouse.y;
+				evt->mouse.z = 0;
+				evt->mouse.w = 0;
 
-bool twm_window_was_closed(twm_window window) {
-	twm_window_data* data = twm_get_window_data(window);
+				_twm_data.mouse.buttons[evt->mouse.button] = false;
 
-	if (!data->was_closed) return false;
-	
-	data->was_closed = false;
+				return 1;
+			}
 
-	return true;
-}
+			break;
+		}
 
-bool twm_window_was_resized(twm_window window, int * width, int * height) {
-	twm_window_data* data = twm_get_window_data(window);
-
-	if (!data->was_resized) return false;
+		case WM_RBUTTONUP:
+		{
+			POINT pt = { GET_X_LPARAM(msg->lParam), GET_Y_LPARAM(msg->lParam) };
+			RECT clientRect;
+			GetClientRect(msg->hwnd, &clientRect);
 
-	data->was_resized = false;
+			if (PtInRect(&clientRect, pt) || twm_mb_state(TWM_MB_RIGHT)) {
+				evt->type = TWM_EVENT_MOUSE_UP;
+				evt->mouse.window = msg->hwnd;
+				evt->mouse.button = TWM_MB_RIGHT;
+				evt->mouse.x = pt.x;
+				evt->mouse.y = pt.y;
+				evt->mouse.fx = evt->mouse.x;
+				evt->mouse.fy = evt->mouse.y;
+				evt->mouse.z = 0;
+				evt->mouse.w = 0;
 
-	*width = data->width;
-	*height = data->height;
+				_twm_data.mouse.buttons[evt->mouse.button] = false;
 
-	return true;
-}
+				return 1;
+			}
 
-void twm_show_window(twm_window window, bool visible) {
-	if (visible) {
-		XMapWindow(_twm_data.display, window);
-	}
-	else {
-		XUnmapWindow(_twm_data.display, window);
-	}
+			break;
+		}
 
-	XFlush(_twm_data.display);
-}
+		case WM_SYSKEYDOWN:
+		case WM_KEYDOWN: {
+			WORD keyFlags = HIWORD(msg->lParam);
 
-bool twm_window_is_visible(twm_window window) {
-	XWindowAttributes attr;
-	XGetWindowAttributes(_twm_data.display, window, &attr);
+			BOOL wasKeyDown = (keyFlags & KF_REPEAT) == KF_REPEAT;
 
-	return (attr.map_state == IsViewable);
-}
+			if (wasKeyDown) return 0;
 
-void twm_move_window(twm_window window, int x, int y, int width, int height) {
-	twm_window_data* data = twm_get_window_data(window);
-	
-	int new_x = x, new_y = y;
-	int new_width = width, new_height = height;
+			unsigned short vkCode = twm_resolve_key(keyFlags, msg->wParam, msg->lParam);
 
-	if (x == TWM_CURRENT || x == TWM_CENTER) new_x = data->x;
-	if (y == TWM_CURRENT || y == TWM_CENTER) new_y = data->y;
+			if (vkCode == VK_LCONTROL && GetAsyncKeyState(VK_RMENU) & 0x8000) return 0;
 
-	int screen = twm_screen_from_position(new_x, new_y);
-	twm_rect screen_rect;
-	twm_screen_rect(screen, &screen_rect);
+			evt->type = TWM_EVENT_KEY_DOWN;
+			evt->keyboard.window = msg->hwnd;
+			evt->keyboard.key = vkCode;
+			evt->keyboard.modifiers = _twm_data.keyboard.modifiers = twm_get_keymods();
 
-	if (width == TWM_CURRENT || width == TWM_STRETCH) new_width = data->width;
-	if (height == TWM_CURRENT || height == TWM_STRETCH) new_height = data->height;
+			_twm_data.keyboard.keys[vkCode] = true;
 
-	if (width == TWM_STRETCH) new_width = screen_rect.width - new_x;
-	if (height == TWM_STRETCH) new_height = screen_rect.height - new_y;
+			return 1;
+		}
 
-	if (x == TWM_CENTER) new_x = (screen_rect.x + (screen_rect.width - new_width)) >> 1;
-	if (y == TWM_CENTER) new_y = (screen_rect.y + (screen_rect.height - new_height)) >> 1;
+		case WM_SYSKEYUP:
+		case WM_KEYUP: {
+			unsigned short vkCode = twm_resolve_key(HIWORD(msg->lParam), msg->wParam, msg->lParam);
 
-	XMoveResizeWindow(_twm_data.display, window, new_x, new_y, new_width, new_height);
-	XFlush(_twm_data.display);
+			if (vkCode == VK_LCONTROL && GetAsyncKeyState(VK_RMENU)) return 0;
 
-	data->x = new_x;
-	data->y = new_y;
-}
+			evt->type = TWM_EVENT_KEY_UP;
+			evt->keyboard.window = msg->hwnd;
+			evt->keyboard.key = vkCode;
+			evt->keyboard.modifiers = _twm_data.keyboard.modifiers = twm_get_keymods();
 
-int twm_window_width(twm_window window) {
-	return twm_get_window_data(window)->width;
-}
+			_twm_data.keyboard.keys[vkCode] = false;
 
-int twm_window_height(twm_window window) {
-	return twm_get_window_data(window)->height;
-}
+			return 1;
+		}
 
-void twm_window_size(twm_window window, int* width, int* height) {
-	twm_window_data* data = twm_get_window_data(window);
-	*width = data->width;
-	*height = data->height;
-}
+		case WM_SYSCHAR:
+		case WM_CHAR: {
+			evt->type = TWM_EVENT_KEY_CHAR;
+			evt->keyboard.window = msg->hwnd;
+			evt->keyboard.key = twm_resolve_key(HIWORD(msg->lParam), msg->wParam, msg->lParam);
+			evt->keyboard.modifiers = twm_get_keymods();
 
-int twm_window_x(twm_window window) {
-	return twm_get_window_data(window)->x;
-}
+			wchar_t wstr = (wchar_t)msg->wParam;
 
-int twm_window_y(twm_window window) {
-	return twm_get_window_data(window)->y;
-}
+			if (wstr) {
+				WideCharToMultiByte(CP_UTF8, 0, &wstr, -1, evt->keyboard.chr, 2, NULL, NULL);
+			}
 
-void twm_window_position(twm_window window, int* x, int* y) {
-	twm_window_data* data = twm_get_window_data(window);
-	*x = data->x;
-	*y = data->y;
-}
+			return 1;
+		}
 
-void twm_window_rect(twm_window window, twm_rect* rect) {
-	twm_window_data* data = twm_get_window_data(window);
-	rect->x = data->x;
-	rect->y = data->y;
-	rect->width = data->width;
-	rect->height = data->height;
-}
+		default:
+			break;
+	}
 
-void twm_title_window(twm_window window, const char * title) {
-	XStoreName(_twm_data.display, window, title);
-	XSetIconName(_twm_data.display, window, title);
+	return 0;
 }
 
-#define MWM_HINTS_FUNCTIONS   (1L << 0)
-#define MWM_HINTS_DECORATIONS (1L << 1)
+static void _twm_platform_wait_event(twm_event* evt) {
+	if (_twm_pop_event(evt)) return;
 
-#define MWM_DECOR_ALL         (1L << 0)
-#define MWM_DECOR_BORDER      (1L << 1)
-#define MWM_DECOR_RESIZEH     (1L << 2)
-#define MWM_DECOR_TITLE       (1L << 3)
-#define MWM_DECOR_MENU        (1L << 4)
-#define MWM_DECOR_MINIMIZE    (1L << 5)
-#define MWM_DECOR_MAXIMIZE    (1L << 6)
+	MSG msg;
+	while (GetMessage(&msg, NULL, 0, 0)) {
+		if (_twm_translate_event(&msg, evt)) return;
+		if (_twm_pop_event(evt)) return;
+		if (!PeekMessage(&msg, NULL, 0, 0, PM_NOREMOVE) && _twm_flush_rawmouse(evt)) return;
+	}
+}
 
-struct MotifWmHints {
-	unsigned long flags;
-	unsigned long functions;
-	unsigned long decorations;
-	long input_mode;
-	unsigned long status;
-};
+static int _twm_platform_wait_event_timeout(twm_event* evt, double seconds) {
+	double deadline = twm_time() + seconds;
 
-void twm_window_borderless(twm_window window, bool enable) {
-	XWindowAttributes attr;
-	XGetWindowAttributes(_twm_data.display, window, &attr);
+	for (;;) {
+		if (_twm_platform_peek_event(evt)) return 1;
 
-	struct MotifWmHints hints = {0};
-	hints.flags = MWM_HINTS_DECORATIONS;
-	hints.decorations = !enable ? MWM_DECOR_TITLE | MWM_DECOR_BORDER : 0;
+		DWORD timeout = INFINITE;
 
-	Atom prop = XInternAtom(_twm_data.display, "_MOTIF_WM_HINTS", False);
-	XChangeProperty(_twm_data.display, window, prop, prop, 32, PropModeReplace, (unsigned char*)&hints, 5);
-	XFlush(_twm_data.display);
+		if (seconds >= 0.0) {
+			double remaining = deadline - twm_time();
 
-	twm_window_data* data = twm_get_window_data(window);
+			if (remaining <= 0.0) return 0;
 
-	if (enable) {
-		data->flags |= TWM_WINDOW_BORDERLESS;
+			timeout = (DWORD)ceil(remaining * 1000.0);
+		}
 
-		XResizeWindow(_twm_data.display, window, attr.width, attr.height);
-		XFlush(_twm_data.display);
-	}
-	else {
-		data->flags &= ~TWM_WINDOW_BORDERLESS;
+		if (MsgWaitForMultipleObjectsEx(0, NULL, timeout, QS_ALLINPUT, MWMO_INPUTAVAILABLE) == WAIT_TIMEOUT) return 0;
 	}
 }
 
-bool twm_window_is_borderless(twm_window window) {
-	return twm_get_window_data(window)->flags & TWM_WINDOW_BORDERLESS;
+int twm_connection_fd() {
+	return -1;
 }
 
-void twm_window_fullscreen(twm_window window, bool enable) {
-    Atom wm_state = XInternAtom(_twm_data.display, "_NET_WM_STATE", False);
-    Atom fullscreen = XInternAtom(_twm_data.display, "_NET_WM_STATE_FULLSCREEN", False);
-
-    XEvent xev = {0};
-    xev.xclient.type = ClientMessage;
-    xev.xclient.window = window;
-    xev.xclient.message_type = wm_state;
-    xev.xclient.format = 32;
-    xev.xclient.data.l[0] = enable ? 1 : 0;
-    xev.xclient.data.l[1] = fullscreen;
-    xev.xclient.data.l[2] = 0;
-    xev.xclient.data.l[3] = 1;
-    xev.xclient.data.l[4] = 0;
+bool twm_watch_fd(int fd) {
+	return false;
+}
 
-    XSendEvent(_twm_data.display, DefaultRootWindow(_twm_data.display), False, SubstructureRedirectMask | SubstructureNotifyMask, &xev);
+void twm_unwatch_fd(int fd) {
+}
 
-	twm_window_data * data = twm_get_window_data(window);
+static int _twm_platform_peek_event(twm_event* evt) {
+	if (_twm_pop_event(evt)) return 1;
 
-	if (enable) {
-		data->flags |= TWM_WINDOW_BORDERLESS | TWM_WINDOW_FULLSCREEN;
-	}
-	else {
-		data->flags &= ~(TWM_WINDOW_BORDERLESS | TWM_WINDOW_FULLSCREEN);
+	MSG msg;
+	while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE)) {
+		if (_twm_translate_event(&msg, evt)) return 1;
+		if (_twm_pop_event(evt)) return 1;
 	}
-}
 
-bool twm_window_is_fullscreen(twm_window window) {
-	return twm_get_window_data(window)->flags & TWM_WINDOW_FULLSCREEN;
+	return _twm_flush_rawmouse(evt);
 }
 
-void twm_cursor_position(int* x, int* y) {
-	int win_x, win_y;
-	unsigned int mask;
-	Window child, root_return;
+bool twm_post_event(const twm_event* evt) {
+	if (!_twm_post_push(evt)) return false;
 
-	XQueryPointer(_twm_data.display, DefaultRootWindow(_twm_data.display), &root_return, &child, x, y, &win_x, &win_y, &mask);
-}
+	// A thread message with no window only wakes GetMessage/MsgWaitForMultipleObjects
+	PostThreadMessage(_twm_data.thread_id, WM_NULL, 0, 0);
 
-void twm_move_cursor(int x, int y) {
-	XWarpPointer(_twm_data.display, None, DefaultRootWindow(_twm_data.display), 0, 0, 0, 0, x, y);
-    XFlush(_twm_data.display);
+	return true;
 }
 
-void twm_clip_cursor(twm_window window) {
-	XGrabPointer(_twm_data.display, window, True, ButtonPressMask | ButtonReleaseMask | PointerMotionMask, GrabModeAsync, GrabModeAsync, window, None, CurrentTime);
-	XFlush(_twm_data.display);
-}
+static int _twm_platform_peek_events(twm_event* events, int max) {
+	int count = 0;
+	while (count < max && _twm_platform_peek_event(&events[count])) count++;
 
-void twm_unclip_cursor() {
-	XUngrabPointer(_twm_data.display, CurrentTime);
-	XFlush(_twm_data.display);
+	return count;
 }
 
-void twm_show_cursor(bool flag) {
-	XDefineCursor(_twm_data.display, DefaultRootWindow(_twm_data.display), _twm_data.cursor[flag ? TWM_X11_CURSOR_DEFAULT : TWM_X11_CURSOR_INVISIBLE]);
-	XFlush(_twm_data.display);
+LRESULT CALLBACK _twm_window_proc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
+	twm_window_data* data = twm_get_window_data(hWnd);
 
-	_twm_data.cursor_visible = flag;
-}
+	switch (uMsg) {
+	case WM_ACTIVATE: {
+		WORD state = LOWORD(wParam);
 
-bool twm_cursor_is_visible() {
-	return _twm_data.cursor_visible;
-}
+		if (state == WA_ACTIVE || state == WA_CLICKACTIVE) {
+			if (!IsIconic(hWnd)) {
+				PostMessage(hWnd, WM_WINDOW_ACTIVE, wParam, lParam);
+			}
+		}
+		else if (state == WA_INACTIVE) {
+			PostMessage(hWnd, WM_WINDOW_INACTIVE, wParam, lParam);
+		}
+		break;
+	}
 
-void twm_set_window_ptr(twm_window window, void * ptr) {
-	twm_window_data* data = twm_get_window_data(window);
+	case WM_NCHITTEST: {
+		if (!(data->flags & TWM_WINDOW_RESIZABLE) || _twm_data.clip != NULL) break;
 
-	data->ptr = ptr;
-}
+		POINT pt = { GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam) };
+		ScreenToClient(hWnd, &pt);
 
-void * twm_get_window_ptr(twm_window window) {
-	return twm_get_window_data(window)->ptr;
-}
+		RECT rc;
+		GetClientRect(hWnd, &rc);
 
-void twm_set_window_property(twm_window window, const char * name, int size, const void* value) {
-	Atom property = XInternAtom(_twm_data.display, name, False);
+		int borderX = GetSystemMetrics(SM_CXSIZEFRAME);
+		int borderY = GetSystemMetrics(SM_CYSIZEFRAME);
 
-	XChangeProperty(_twm_data.display, window, property, XA_CARDINAL, 8,
-		PropModeReplace, (const unsigned char*)value, size);
-}
+		if (pt.y < borderY && pt.x < borderX) return HTTOPLEFT;
+		if (pt.y < borderY && pt.x > rc.right - borderX) return HTTOPRIGHT;
+		if (pt.y > rc.bottom - borderY && pt.x < borderX) return HTBOTTOMLEFT;
+		if (pt.y > rc.bottom - borderY && pt.x > rc.right - borderX) return HTBOTTOMRIGHT;
+		if (pt.y < -borderY) return HTTOP;
+		if (pt.y > rc.bottom) return HTBOTTOM;
+		if (pt.x < borderX) return HTLEFT;
+		if (pt.x > rc.right - borderX) return HTRIGHT;
 
-bool twm_get_window_property(twm_window window, const char * name, int size, void* value_out) {
-	Atom property = XInternAtom(_twm_data.display, name, False);
-	Atom actual_type;
-	int actual_format;
-	unsigned long nitems, bytes_after;
-	unsigned char* prop = NULL;
+		return HTCLIENT;
+	}
 
-	int status = XGetWindowProperty(_twm_data.display, window, property, 0, size, False,
-		XA_CARDINAL, &actual_type, &actual_format,
-		&nitems, &bytes_after, &prop);
+	case WM_SIZE: {
+		if (data == NULL) break;
+		if (data->disable_events) break;
 
-	if (status == Success && prop != NULL && actual_format == 8) {
-		memcpy(value_out, prop, (nitems < size) ? nitems : size);
-		XFree(prop);
-		return 1;
-	}
+		int newWidth = LOWORD(lParam);
+		int newHeight = HIWORD(lParam);
 
-	if (prop) XFree(prop);
-	return 0;
-}
+		if (newWidth == 0 || newHeight == 0) break;
 
-void twm_free_window_property(twm_window window, const char* name) {
-	Atom property = XInternAtom(_twm_data.display, name, False);
-	XDeleteProperty(_twm_data.display, window, property);
-}
+		switch (wParam) {
+		case SIZE_RESTORED:
+			if (data->last_state != SIZE_RESTORED || newWidth != data->width || newHeight != data->height) {
+				data->width = newWidth;
+				data->height = newHeight;
+				data->was_resized = true;
 
-static inline twm_keymod twm_get_keymods() {
-	char keys[32];
-	XQueryKeymap(_twm_data.display, keys);
-
-	twm_keymod mods = TWM_KEYMOD_NONE;
-
-	#define IS_KEY_DOWN(code) (keys[(code) >> 3] & (1 << ((code) & 7)))
-
-	KeyCode lshift = XKeysymToKeycode(_twm_data.display, XK_Shift_L);
-	KeyCode rshift = XKeysymToKeycode(_twm_data.display, XK_Shift_R);
-	KeyCode lctrl  = XKeysymToKeycode(_twm_data.display, XK_Control_L);
-	KeyCode rctrl  = XKeysymToKeycode(_twm_data.display, XK_Control_R);
-	KeyCode lalt   = XKeysymToKeycode(_twm_data.display, XK_Alt_L);
-	KeyCode ralt   = XKeysymToKeycode(_twm_data.display, XK_Alt_R);
-	KeyCode lwin   = XKeysymToKeycode(_twm_data.display, XK_Super_L);
-	KeyCode rwin   = XKeysymToKeycode(_twm_data.display, XK_Super_R);
-	KeyCode menu   = XKeysymToKeycode(_twm_data.display, XK_Menu);
-	KeyCode numlock    = XKeysymToKeycode(_twm_data.display, XK_Num_Lock);
-	KeyCode scrolllock = XKeysymToKeycode(_twm_data.display, XK_Scroll_Lock);
-	KeyCode capslock   = XKeysymToKeycode(_twm_data.display, XK_Caps_Lock);
-
-	if (IS_KEY_DOWN(lshift)) {
-		mods |= TWM_KEYMOD_SHIFT | TWM_KEYMOD_LSHIFT;
-	}
-	if (IS_KEY_DOWN(rshift)) {
-		mods |= TWM_KEYMOD_SHIFT | TWM_KEYMOD_RSHIFT;
-	}
-	if (IS_KEY_DOWN(lctrl)) {
-		mods |= TWM_KEYMOD_CTRL | TWM_KEYMOD_LCTRL;
-	}
-	if (IS_KEY_DOWN(rctrl)) {
-		mods |= TWM_KEYMOD_CTRL | TWM_KEYMOD_RCTRL;
-	}
-	if (IS_KEY_DOWN(lalt)) {
-		mods |= TWM_KEYMOD_ALT | TWM_KEYMOD_LALT;
-	}
-	if (IS_KEY_DOWN(ralt)) {
-		mods |= TWM_KEYMOD_ALT | TWM_KEYMOD_RALT;
-	}
-	if (IS_KEY_DOWN(lwin)) {
-		mods |= TWM_KEYMOD_LWIN;
-	}
-	if (IS_KEY_DOWN(rwin)) {
-		mods |= TWM_KEYMOD_RWIN;
-	}
-	if (IS_KEY_DOWN(menu)) {
-		mods |= TWM_KEYMOD_MENU;
-	}
-	if (IS_KEY_DOWN(numlock)) {
-		mods |= TWM_KEYMOD_NUMLOCK;
-	}
-	if (IS_KEY_DOWN(scrolllock)) {
-		mods |= TWM_KEYMOD_SCROLLLOCK;
-	}
-	if (IS_KEY_DOWN(capslock)) {
-		mods |= TWM_KEYMOD_CAPSLOCK;
-	}
+				PostMessage(hWnd, WM_WINDOW_SIZE, newWidth, newHeight);
+			}
 
-	return mods;
-}
+			else if (data->last_state != SIZE_RESTORED) {
+				PostMessage(hWnd, WM_WINDOW_RESTORE, newWidth, newHeight);
+			}
+			break;
+		case SIZE_MINIMIZED:
+			PostMessage(hWnd, WM_WINDOW_SIZE, newWidth, newHeight);
+			PostMessage(hWnd, WM_WINDOW_MINIMIZE, newWidth, newHeight);
+			data->width = newWidth;
+			data->height = newHeight;
+			data->was_resized = true;
+			break;
+		case SIZE_MAXIMIZED:
+			PostMessage(hWnd, WM_WINDOW_SIZE, newWidth, newHeight);
+			PostMessage(hWnd, WM_WINDOW_MAXIMIZE, newWidth, newHeight);
+			data->width = newWidth;
+			data->height = newHeight;
+			data->was_resized = true;
+			break;
+		}
 
-static inline int _twm_translate_event(twm_event * evt) {
-	XEvent ev;
-	XNextEvent(_twm_data.display, &ev);
-	
-	switch (ev.type) {
-		case MapNotify:
-			XSetInputFocus(ev.xmap.display, ev.xmap.window, RevertToParent, CurrentTime);
-			XFlush(ev.xmap.display);
+		data->last_state = wParam;
 		break;
+	}
 
-		case GenericEvent: {
-			if (ev.xcookie.extension == _twm_data.opcode && XGetEventData(_twm_data.display, &ev.xcookie)) {
-				if (ev.xcookie.evtype == XI_RawMotion) {
-					XIRawEvent* re = (XIRawEvent*)ev.xcookie.data;
+	case WM_MOVE: {
+		if (data == NULL) break;
+		if (data->disable_events) break;
+		if (IsIconic(hWnd)) break;
 
-					double dx = 0.0, dy = 0.0;
-					int valuators = 0;
+		int newX = LOWORD(lParam);
+		int newY = HIWORD(lParam);
 
-					for (int i = 0; i < re->valuators.mask_len * 8; i++) {
-						if (XIMaskIsSet(re->valuators.mask, i)) {
-							double val = re->raw_values[valuators++];
-							if (i == 0) dx = val;
-							if (i == 1) dy = val;
-						}
-					}
+		RECT r = { 0, 0, 0, 0 };
+		AdjustWindowRectEx(& r, GetWindowLong(hWnd, GWL_STYLE), FALSE, GetWindowLong(hWnd, GWL_EXSTYLE));
 
-					evt->type = TWM_EVENT_RAWMOUSE_MOVE;
-					_twm_data.mouse.dx = evt->rawmouse.dx = (int)dx;
-					_twm_data.mouse.dy = evt->rawmouse.dy = (int)dy;
-				}
-				XFreeEventData(_twm_data.display, &ev.xcookie);
+		if (newX != data->x - r.left || newY != data->y - r.top) {
+			data->x = newX;
+			data->y = newY;
 
-				return 1;
+			if (!IsZoomed(hWnd)) {
+				newX += r.left;
+				newY += r.top;
 			}
 
-			break;
+			if (!data->resizing) {
+				PostMessage(hWnd, WM_WINDOW_MOVE, newX, newY);
+			}
 		}
+		break;
+	}
 
-		case ClientMessage: {
-			if (ev.xclient.data.l[0] == _twm_data.atom[TWM_X11_ATOM_DELETE]) {
-				evt->type = TWM_EVENT_WINDOW_CLOSE;
-				evt->window.window = ev.xclient.window;
-
-				twm_window_data* data = twm_get_window_data(ev.xproperty.window);
-
-				data->was_closed = true;
+	case WM_NCLBUTTONDOWN:
+		if (wParam == HTCAPTION || (wParam >= HTLEFT && wParam <= HTBOTTOMRIGHT)) {
+			GetCursorPos(&data->last_mouse);
+			GetWindowRect(hWnd, &data->original_rect);
+			SetCapture(hWnd);
 
-				return 1;
+			if (wParam == HTCAPTION) {
+				data->dragging = TRUE;
 			}
-			else if (ev.xclient.message_type == _twm_data.atom[TWM_X11_ATOM_CHAR]) {
-				evt->type = TWM_EVENT_KEY_CHAR;
-				evt->keyboard.window = ev.xclient.window;
-				evt->keyboard.modifiers = twm_get_keymods();
-
-				evt->keyboard.key = ev.xclient.data.b[0];
-				evt->keyboard.chr[0] = ev.xclient.data.b[1];
-				evt->keyboard.chr[1] = ev.xclient.data.b[2];
-				evt->keyboard.chr[2] = ev.xclient.data.b[3];
-				evt->keyboard.chr[3] = ev.xclient.data.b[4];
-				evt->keyboard.chr[4] = ev.xclient.data.b[5];
-
-				return 1;
+			else {
+				data->resizing = TRUE;
+				data->resize_edge = wParam;
 			}
-
-			break;
 		}
+		break;
 
-		case PropertyNotify: {
-			if (ev.xproperty.atom == _twm_data.atom[TWM_X11_ATOM_NET_WM_STATE]) {
-				twm_window_data* data = twm_get_window_data(ev.xproperty.window);
-
-				Atom actual_type;
-				int actual_format;
-				unsigned long nitems, bytes_after;
-				unsigned char* prop = NULL;
-
-				if (XGetWindowProperty(ev.xproperty.display, ev.xproperty.window, _twm_data.atom[TWM_X11_ATOM_NET_WM_STATE], 0, (~0L), False, XA_ATOM,
-					&actual_type, &actual_format,
-					&nitems, &bytes_after, &prop) == Success && prop)
-				{
-					int maximized = 0, minimized = 0;
-
-					for (unsigned long i = 0; i < nitems; ++i) {
-						Atom state = ((Atom*)prop)[i];
-						if (state == _twm_data.atom[TWM_X11_ATOM_NET_WM_STATE_MAX_HORZ] || state == _twm_data.atom[TWM_X11_ATOM_NET_WM_STATE_MAX_VERT])
-							maximized++;
-						if (state == _twm_data.atom[TWM_X11_ATOM_NET_WM_STATE_HIDDEN])
-							minimized = 1;
-					}
+	case WM_MOUSELEAVE:
+		data->tracking_mouse = FALSE;
+		break;
 
-					XFree(prop);
+	case WM_MOUSEMOVE:
+		if (!data->tracking_mouse) {
+			TRACKMOUSEEVENT tme = { 0 };
+			tme.cbSize = sizeof(tme);
+			tme.dwFlags = TME_LEAVE;
+			tme.hwndTrack = hWnd;
+			TrackMouseEvent(&tme);
+			data->tracking_mouse = TRUE;
 
-					if (minimized) {
-						if (data->state != 1) {
-							data->state = 1;
-							evt->type = TWM_EVENT_WINDOW_MINIMIZE;
-							evt->window.window = ev.xclient.window;
+			PostMessage(hWnd, WM_MOUSEHOVER, wParam, lParam);
+		}
 
-							return 1;
-						}
-					}
-					else if (maximized >= 2) {
-						if (data->state != 2) {
-							data->state = 2;
-							evt->type = TWM_EVENT_WINDOW_MAXIMIZE;
-							evt->window.window = ev.xclient.window;
+		if (data->dragging || data->resizing) {
+			if (IsZoomed(hWnd)) return 0;
+			
+			POINT current;
+			GetCursorPos(&current);
+			int dx = current.x - data->last_mouse.x;
+			int dy = current.y - data->last_mouse.y;
 
-							return 1;
-						}
-					}
-					else if (data->state != 0) {
-						data->state = 0;
-						evt->type = TWM_EVENT_WINDOW_RESTORE;
-						evt->window.window = ev.xclient.window;
+			RECT newRect = data->original_rect;
 
-						return 1;
-					}
+			if (data->dragging) {
+				OffsetRect(&newRect, dx, dy);
+			}
+			else if (data->resizing) {
+				switch (data->resize_edge) {
+				case HTLEFT:       newRect.left += dx; break;
+				case HTRIGHT:      newRect.right += dx; break;
+				case HTTOP:        newRect.top += dy; break;
+				case HTBOTTOM:     newRect.bottom += dy; break;
+				case HTTOPLEFT:    newRect.left += dx; newRect.top += dy; break;
+				case HTTOPRIGHT:   newRect.right += dx; newRect.top += dy; break;
+				case HTBOTTOMLEFT: newRect.left += dx; newRect.bottom += dy; break;
+				case HTBOTTOMRIGHT:newRect.right += dx; newRect.bottom += dy; break;
 				}
 			}
 
-			break;
-		}
-
-		case ConfigureNotify: {
-			twm_window_data* data = twm_get_window_data(ev.xconfigure.window);
+			SetWindowPos(hWnd, NULL, newRect.left, newRect.top,
+				newRect.right - newRect.left,
+				newRect.bottom - newRect.top,
+				SWP_NOZORDER | SWP_NOACTIVATE);
 
-			if (data->width != ev.xconfigure.width || data->height != ev.xconfigure.height) {
-				evt->type = TWM_EVENT_WINDOW_SIZE;
-				evt->window.window = ev.xconfigure.window;
-				evt->window.width = data->width = ev.xconfigure.width;
-				evt->window.height = data->height = ev.xconfigure.height;
-				evt->window.x = ev.xconfigure.x;
-				evt->window.y = ev.xconfigure.y;
+			return 0;
+		}
+		break;
 
-				data->was_resized = true;
-
-				return 1;
-			}
-
-			Window root, child;
-			int x, y;
-			unsigned int width, height, border_width, depth;
-			XGetGeometry(ev.xconfigure.display, ev.xconfigure.window, &root, &x, &y, &width, &height, &border_width, &depth);
-
-			if ((x != ev.xconfigure.x || y != ev.xconfigure.y) && (data->x != ev.xconfigure.x || data->y != ev.xconfigure.y)) {
-				evt->type = TWM_EVENT_WINDOW_MOVE;
-				evt->window.window = ev.xconfigure.window;
-				evt->window.x = data->x = ev.xconfigure.x;
-				evt->window.y = data->y = ev.xconfigure.y;
-				evt->window.width = ev.xconfigure.width;
-				evt->window.height = ev.xconfigure.height;
-
-				return 1;
-			}
-
-			break;
-		}
-
-		case FocusIn: {
-			if ((ev.xfocus.mode == NotifyNormal || ev.xfocus.mode == NotifyUngrab) && (ev.xfocus.detail == NotifyNonlinear || ev.xfocus.detail == NotifyNonlinearVirtual)) {
-				evt->type = TWM_EVENT_WINDOW_ACTIVE;
-				evt->window.window = ev.xfocus.window;
-
-				return 1;
-			}
-
-			break;
-		}
-
-		case FocusOut: {
-			if ((ev.xfocus.mode == NotifyNormal || ev.xfocus.mode == NotifyGrab) && ev.xfocus.detail != NotifyInferior) {
-				evt->type = TWM_EVENT_WINDOW_INACTIVE;
-				evt->window.window = ev.xfocus.window;
-
-				return 1;
-			}
-
-			break;
-		}
-
-		case ButtonPress: {
-			switch (ev.xbutton.button) {
-				case 1: {
-					evt->type = TWM_EVENT_MOUSE_DOWN;
-					evt->mouse.button = TWM_MB_LEFT;
-					evt->mouse.x = ev.xbutton.x;
-					evt->mouse.y = ev.xbutton.y;
-					evt->mouse.z = evt->mouse.w = 0;
-					evt->mouse.window = ev.xbutton.window;
-					_twm_data.mouse.buttons[evt->mouse.button] = true;
-
-					return 1;
-				}
-				case 2: {
-					evt->type = TWM_EVENT_MOUSE_DOWN;
-					evt->mouse.button = TWM_MB_MIDDLE;
-					evt->mouse.x = ev.xbutton.x;
-					evt->mouse.y = ev.xbutton.y;
-					evt->mouse.z = evt->mouse.w = 0;
-					evt->mouse.window = ev.xbutton.window;
-					_twm_data.mouse.buttons[evt->mouse.button] = true;
-
-					return 1;
-				}
-				case 3: {
-					evt->type = TWM_EVENT_MOUSE_DOWN;
-					evt->mouse.button = TWM_MB_RIGHT;
-					evt->mouse.x = ev.xbutton.x;
-					evt->mouse.y = ev.xbutton.y;
-					evt->mouse.z = evt->mouse.w = 0;
-					evt->mouse.window = ev.xbutton.window;
-					_twm_data.mouse.buttons[evt->mouse.button] = true;
-
-					return 1;
-				}
-				case 4: {
-					evt->type = TWM_EVENT_MOUSE_WHEEL;
-					evt->mouse.button = TWM_MB_RIGHT;
-					evt->mouse.x = ev.xbutton.x;
-					evt->mouse.y = ev.xbutton.y;
-					evt->mouse.z = 1;
-					evt->mouse.w = 0;
-					evt->mouse.window = ev.xbutton.window;
-
-					return 1;
-				}
-				case 5: {
-					evt->type = TWM_EVENT_MOUSE_WHEEL;
-					evt->mouse.button = TWM_MB_RIGHT;
-					evt->mouse.x = ev.xbutton.x;
-					evt->mouse.y = ev.xbutton.y;
-					evt->mouse.z = -1;
-					evt->mouse.w = 0;
-					evt->mouse.window = ev.xbutton.window;
-
-					return 1;
-				}
-				case 6: {
-					evt->type = TWM_EVENT_MOUSE_WHEEL;
-					evt->mouse.button = TWM_MB_RIGHT;
-					evt->mouse.x = ev.xbutton.x;
-					evt->mouse.y = ev.xbutton.y;
-					evt->mouse.z = 0;
-					evt->mouse.w = 1;
-					evt->mouse.window = ev.xbutton.window;
-
-					return 1;
-				}
-				case 7: {
-					evt->type = TWM_EVENT_MOUSE_WHEEL;
-					evt->mouse.button = TWM_MB_RIGHT;
-					evt->mouse.x = ev.xbutton.x;
-					evt->mouse.y = ev.xbutton.y;
-					evt->mouse.z = 0;
-					evt->mouse.w = -1;
-					evt->mouse.window = ev.xbutton.window;
+	case WM_LBUTTONDOWN:
+	case WM_MBUTTONDOWN:
+	case WM_RBUTTONDOWN:
+	case WM_XBUTTONDOWN:
+		SetCapture(hWnd);
+		break;
 
-					return 1;
-				}
-				case 8: {
-					evt->type = TWM_EVENT_MOUSE_DOWN;
-					evt->mouse.button = TWM_MB_X1;
-					evt->mouse.x = ev.xbutton.x;
-					evt->mouse.y = ev.xbutton.y;
-					evt->mouse.z = evt->mouse.w = 0;
-					evt->mouse.window = ev.xbutton.window;
-					_twm_data.mouse.buttons[evt->mouse.button] = true;
+	case WM_LBUTTONUP:
+	case WM_MBUTTONUP:
+	case WM_RBUTTONUP:
+	case WM_XBUTTONUP:
+	case WM_NCLBUTTONUP:
+		data->dragging = FALSE;
+		data->resizing = FALSE;
+		ReleaseCapture();
+		break;
 
-					return 1;
-				}
-				case 9: {
-					evt->type = TWM_EVENT_MOUSE_DOWN;
-					evt->mouse.button = TWM_MB_X2;
-					evt->mouse.x = ev.xbutton.x;
-					evt->mouse.y = ev.xbutton.y;
-					evt->mouse.z = evt->mouse.w = 0;
-					evt->mouse.window = ev.xbutton.window;
-					_twm_data.mouse.buttons[evt->mouse.button] = true;
+	case WM_CLOSE:
+		PostMessage(hWnd, WM_WINDOW_CLOSE, wParam, lParam);
+		data->was_closed = TRUE;
+		return 0;
 
-					return 1;
-				}
-				default:
-					break;
-			}
+	case WM_SYSKEYDOWN:
+		if (wParam == VK_F4 && (GetAsyncKeyState(VK_MENU) & 0x8000)) {
 			break;
 		}
+		return 0;
+	}
 
-		case ButtonRelease: {
-			switch (ev.xbutton.button) {
-				case 1: {
-					evt->type = TWM_EVENT_MOUSE_UP;
-					evt->mouse.button = TWM_MB_LEFT;
-					evt->mouse.x = ev.xbutton.x;
-					evt->mouse.y = ev.xbutton.y;
-					evt->mouse.z = evt->mouse.w = 0;
-					evt->mouse.window = ev.xbutton.window;
-					_twm_data.mouse.buttons[evt->mouse.button] = false;
-
-					return 1;
-				}
-				case 2: {
-					evt->type = TWM_EVENT_MOUSE_UP;
-					evt->mouse.button = TWM_MB_MIDDLE;
-					evt->mouse.x = ev.xbutton.x;
-					evt->mouse.y = ev.xbutton.y;
-					evt->mouse.z = evt->mouse.w = 0;
-					evt->mouse.window = ev.xbutton.window;
-					_twm_data.mouse.buttons[evt->mouse.button] = false;
-
-					return 1;
-				}
-				case 3: {
-					evt->type = TWM_EVENT_MOUSE_UP;
-					evt->mouse.button = TWM_MB_RIGHT;
-					evt->mouse.x = ev.xbutton.x;
-					evt->mouse.y = ev.xbutton.y;
-					evt->mouse.z = evt->mouse.w = 0;
-					evt->mouse.window = ev.xbutton.window;
-					_twm_data.mouse.buttons[evt->mouse.button] = false;
+	return DefWindowProc(hWnd, uMsg, wParam, lParam);
+}
 
-					return 1;
-				}
-				case 8: {
-					evt->type = TWM_EVENT_MOUSE_UP;
-					evt->mouse.button = TWM_MB_X1;
-					evt->mouse.x = ev.xbutton.x;
-					evt->mouse.y = ev.xbutton.y;
-					evt->mouse.z = evt->mouse.w = 0;
-					evt->mouse.window = ev.xbutton.window;
-					_twm_data.mouse.buttons[evt->mouse.button] = false;
+struct _twm_framebuffer {
+	HWND hwnd;
+	HDC memdc;
+	int width, height;
+	int back;
+	struct {
+		HBITMAP bitmap;
+		unsigned int* pixels;
+	} buffer[2];
+};
 
-					return 1;
-				}
-				case 9: {
-					evt->type = TWM_EVENT_MOUSE_UP;
-					evt->mouse.button = TWM_MB_X2;
-					evt->mouse.x = ev.xbutton.x;
-					evt->mouse.y = ev.xbutton.y;
-					evt->mouse.z = evt->mouse.w = 0;
-					evt->mouse.window = ev.xbutton.window;
-					_twm_data.mouse.buttons[evt->mouse.button] = false;
+static inline void _twm_free_framebuffer_buffers(twm_framebuffer framebuffer) {
+	for (int i = 0; i < 2; i++) {
+		if (framebuffer->buffer[i].bitmap) DeleteObject(framebuffer->buffer[i].bitmap);
 
-					return 1;
-				}
-				default:
-					break;
-			}
-			break;
-		}
+		framebuffer->buffer[i].bitmap = NULL;
+		framebuffer->buffer[i].pixels = NULL;
+	}
+}
 
-		case MotionNotify: {
-			twm_window_data* data = twm_get_window_data(ev.xmotion.window);
+static inline bool _twm_alloc_framebuffer_buffers(twm_framebuffer framebuffer, int width, int height) {
+	BITMAPINFO bmi = { 0 };
+	bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+	bmi.bmiHeader.biWidth = width;
+	bmi.bmiHeader.biHeight = -height;
+	bmi.bmiHeader.biPlanes = 1;
+	bmi.bmiHeader.biBitCount = 32;
+	bmi.bmiHeader.biCompression = BI_RGB;
 
-			if (ev.xmotion.x >= 0 && ev.xmotion.y >= 0 && ev.xmotion.x < data->width && ev.xmotion.y < data->height) {
-				evt->type = TWM_EVENT_MOUSE_MOVE;
-				_twm_data.mouse.x = evt->mouse.x = ev.xmotion.x;
-				_twm_data.mouse.y = evt->mouse.y = ev.xmotion.y;
-				evt->mouse.window = ev.xbutton.window;
+	for (int i = 0; i < 2; i++) {
+		framebuffer->buffer[i].bitmap = CreateDIBSection(framebuffer->memdc, &bmi, DIB_RGB_COLORS, (void**)&framebuffer->buffer[i].pixels, NULL, 0);
 
-				return 1;
-			}
+		if (!framebuffer->buffer[i].bitmap) {
+			_twm_free_framebuffer_buffers(framebuffer);
 
-			break;
+			return false;
 		}
+	}
 
-		case EnterNotify:
-			if (ev.type == EnterNotify && ev.xcrossing.mode == NotifyNormal && ev.xcrossing.detail != NotifyInferior) {
-				evt->type = TWM_EVENT_MOUSE_ENTER;
-				evt->window.window = ev.xbutton.window;
-
-				return 1;
-			}
-			break;
-
-		case LeaveNotify:
-			if (ev.type == LeaveNotify && ev.xcrossing.mode == NotifyNormal && ev.xcrossing.detail != NotifyInferior) {
-				evt->type = TWM_EVENT_MOUSE_LEAVE;
-				evt->window.window = ev.xbutton.window;
-
-				return 1;
-			}
-			break;
-
-		case KeyPress: {
-			evt->type = TWM_EVENT_KEY_DOWN;
-
-			evt->keyboard.key = XkbKeycodeToKeysym(_twm_data.display, ev.xkey.keycode, 0, 1) & 0x1FF;
-			evt->keyboard.modifiers = twm_get_keymods();
+	framebuffer->width = width;
+	framebuffer->height = height;
 
-			_twm_data.keyboard.keys[evt->keyboard.key] = true;
+	return true;
+}
 
-			Status status;
+twm_framebuffer twm_create_framebuffer(twm_window window) {
+	twm_framebuffer framebuffer = (twm_framebuffer)calloc(1, sizeof(struct _twm_framebuffer));
 
-			int len = Xutf8LookupString(_twm_data.xic, &ev.xkey, evt->keyboard.chr, 5, NULL, &status);
+	if (framebuffer == NULL) return NULL;
 
-			if (!XFilterEvent(&ev, ev.xany.window)) {
-				if (status == XLookupChars)
-				{
-					XEvent e = { };
-					e.xclient.type = ClientMessage;
-					e.xclient.message_type = _twm_data.atom[TWM_X11_ATOM_CHAR];
-					e.xclient.serial = 0;
-					e.xclient.send_event = 1;
-					e.xclient.format = 32;
-					e.xclient.data.b[0] = evt->keyboard.key;
-
-					for (int i = 0; i < len; i++) {
-						e.xclient.data.b[i + 1] = evt->keyboard.chr[i];
-					}
+	framebuffer->hwnd = window;
+	framebuffer->memdc = CreateCompatibleDC(NULL);
 
-					XSendEvent(ev.xkey.display, ev.xkey.window, 0, NoEventMask, &e);
-				}
-			}
+	if (!_twm_alloc_framebuffer_buffers(framebuffer, twm_window_width(window), twm_window_height(window))) {
+		DeleteDC(framebuffer->memdc);
+		free(framebuffer);
 
-			if (evt->keyboard.key <= 0) break;
+		return NULL;
+	}
 
-			return 1;
-		}
+	return framebuffer;
+}
 
-		case KeyRelease: {
-			if (XEventsQueued(ev.xkey.display, QueuedAfterReading)) {
-				XEvent e;
-				XPeekEvent(ev.xkey.display, &e);
+void twm_destroy_framebuffer(twm_framebuffer framebuffer) {
+	if (framebuffer == NULL) return;
 
-				if (e.type == KeyPress && e.xkey.time == ev.xkey.time && e.xkey.keycode == ev.xkey.keycode)
-				{
-					XNextEvent(ev.xkey.display, &ev);
+	_twm_free_framebuffer_buffers(framebuffer);
+	DeleteDC(framebuffer->memdc);
+	free(framebuffer);
+}
 
-					if (!XFilterEvent(&ev, ev.xkey.window)) {
-						Status status;
+unsigned int* twm_framebuffer_pixels(twm_framebuffer framebuffer, int* width, int* height, int* stride) {
+	int window_width = twm_window_width(framebuffer->hwnd);
+	int window_height = twm_window_height(framebuffer->hwnd);
 
-						int len = Xutf8LookupString(_twm_data.xic, &ev.xkey, evt->keyboard.chr, 5, NULL, &status);
+	if (window_width != framebuffer->width || window_height != framebuffer->height) {
+		_twm_free_framebuffer_buffers(framebuffer);
 
-						if (status == XLookupChars) {
-							evt->type = TWM_EVENT_KEY_CHAR;
+		if (!_twm_alloc_framebuffer_buffers(framebuffer, window_width, window_height)) return NULL;
+	}
 
-							evt->keyboard.key = XkbKeycodeToKeysym(_twm_data.display, ev.xkey.keycode, 0, 1) & 0x1FF;
-							evt->keyboard.modifiers = twm_get_keymods();
+	if (width) *width = framebuffer->width;
+	if (height) *height = framebuffer->height;
+	if (stride) *stride = framebuffer->width;
 
-							return 1;
-						}
-					}
-				}
-			}
+	return framebuffer->buffer[framebuffer->back].pixels;
+}
 
-			evt->type = TWM_EVENT_KEY_UP;
+void twm_present_framebuffer(twm_framebuffer framebuffer) {
+	if (!framebuffer->buffer[framebuffer->back].bitmap) return;
 
-			evt->keyboard.key = XkbKeycodeToKeysym(_twm_data.display, ev.xkey.keycode, 0, 1) & 0x1FF;
-			evt->keyboard.modifiers = twm_get_keymods();
-			_twm_data.keyboard.keys[evt->keyboard.key] = false;
+	HDC hdc = GetDC(framebuffer->hwnd);
+	HGDIOBJ previous = SelectObject(framebuffer->memdc, framebuffer->buffer[framebuffer->back].bitmap);
 
-			return 1;
-		}
-	}
+	BitBlt(hdc, 0, 0, framebuffer->width, framebuffer->height, framebuffer->memdc, 0, 0, SRCCOPY);
 
-	return 0;
-}
+	SelectObject(framebuffer->memdc, previous);
+	ReleaseDC(framebuffer->hwnd, hdc);
 
-void twm_wait_event(twm_event * evt) {
-	while (true) {
-		if (_twm_translate_event(evt)) return;
-	}
+	framebuffer->back ^= 1;
 }
 
-int twm_peek_event(twm_event* evt) {
-	while (XPending(_twm_data.display)) {
-		if (_twm_translate_event(evt)) return 1;
-	}
+bool twm_window_present_feedback(twm_window window, bool enable) {
+	return false;
 }
 
 #ifdef TWM_GL
@@ -3887,57 +4449,45 @@ void twm_gl_set_pixel_attribs(int pixel_attribs[]) {
 	while (pixel_attribs[i] != 0) {
 		switch (pixel_attribs[i]) {
 		case TWM_GL_DOUBLE_BUFFER:
-			_twm_data.pixel_attribs[9] = pixel_attribs[++i];
+			_twm_data.pixel_attribs[7] = pixel_attribs[++i];
 			break;
 		case TWM_GL_COLOR_BITS:
-			_twm_data.pixel_attribs[11] = 8;
-			_twm_data.pixel_attribs[13] = 8;
-			_twm_data.pixel_attribs[15] = 8;
-			_twm_data.pixel_attribs[17] = (pixel_attribs[i + 1] >= 32) ? 8 : 0;
+			_twm_data.pixel_attribs[9] = pixel_attribs[++i];
 			break;
 		case TWM_GL_ALPHA_BITS:
-			_twm_data.pixel_attribs[17] = pixel_attribs[++i];
+			_twm_data.pixel_attribs[11] = pixel_attribs[++i];
 			break;
 		case TWM_GL_DEPTH_BITS:
-			_twm_data.pixel_attribs[19] = pixel_attribs[++i];
+			_twm_data.pixel_attribs[13] = pixel_attribs[++i];
 			break;
 		case TWM_GL_STENCIL_BITS:
-			_twm_data.pixel_attribs[21] = pixel_attribs[++i];
+			_twm_data.pixel_attribs[15] = pixel_attribs[++i];
 			break;
 		case TWM_GL_SRGB_CAPABLE:
-			_twm_data.pixel_attribs[23] = pixel_attribs[++i];
+			_twm_data.pixel_attribs[17] = pixel_attribs[++i];
 			break;
 		case TWM_GL_SAMPLE_BUFFERS:
-			_twm_data.pixel_attribs[25] = pixel_attribs[++i];
+			_twm_data.pixel_attribs[19] = pixel_attribs[++i];
 			break;
 		case TWM_GL_SAMPLES:
-			_twm_data.pixel_attribs[27] = pixel_attribs[++i];
+			_twm_data.pixel_attribs[21] = pixel_attribs[++i];
 			break;
 		}
 		i++;
 	}
 }
 
-twm_gl_context twm_gl_create_context(twm_window window, int* attribs) {
-	twm_gl_context context = (twm_gl_context)malloc(sizeof(struct _twm_gl_context));
-
-	if (context == NULL) return NULL;
-
-	context->window = window;
-
-	XPointer out = NULL;
-	XFindContext(_twm_data.display, window, _twm_data.window_context, &out);
-	twm_window_data* data = (twm_window_data*)out;
-
+// Shares textures, buffers and other objects with share, which may be current on another thread
+twm_gl_context twm_gl_create_shared_context(twm_window window, int* attribs, twm_gl_context share) {
 	int context_attribs[] = {
-		GLX_CONTEXT_MAJOR_VERSION_ARB, 4,
-		GLX_CONTEXT_MINOR_VERSION_ARB, 6,
-		GLX_CONTEXT_PROFILE_MASK_ARB,  GLX_CONTEXT_CORE_PROFILE_BIT_ARB,
-		None
+		WGL_CONTEXT_MAJOR_VERSION_ARB, 4,
+		WGL_CONTEXT_MINOR_VERSION_ARB, 1,
+		WGL_CONTEXT_PROFILE_MASK_ARB,  WGL_CONTEXT_CORE_PROFILE_BIT_ARB,
+		0
 	};
 
 	int i = 0;
-	while (attribs[i] != 0) {
+	while (attribs && attribs[i] != 0) {
 		switch (attribs[i]) {
 		case TWM_GL_CONTEXT_MAJOR_VERSION:
 			context_attribs[1] = attribs[++i];
@@ -3950,10 +4500,10 @@ twm_gl_context twm_gl_create_context(twm_window window, int* attribs) {
 		case TWM_GL_CONTEXT_PROFILE_MASK:
 			switch (attribs[++i]) {
 			case TWM_GL_CONTEXT_CORE_PROFILE:
-				context_attribs[5] = GLX_CONTEXT_CORE_PROFILE_BIT_ARB;
+				context_attribs[5] = WGL_CONTEXT_CORE_PROFILE_BIT_ARB;
 				break;
 			case TWM_GL_CONTEXT_COMPATIBILITY_PROFILE:
-				context_attribs[5] = GLX_CONTEXT_COMPATIBILITY_PROFILE_BIT_ARB;
+				context_attribs[5] = WGL_CONTEXT_COMPATIBILITY_PROFILE_BIT_ARB;
 				break;
 			}
 			break;
@@ -3961,695 +4511,3148 @@ twm_gl_context twm_gl_create_context(twm_window window, int* attribs) {
 		i++;
 	}
 
-	context->colormap = data->colorMap;
-	context->context = _twm_data.glXCreateContextAttribsARB(_twm_data.display, data->fbconfig, 0, True, context_attribs);
-	if (context->context == NULL) return NULL;
+	twm_gl_context context = (twm_gl_context)calloc(1, sizeof(struct _twm_gl_context));
+
+	if (context == NULL) return NULL;
+
+	context->hdc = GetDC(window);
+
+	int format;
+	UINT numFormats;
+	_twm_data.wglChoosePixelFormatARB(context->hdc, _twm_data.pixel_attribs, NULL, 1, &format, &numFormats);
+	PIXELFORMATDESCRIPTOR pdf = { 0 };
+	SetPixelFormat(context->hdc, format, &pdf);
+
+	context->hwnd = window;
+	context->hglrc = _twm_data.wglCreateContextAttribsARB(context->hdc, share ? share->hglrc : NULL, context_attribs);
+
+	if (context->hglrc == NULL) {
+		ReleaseDC(context->hwnd, context->hdc);
+		free(context);
+
+		return NULL;
+	}
 
 	return context;
 }
 
-void twm_gl_delete_context(twm_gl_context context) {
-	glXMakeCurrent(NULL, None, 0);
-	glXDestroyContext(_twm_data.display, context->context);
-	XFreeColormap(_twm_data.display, context->colormap);
+twm_gl_context twm_gl_create_context(twm_window window, int* attribs) {
+	return twm_gl_create_shared_context(window, attribs, NULL);
 }
-#endif
 
-#ifdef TWM_VULKAN
-const char** twm_vk_get_instance_extensions(int* extension_count) {
-	static const char* extensions[] = {
-		VK_KHR_SURFACE_EXTENSION_NAME,
-		VK_KHR_XLIB_SURFACE_EXTENSION_NAME
-	};
+// Windowless for the caller, backed by a hidden 1x1 window since WGL needs a pixel format on a DC
+twm_gl_context twm_gl_create_offscreen_context(int* attribs, twm_gl_context share) {
+	HWND hwnd = CreateWindowEx(0, TEXT("twm_class"), TEXT(""), WS_POPUP, 0, 0, 1, 1, NULL, NULL, _twm_data.hInstance, NULL);
 
-	*extension_count = sizeof(extensions) / sizeof(extensions[0]);
+	if (hwnd == NULL) return NULL;
 
-	return extensions;
+	twm_gl_context context = twm_gl_create_shared_context(hwnd, attribs, share);
+
+	if (context == NULL) {
+		DestroyWindow(hwnd);
+
+		return NULL;
+	}
+
+	context->offscreen = true;
+
+	return context;
 }
 
-VkResult twm_vk_create_surface(twm_window window, VkInstance instance, const VkAllocationCallbacks* pAllocator, VkSurfaceKHR* pSurface) {
-	VkXlibSurfaceCreateInfoKHR surface_info;
-	surface_info.sType = VK_STRUCTURE_TYPE_XLIB_SURFACE_CREATE_INFO_KHR;
-	surface_info.dpy = _twm_data.display;
-	surface_info.window = window;
-	surface_info.flags = 0;
+void twm_gl_delete_context(twm_gl_context context) {
+	if (wglGetCurrentContext() == context->hglrc) wglMakeCurrent(NULL, NULL);
+
+	wglDeleteContext(context->hglrc);
+
+	ReleaseDC(context->hwnd, context->hdc);
+
+	if (context->offscreen) DestroyWindow(context->hwnd);
+
+	free(context);
+}
+#endif
+
+#ifdef TWM_VULKAN
+const char** twm_vk_get_instance_extensions(int* extension_count) {
+	static const char* extensions[] = {
+		VK_KHR_SURFACE_EXTENSION_NAME,
+		VK_KHR_WIN32_SURFACE_EXTENSION_NAME
+	};
+
+	*extension_count = sizeof(extensions) / sizeof(extensions[0]);
+
+	return extensions;
+}
+
+VkResult twm_vk_create_surface(twm_window window, VkInstance instance, const VkAllocationCallbacks* pAllocator, VkSurfaceKHR* pSurface) {
+	VkWin32SurfaceCreateInfoKHR surface_info;
+	surface_info.sType = VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR;
+	surface_info.hinstance = _twm_data.hInstance;
+	surface_info.hwnd = window;
 	surface_info.pNext = NULL;
+	surface_info.flags = 0;
 
-	return vkCreateXlibSurfaceKHR(instance, &surface_info, pAllocator, pSurface);
+	return vkCreateWin32SurfaceKHR(instance, &surface_info, NULL, pSurface);
 }
 #endif
 
-#elif defined(TWM_COCOA)
+#elif defined(TWM_X11)
 
-#ifdef __OBJC__
 twm_data _twm_data = { 0 };
 
-#define RESIZE_BORDER 10
+typedef struct twm_window_data {
+	int width, height;
+	int x, y;
+	char state;
+	Bool was_closed;
+	Bool was_resized;
+	Bool pending_size;
+	Bool pending_move;
+	Bool pending_motion;
+	double motion_x, motion_y;
+	unsigned long motion_time;
+	Window parent;
+	void * ptr;
+	twm_window_flags flags;
+#ifdef TWM_PRESENT
+	XID present_eid;
+	unsigned long long last_msc;
+	int skipped;
+#endif
+#ifdef TWM_GL
+	Colormap colorMap;
+	XVisualInfo* visual;
+	GLXFBConfig fbconfig;
+#endif
+} twm_window_data;
 
-NSString* translate_input_for_keydown(NSEvent* event, UInt32* deadKeyState);
-ResizeEdge detect_resize_edge(NSPoint mousePos, NSRect frame);
-bool is_mouse_in_client_area(NSEvent* event);
+#ifdef TWM_GL
+// Chosen config for one pixel attribute set, shared by every window created with it
+typedef struct _twm_gl_config {
+	int pixel_attribs[TWM_GL_PIXEL_ATTRIBS_SIZE];
+	GLXFBConfig fbconfig;
+	XVisualInfo* visual;
+	Colormap colormap;
+} _twm_gl_config;
+#endif
 
-@implementation _twm_window
-- (BOOL)windowShouldClose:(NSWindow*)sender {
-    self.was_closed = true;
-    
-    NSEvent* customEvent = [NSEvent otherEventWithType : NSEventTypeApplicationDefined
-		location : sender.frame.origin
-		modifierFlags : 0
-		timestamp : [NSDate timeIntervalSinceReferenceDate]
-		windowNumber : [sender windowNumber]
-		context : nil
-		subtype : TWM_EVENT_WINDOW_CLOSE
-		data1 : sender.frame.origin.x
-		data2 : sender.frame.origin.y];
-	[NSApp postEvent : customEvent atStart : NO] ;
+// Open-addressed table from Window to a slot, window data itself is stored contiguously in the
+// first count slots. The table has twice as many entries as there are slots to keep probes short
+typedef struct _twm_x11_window_entry {
+	Window window;
+	int slot;
+} _twm_x11_window_entry;
 
-	return FALSE;
-}
+static struct {
+	int count;
+	int capacity;
+	Window last_window;
+	twm_window_data* last_data;
+	Window* slot_window;
+	_twm_x11_window_entry* table;
+	twm_window_data* data;
+} _twm_x11_windows;
 
-- (void)windowDidResize:(NSNotification*)notification {
-    NSRect frame = [self frame];
-    NSSize contentSize = [[self contentView] frame].size;
-    
-    if (contentSize.width != self.width || contentSize.height != self.height) {
-        self.was_resized = true;
-        self.width = contentSize.width;
-        self.height = contentSize.height;
-        
-        NSEvent* customEvent = [NSEvent otherEventWithType : NSEventTypeApplicationDefined
-            location : self.frame.origin
-            modifierFlags : 0
-            timestamp : [NSDate timeIntervalSinceReferenceDate]
-            windowNumber : [self windowNumber]
-            context : nil
-            subtype : TWM_EVENT_WINDOW_SIZE
-            data1 : contentSize.width
-            data2 : contentSize.height];
+static inline unsigned int _twm_x11_window_table_size() {
+	return (unsigned int)_twm_x11_windows.capacity * 2;
+}
 
-        [NSApp postEvent : customEvent atStart : YES];
-    }
+static inline unsigned int _twm_x11_window_hash(Window window) {
+	return (unsigned int)(((unsigned long long)window * 0x9E3779B97F4A7C15ULL) >> 32) % _twm_x11_window_table_size();
 }
 
-- (void)windowDidMove:(NSNotification*)notification {
-	NSRect frame = [self frame];
+static inline void _twm_x11_window_insert(Window window, int slot) {
+	unsigned int i = _twm_x11_window_hash(window);
+	while (_twm_x11_windows.table[i].window != None) i = (i + 1) % _twm_x11_window_table_size();
 
-	NSScreen* screen = [self screen];
-	CGFloat screenHeight = screen.frame.size.height;
+	_twm_x11_windows.table[i].window = window;
+	_twm_x11_windows.table[i].slot = slot;
+}
 
-	CGFloat yFromTop = screenHeight - frame.origin.y - frame.size.height;
+static inline int _twm_x11_window_find(Window window) {
+	if (_twm_x11_windows.table == NULL) return -1;
 
-	self.x = (int)self.frame.origin.x;
-    self.y = (int)yFromTop;
+	for (unsigned int i = _twm_x11_window_hash(window); _twm_x11_windows.table[i].window != None; i = (i + 1) % _twm_x11_window_table_size()) {
+		if (_twm_x11_windows.table[i].window == window) return (int)i;
+	}
 
-	NSEvent* customEvent = [NSEvent otherEventWithType : NSEventTypeApplicationDefined
-		location : self.frame.origin
-		modifierFlags : 0
-		timestamp : [NSDate timeIntervalSinceReferenceDate]
-		windowNumber : [self windowNumber]
-		context : nil
-		subtype : TWM_EVENT_WINDOW_MOVE
-		data1 : self.frame.origin.x
-		data2 : yFromTop];
-	[NSApp postEvent : customEvent atStart : NO];
+	return -1;
 }
 
-- (void)windowDidMiniaturize:(NSNotification*)notification {
-	NSWindow* sender = notification.object;
+// Doubles the slots and rehashes into a fresh table, pointers to window data do not survive it
+static bool _twm_x11_grow_windows() {
+	int capacity = _twm_x11_windows.capacity ? _twm_x11_windows.capacity * 2 : TWM_INITIAL_WINDOWS;
 
-	NSEvent* customEvent = [NSEvent otherEventWithType : NSEventTypeApplicationDefined
-		location : self.frame.origin
-		modifierFlags : 0
-		timestamp : [NSDate timeIntervalSinceReferenceDate]
-		windowNumber : [self windowNumber]
-		context : nil
-		subtype : TWM_EVENT_WINDOW_MINIMIZE
-		data1 : 0
-		data2 : 0];
-	[NSApp postEvent : customEvent atStart : NO] ;
-}
+	Window* slot_window = (Window*)realloc(_twm_x11_windows.slot_window, capacity * sizeof(Window));
+	if (slot_window == NULL) return false;
+	_twm_x11_windows.slot_window = slot_window;
 
-- (void)windowDidDeminiaturize:(NSNotification*)notification {
-	NSWindow* sender = notification.object;
+	twm_window_data* data = (twm_window_data*)realloc(_twm_x11_windows.data, capacity * sizeof(twm_window_data));
+	if (data == NULL) return false;
+	_twm_x11_windows.data = data;
 
-	NSEvent* customEvent = [NSEvent otherEventWithType : NSEventTypeApplicationDefined
-		location : self.frame.origin
-		modifierFlags : 0
-		timestamp : [NSDate timeIntervalSinceReferenceDate]
-		windowNumber : [self windowNumber]
-		context : nil
-		subtype : TWM_EVENT_WINDOW_RESTORE
-		data1 : 0
-		data2 : 0];
-	[NSApp postEvent : customEvent atStart : NO] ;
-}
+	_twm_x11_window_entry* table = (_twm_x11_window_entry*)calloc(capacity * 2, sizeof(_twm_x11_window_entry));
+	if (table == NULL) return false;
 
-- (void)windowDidBecomeKey:(NSNotification*)notification {
-	NSWindow* sender = notification.object;
+	free(_twm_x11_windows.table);
+	_twm_x11_windows.table = table;
+	_twm_x11_windows.capacity = capacity;
 
-	NSEvent* customEvent = [NSEvent otherEventWithType : NSEventTypeApplicationDefined
-		location : self.frame.origin
-		modifierFlags : 0
-		timestamp : [NSDate timeIntervalSinceReferenceDate]
-		windowNumber : [self windowNumber]
-		context : nil
-		subtype : TWM_EVENT_WINDOW_ACTIVE
-		data1 : 0
-		data2 : 0];
-	[NSApp postEvent : customEvent atStart : NO] ;
+	for (int slot = 0; slot < _twm_x11_windows.count; slot++) _twm_x11_window_insert(_twm_x11_windows.slot_window[slot], slot);
+
+	_twm_x11_windows.last_window = None;
+	_twm_x11_windows.last_data = NULL;
+
+	return true;
 }
 
-- (void)windowDidResignKey:(NSNotification*)notification {
-	NSEvent* customEvent = [NSEvent otherEventWithType : NSEventTypeApplicationDefined
-		location : self.frame.origin
-		modifierFlags : 0
-		timestamp : [NSDate timeIntervalSinceReferenceDate]
-		windowNumber : [self windowNumber]
-		context : nil
-		subtype : TWM_EVENT_WINDOW_INACTIVE
-		data1 : 0
-		data2 : 0];
-	[NSApp postEvent : customEvent atStart : NO] ;
+static inline twm_window_data* _twm_x11_add_window(Window window) {
+	if (_twm_x11_windows.count == _twm_x11_windows.capacity && !_twm_x11_grow_windows()) return NULL;
+
+	int slot = _twm_x11_windows.count++;
+
+	_twm_x11_window_insert(window, slot);
+	_twm_x11_windows.slot_window[slot] = window;
+
+	return &_twm_x11_windows.data[slot];
 }
-@end
 
-int twm_init() {
-	setlocale(LC_ALL, "");
+static inline void _twm_x11_remove_window(Window window) {
+	int found = _twm_x11_window_find(window);
 
-    _twm_data.cursor_visible = true;
-    
-    #pragma clang diagnostic push
-    #pragma clang diagnostic ignored "-Wdeprecated-declarations"
-    
-    CGGetActiveDisplayList(0, NULL, (uint32_t*)&_twm_data.screen.count);
-	_twm_data.screen.display_ids = malloc(sizeof(CGDirectDisplayID) * _twm_data.screen.count);
-    CGGetActiveDisplayList(_twm_data.screen.count, _twm_data.screen.display_ids, (uint32_t*)&_twm_data.screen.count);
+	if (found < 0) return;
 
-	_twm_data.screen.screen = malloc(sizeof(twm_screen) * _twm_data.screen.count);
+	unsigned int i = (unsigned int)found;
+	unsigned int size = _twm_x11_window_table_size();
+	int slot = _twm_x11_windows.table[i].slot;
 
-    for (uint32_t i = 0; i < _twm_data.screen.count; i++) {
-        twm_screen* screen = &_twm_data.screen.screen[i];
+	_twm_x11_windows.table[i].window = None;
 
-        screen->display_id = _twm_data.screen.display_ids[i];
+	// Shift back later entries of the probe chain so lookups never need tombstones
+	for (unsigned int j = (i + 1) % size; _twm_x11_windows.table[j].window != None; j = (j + 1) % size) {
+		unsigned int home = _twm_x11_window_hash(_twm_x11_windows.table[j].window);
 
-		CGRect bounds = CGDisplayBounds(screen->display_id);
-		screen->x = bounds.origin.x;
-		screen->y = bounds.origin.y;
-		screen->width = bounds.size.width;
-		screen->height = bounds.size.height;
+		if ((j > i && (home <= i || home > j)) || (j < i && (home <= i && home > j))) {
+			_twm_x11_windows.table[i] = _twm_x11_windows.table[j];
+			_twm_x11_windows.table[j].window = None;
+			i = j;
+		}
+	}
 
-		io_service_t servicePort = CGDisplayIOServicePort(screen->display_id);
-		CFDictionaryRef dict = IODisplayCreateInfoDictionary(servicePort, kIODisplayOnlyPreferredName);
-		if (dict) {
-			CFDictionaryRef names;
-			if (CFDictionaryGetValueIfPresent(dict, CFSTR(kDisplayProductName), (const void**)&names)) {
-				CFStringRef name;
-				if (CFDictionaryGetValueIfPresent(names, CFSTR("en_US"), (const void**)&name)) {
-					CFStringGetCString(name, screen->name, sizeof(screen->name), kCFStringEncodingUTF8);
-				}
-			}
-			CFRelease(dict);
-        }
+	// Move the last window into the freed slot so the first count slots stay dense
+	int last = --_twm_x11_windows.count;
 
-        CGDisplayModeRef current_mode = CGDisplayCopyDisplayMode(screen->display_id);
+	if (slot != last) {
+		_twm_x11_windows.slot_window[slot] = _twm_x11_windows.slot_window[last];
+		_twm_x11_windows.data[slot] = _twm_x11_windows.data[last];
+		_twm_x11_windows.table[_twm_x11_window_find(_twm_x11_windows.slot_window[slot])].slot = slot;
+	}
 
-        int width = (int)CGDisplayModeGetWidth(current_mode);
-        int height = (int)CGDisplayModeGetHeight(current_mode);
-        int current_bpp = 0;
-        int current_hz = (int)round(CGDisplayModeGetRefreshRate(current_mode));
+	_twm_x11_windows.slot_window[last] = None;
 
-        CFStringRef encoding = CGDisplayModeCopyPixelEncoding(current_mode);
-        if (encoding) {
-            const char* bppStr = "Unknown";
-            if (CFStringCompare(encoding, CFSTR(IO32BitDirectPixels), 0) == kCFCompareEqualTo) {
-                current_bpp = 32;
-            } else if (CFStringCompare(encoding, CFSTR(IO16BitDirectPixels), 0) == kCFCompareEqualTo) {
-                current_bpp = 16;
-            } else if (CFStringCompare(encoding, CFSTR(IO8BitIndexedPixels), 0) == kCFCompareEqualTo) {
-                current_bpp = 8;
-            }
-         
-            CFRelease(encoding);
-        }
+	_twm_x11_windows.last_window = None;
+	_twm_x11_windows.last_data = NULL;
+}
 
-        CGDisplayModeRelease(current_mode);
-		
-		screen->modes_ref = CGDisplayCopyAllDisplayModes(screen->display_id, NULL);
-		if (screen->modes_ref) {
-			screen->modes.count = (int)CFArrayGetCount(screen->modes_ref);
-			screen->modes.mode = malloc(sizeof(twm_screen_mode) * screen->modes.count);
+// Raw motion is only selected while one of our windows has focus or the pointer is grabbed
+static inline void _twm_x11_update_raw_input() {
+	if (!_twm_data.xi2) return;
 
-			for (int j = 0; j < CFArrayGetCount(screen->modes_ref); j++) {
-				twm_screen_mode * mode = &screen->modes.mode[j];
+	int deviceid = _twm_data.mouse.raw.master_only ? XIAllMasterDevices : XIAllDevices;
+	int wanted = (_twm_data.raw_input.focus != None || _twm_data.raw_input.grabbed) ? deviceid : -1;
 
-				mode->mode_ref = (CGDisplayModeRef)CFArrayGetValueAtIndex(screen->modes_ref, j);
+	if (wanted == _twm_data.raw_input.selected) return;
 
-				mode->width = (int)CGDisplayModeGetWidth(mode->mode_ref);
-				mode->height = (int)CGDisplayModeGetHeight(mode->mode_ref);
-				mode->hz = (int)round(CGDisplayModeGetRefreshRate(mode->mode_ref));
+	XIEventMask evmask;
+	unsigned char mask[XIMaskLen(XI_LASTEVENT)] = { 0 };
 
-				encoding = CGDisplayModeCopyPixelEncoding(mode->mode_ref);
-				if (encoding) {
-					const char* bppStr = "Unknown";
-					if (CFStringCompare(encoding, CFSTR(IO32BitDirectPixels), 0) == kCFCompareEqualTo) {
-						mode->bpp = 32;
-					} else if (CFStringCompare(encoding, CFSTR(IO16BitDirectPixels), 0) == kCFCompareEqualTo) {
-						mode->bpp = 16;
-					} else if (CFStringCompare(encoding, CFSTR(IO8BitIndexedPixels), 0) == kCFCompareEqualTo) {
-						mode->bpp = 8;
-					}
-				
-					CFRelease(encoding);
-				}
-                
-                if (width == mode->width && height && mode->height && current_bpp == mode->bpp && current_hz == mode->hz) {
-                    screen->modes.current = j;
-                }
-			}
-         }
-    }
-    
-    #pragma clang diagnostic pop
-
-	@autoreleasepool{
-		_twm_data.app = [NSApplication sharedApplication];
-		[NSApp setActivationPolicy : NSApplicationActivationPolicyRegular];
+	evmask.mask_len = sizeof(mask);
+	evmask.mask = mask;
 
-		#ifdef TWM_GL
-		#pragma clang diagnostic push
-		#pragma clang diagnostic ignored "-Wdeprecated-declarations"
-			NSOpenGLPixelFormatAttribute pixel_attribs[] = {
-				NSOpenGLPFAAccelerated,
-				NSOpenGLPFAOpenGLProfile, NSOpenGLProfileVersion4_1Core,
-				NSOpenGLPFAColorSize, 24,
-				NSOpenGLPFAAlphaSize, 8,
-				NSOpenGLPFADepthSize, 24,
-				NSOpenGLPFAStencilSize, 8,
-				NSOpenGLPFASampleBuffers, 1,
-				NSOpenGLPFASamples, 1,
-				NSOpenGLPFADoubleBuffer,
-				0
-			};
+	if (_twm_data.raw_input.selected != -1) {
+		evmask.deviceid = _twm_data.raw_input.selected;
+		XISelectEvents(_twm_data.display, DefaultRootWindow(_twm_data.display), &evmask, 1);
+	}
 
-			memcpy(_twm_data.pixel_attribs, pixel_attribs, sizeof(pixel_attribs));
-        
-            _twm_data.swap_interval = 0;
-        
-            CGDirectDisplayID displayID = CGMainDisplayID();
-        
-            twm_screen * screen = &_twm_data.screen.screen[twm_screen_default()];
-        
-            _twm_data.refresh_rate = round(CGDisplayModeGetRefreshRate(CGDisplayCopyDisplayMode(screen->display_id)));
-		#pragma clang diagnostic pop
-		#endif
+	if (wanted != -1) {
+		XISetMask(mask, XI_RawMotion);
 
-		return 1;
+		evmask.deviceid = wanted;
+		XISelectEvents(_twm_data.display, DefaultRootWindow(_twm_data.display), &evmask, 1);
 	}
+
+	_twm_data.raw_input.selected = wanted;
 }
 
-void twm_finalize() {
-	for (int i = 0; i < _twm_data.screen.count; i++) {
-		CFRelease(_twm_data.screen.screen[i].modes_ref);
-		free(_twm_data.screen.screen[i].modes.mode);
+static const KeySym _twm_x11_keymod_keysym[TWM_X11_KEYMOD_COUNT] = {
+	XK_Shift_L, XK_Shift_R,
+	XK_Control_L, XK_Control_R,
+	XK_Alt_L, XK_Alt_R,
+	XK_Super_L, XK_Super_R,
+	XK_Menu,
+	XK_Num_Lock, XK_Scroll_Lock, XK_Caps_Lock,
+};
+
+static const unsigned int _twm_x11_keymod_flag[TWM_X11_KEYMOD_COUNT] = {
+	TWM_KEYMOD_SHIFT | TWM_KEYMOD_LSHIFT, TWM_KEYMOD_SHIFT | TWM_KEYMOD_RSHIFT,
+	TWM_KEYMOD_CTRL | TWM_KEYMOD_LCTRL, TWM_KEYMOD_CTRL | TWM_KEYMOD_RCTRL,
+	TWM_KEYMOD_ALT | TWM_KEYMOD_LALT, TWM_KEYMOD_ALT | TWM_KEYMOD_RALT,
+	TWM_KEYMOD_LWIN, TWM_KEYMOD_RWIN,
+	TWM_KEYMOD_MENU,
+	TWM_KEYMOD_NUMLOCK, TWM_KEYMOD_SCROLLLOCK, TWM_KEYMOD_CAPSLOCK,
+};
+
+// Resolved once at init and again on keyboard mapping changes, never on the key path
+static void _twm_x11_update_keymods() {
+	for (int i = 0; i < TWM_X11_KEYMOD_COUNT; i++) {
+		_twm_data.keymods.keycode[i] = XKeysymToKeycode(_twm_data.display, _twm_x11_keymod_keysym[i]);
+		_twm_data.keymods.mask[i] = XkbKeysymToModifiers(_twm_data.display, _twm_x11_keymod_keysym[i]);
 	}
-	free(_twm_data.screen.screen);
-	free(_twm_data.screen.display_ids);
-	
-	[_twm_data.app terminate : nil] ;
 }
 
-bool twm_change_screen_mode(int screen_index, int mode_index) {
-	if (screen_index < 0 || screen_index >= _twm_data.screen.count || mode_index < 0) return false;
+static inline int _twm_x11_keymod_index(unsigned int keycode) {
+	for (int i = 0; i < TWM_X11_KEYMOD_COUNT; i++) {
+		if (keycode != 0 && _twm_data.keymods.keycode[i] == keycode) return i;
+	}
 
-	twm_screen* screen = &_twm_data.screen.screen[screen_index];
+	return -1;
+}
 
-	if (mode_index >= screen->modes.count) return false;
+static inline void _twm_x11_track_keymod(unsigned int keycode, bool down) {
+	int index = _twm_x11_keymod_index(keycode);
+	if (index < 0) return;
 
-	if (CGDisplaySetDisplayMode(screen->display_id, screen->modes.mode[mode_index].mode_ref, NULL) != kCGErrorSuccess) return false;
+	if (down) {
+		_twm_data.keymods.held |= 1u << index;
+	}
+	else {
+		_twm_data.keymods.held &= ~(1u << index);
+	}
+}
 
-	screen->modes.current = mode_index;
-    
-#ifdef TWM_GL
-    _twm_data.refresh_rate = round(CGDisplayModeGetRefreshRate(screen->modes.mode[mode_index].mode_ref));
-#endif
+static inline void _twm_x11_track_keymap(const char key_vector[32]) {
+	_twm_data.keymods.held = 0;
 
-	return true;
+	for (int i = 0; i < TWM_X11_KEYMOD_COUNT; i++) {
+		KeyCode code = _twm_data.keymods.keycode[i];
+
+		if (code != 0 && key_vector[code >> 3] & (1 << (code & 7))) {
+			_twm_data.keymods.held |= 1u << i;
+		}
+	}
 }
 
-twm_window twm_create_window(const char* title, int x, int y, int width, int height, unsigned int flags) {
-	int screen = twm_screen_from_cursor();
-	twm_rect screen_rect;
-	twm_screen_rect(screen, &screen_rect);
+static inline twm_keymod twm_get_keymods(const XKeyEvent * ev) {
+	// The core state is authoritative for ordinary keys: drop modifiers whose release was missed
+	if (ev != NULL && _twm_x11_keymod_index(ev->keycode) < 0) {
+		for (int i = 0; i < TWM_X11_KEYMOD_NUMLOCK; i++) {
+			if (_twm_data.keymods.mask[i] && !(ev->state & _twm_data.keymods.mask[i])) {
+				_twm_data.keymods.held &= ~(1u << i);
+			}
+		}
+	}
 
-    NSUInteger style = NSWindowStyleMaskClosable | NSWindowStyleMaskMiniaturizable;
-    
-    if (!(flags & TWM_WINDOW_BORDERLESS)) {
-        style |= NSWindowStyleMaskTitled;
-    }
+	unsigned int mods = TWM_KEYMOD_NONE;
 
-    if (flags & TWM_WINDOW_RESIZABLE) {
-        style |= NSWindowStyleMaskResizable;
-    }
+	for (int i = 0; i < TWM_X11_KEYMOD_COUNT; i++) {
+		bool active;
 
-    NSRect contentRect = NSMakeRect(0, 0, width, height);
-    NSRect windowFrame = [NSWindow frameRectForContentRect:contentRect styleMask:style];
+		if (i >= TWM_X11_KEYMOD_NUMLOCK && _twm_data.keymods.mask[i]) {
+			active = _twm_data.keymods.locked & _twm_data.keymods.mask[i];
+		}
+		else {
+			active = _twm_data.keymods.held & (1u << i);
+		}
 
-    if (x == TWM_CENTER) x = (screen_rect.x + (screen_rect.width - width)) >> 1;
-    if (y == TWM_CENTER) y = (screen_rect.y + (screen_rect.height - (int)windowFrame.size.height)) >> 1;
-	
-	@autoreleasepool{
-        NSRect frame = NSMakeRect(x, screen_rect.height - (int)windowFrame.size.height - y, width, height);
+		if (active) mods |= _twm_x11_keymod_flag[i];
+	}
 
-		_twm_window* window = [[_twm_window alloc]initWithContentRect:frame
-														  styleMask : style
-															backing : NSBackingStoreBuffered
-															  defer : NO];
+	return (twm_keymod)mods;
+}
 
-        if (flags & TWM_WINDOW_BORDERLESS) {
-            [window setHasShadow:NO];
-        }
-        
-        [window setCollectionBehavior:NSWindowCollectionBehaviorFullScreenNone];
+static void _twm_x11_set_screen(twm_screen* screen, XRROutputInfo* output_info, XRRCrtcInfo* crtc_info) {
+	screen->output_info = output_info;
+	screen->crtc_info = crtc_info;
 
-		window.resizeEdge = ResizeNone;
-        window.x = (int)frame.origin.x;
-        window.y = (int)frame.origin.y;
-        window.width = width;
-        window.height = height;
-        window.flags = flags;
+	snprintf(screen->name, sizeof(screen->name), "%s", output_info->name);
 
-		window.delegate = window;
+	screen->x = crtc_info->x;
+	screen->y = crtc_info->y;
+	screen->width = crtc_info->width;
+	screen->height = crtc_info->height;
 
-		twm_title_window(window, title);
+	screen->modes.count = output_info->nmode;
+	screen->modes.current = -1;
+	screen->modes.mode = NULL;
 
-		return window;
+	for (int j = 0; j < output_info->nmode; j++) {
+		if (output_info->modes[j] == crtc_info->mode) screen->modes.current = j;
 	}
 }
 
-void twm_title_window(twm_window window, const char * title) {
-	@autoreleasepool{
-		NSString * nsTitle = [NSString stringWithUTF8String : title];
-		[window setTitle : nsTitle] ;
-	}
-}
+int twm_init() {
+	setlocale(LC_ALL, "");
 
-bool twm_window_was_closed(twm_window window) {
-    if (!window.was_closed) return false;
-    
-    window.was_closed = false;
+	XInitThreads();
+	XSetLocaleModifiers("@im=none");
 
-    return true;
-}
+	_twm_data.display = XOpenDisplay(NULL);
 
-bool twm_window_was_resized(twm_window window, int * width, int * height) {
-    if (!window.was_resized) return false;
+	if (_twm_data.display == NULL) return 0;
 
-    window.was_resized = false;
+	_twm_init_post_queue();
 
-    *width = (int)window.contentView.frame.size.width;
-    *height = (int)window.contentView.frame.size.height;
+	#ifdef __linux__
+		_twm_data.wakeup[0] = _twm_data.wakeup[1] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	#else
+		if (pipe(_twm_data.wakeup) == 0) {
+			for (int i = 0; i < 2; i++) {
+				fcntl(_twm_data.wakeup[i], F_SETFL, fcntl(_twm_data.wakeup[i], F_GETFL) | O_NONBLOCK);
+				fcntl(_twm_data.wakeup[i], F_SETFD, FD_CLOEXEC);
+			}
+		}
+		else {
+			_twm_data.wakeup[0] = _twm_data.wakeup[1] = -1;
+		}
+	#endif
 
-    return true;
-}
+	_twm_data.cursor_visible = true;
 
-void twm_show_window(twm_window window, bool visible) {
-	if (visible) {
-		[window makeKeyAndOrderFront : nil] ;
-		[NSApp activateIgnoringOtherApps : YES] ;
+	int xkb_opcode, xkb_error, xkb_major = XkbMajorVersion, xkb_minor = XkbMinorVersion;
+	if (XkbQueryExtension(_twm_data.display, &xkb_opcode, &_twm_data.xkb_event, &xkb_error, &xkb_major, &xkb_minor)) {
+		XkbSelectEvents(_twm_data.display, XkbUseCoreKbd, XkbMapNotifyMask | XkbNewKeyboardNotifyMask, XkbMapNotifyMask | XkbNewKeyboardNotifyMask);
+		XkbSelectEventDetails(_twm_data.display, XkbUseCoreKbd, XkbStateNotify, XkbModifierLockMask, XkbModifierLockMask);
+
+		XkbStateRec state;
+		if (XkbGetState(_twm_data.display, XkbUseCoreKbd, &state) == Success) {
+			_twm_data.keymods.locked = state.locked_mods;
+		}
 	}
 	else {
-		[window orderOut : nil] ;
+		_twm_data.xkb_event = -1;
 	}
-}
-
-
-bool twm_window_is_visible(twm_window window) {
-	return window.isVisible;
-}
-
-void twm_move_window(twm_window window, int x, int y, int width, int height) {
-    int new_x = x, new_y = y;
-    int new_width = width, new_height = height;
 
-    if (x == TWM_CURRENT || x == TWM_CENTER) new_x = window.x;
-    if (y == TWM_CURRENT || y == TWM_CENTER) new_y = window.y;
+	_twm_x11_update_keymods();
 
-    int screen = twm_screen_from_position(new_x, new_y);
-    twm_rect screen_rect;
-    twm_screen_rect(screen, &screen_rect);
+	_twm_data.shm_event = XShmQueryExtension(_twm_data.display) ? XShmGetEventBase(_twm_data.display) : -1;
+	_twm_data.present_opcode = -1;
 
-    if (width == TWM_CURRENT) new_width = window.width;
-    else if (width == TWM_STRETCH) new_width = screen_rect.width - new_x;
+#ifdef TWM_PRESENT
+	int present_event, present_error;
+	if (!XPresentQueryExtension(_twm_data.display, &_twm_data.present_opcode, &present_event, &present_error)) {
+		_twm_data.present_opcode = -1;
+	}
+#endif
 
-    if (height == TWM_CURRENT) new_height = window.frame.size.height;
-    else if (height == TWM_STRETCH) new_height = screen_rect.height - new_y;
-    else {
-        NSRect contentRect = NSMakeRect(0, 0, width, height);
-        NSRect windowFrame = [NSWindow frameRectForContentRect:contentRect styleMask:window.styleMask];
-        
-        new_height = (int)windowFrame.size.height;
-    }
+	int event, error, major = 2, minor = 0;
+	_twm_data.xi2 = XQueryExtension(_twm_data.display, "XInputExtension", &_twm_data.opcode, &event, &error) &&
+		XIQueryVersion(_twm_data.display, &major, &minor) == Success;
 
-    if (x == TWM_CENTER) new_x = (screen_rect.x + (screen_rect.width - new_width)) >> 1;
-    if (y == TWM_CENTER) new_y = (screen_rect.y + (screen_rect.height - new_height)) >> 1;
+	// The Current variant skips the output re-probe, which can stall for a long time on some drivers
+	_twm_data.screen.screen_res = XRRGetScreenResourcesCurrent(_twm_data.display, DefaultRootWindow(_twm_data.display));
 
-    NSRect frame = NSMakeRect(new_x, screen_rect.height - new_height - new_y, new_width, new_height);
+	if (_twm_data.screen.screen_res && _twm_data.screen.screen_res->noutput == 0) {
+		XRRFreeScreenResources(_twm_data.screen.screen_res);
+		_twm_data.screen.screen_res = XRRGetScreenResources(_twm_data.display, DefaultRootWindow(_twm_data.display));
+	}
 
-    [window setFrame:frame display:YES animate:NO];
-}
+	if (_twm_data.screen.screen_res) {
+		_twm_data.screen.count = 0;
+		_twm_data.screen.screen = (twm_screen*)calloc(_twm_data.screen.screen_res->noutput, sizeof(twm_screen));
 
-int twm_window_width(twm_window window) {
-	return window.width;
-}
+		for (int i = 0; _twm_data.screen.screen && i < _twm_data.screen.screen_res->noutput; i++) {
+			twm_screen * screen = &_twm_data.screen.screen[_twm_data.screen.count];
 
-int twm_window_height(twm_window window) {
-	return window.height;
-}
+			screen->output = _twm_data.screen.screen_res->outputs[i];
+			screen->output_info = XRRGetOutputInfo(_twm_data.display, _twm_data.screen.screen_res, screen->output);
 
-void twm_window_size(twm_window window, int* width, int* height) {
-	*width = window.width;
-	*height = window.height;
-}
+			if (screen->output_info && screen->output_info->connection == RR_Connected && screen->output_info->crtc) {
+				screen->crtc_info = XRRGetCrtcInfo(_twm_data.display, _twm_data.screen.screen_res, screen->output_info->crtc);
+			}
 
-int twm_window_x(twm_window window) {
-	return window.x;
-}
+			if (screen->crtc_info == NULL) {
+				if (screen->output_info) XRRFreeOutputInfo(screen->output_info);
 
-int twm_window_y(twm_window window) {
-	return window.y;
-}
+				screen->output_info = NULL;
 
-void twm_window_position(twm_window window, int* x, int* y) {
-	*x = window.x;
-	*y = window.y;
-}
+				continue;
+			}
 
-void twm_window_rect(twm_window window, twm_rect* rect) {
-	rect->x = window.x;
-	rect->y = window.y;
-	rect->width = window.width;
-	rect->height = window.height;
-}
+			_twm_x11_set_screen(screen, screen->output_info, screen->crtc_info);
 
-void twm_window_borderless(twm_window window, bool enable) {
-	NSWindowStyleMask style = window.styleMask;
+			_twm_data.screen.count++;
+		}
+	}
 
-	if (enable) {
-        window.flags |= TWM_WINDOW_BORDERLESS;
-        
-		[window setStyleMask:(style & ~NSWindowStyleMaskTitled)];
-        [window setHasShadow:NO];
+	// Output and CRTC notifies name exactly what changed, so the screen table can be updated one output at a time
+	int rr_error;
+	if (XRRQueryExtension(_twm_data.display, &_twm_data.rr_event, &rr_error)) {
+		XRRSelectInput(_twm_data.display, DefaultRootWindow(_twm_data.display), RRScreenChangeNotifyMask | RRCrtcChangeNotifyMask | RROutputChangeNotifyMask);
 	}
 	else {
-        window.flags &= ~TWM_WINDOW_BORDERLESS;
-        
-		[window setStyleMask:(style | NSWindowStyleMaskTitled)];
-        [window setHasShadow:YES];
+		_twm_data.rr_event = -1;
 	}
-}
 
-bool twm_window_is_borderless(twm_window window) {
-	return window.flags & TWM_WINDOW_BORDERLESS;
-}
+	_twm_data.raw_input.selected = -1;
 
-void twm_window_fullscreen(twm_window window, bool enable) {
-    if (enable && (window.flags & TWM_WINDOW_FULLSCREEN)) return;
-    
-    @autoreleasepool{
-        NSScreen* screen = window.screen ?: [NSScreen mainScreen];
-        
-        if (enable) {
-            twm_window_borderless(window, enable);
-            
-            window.flags |= TWM_WINDOW_FULLSCREEN;
-            
-            window.original_frame = [window frame];
-            window.original_level = window.level;
-            
-            [window setLevel:NSMainMenuWindowLevel + 1];
-            [window setFrame:screen.frame display:YES];
-        }
-        else {
-            window.flags &= ~TWM_WINDOW_FULLSCREEN;
-            
-            [window setLevel:window.original_level];
-            [window setFrame:window.original_frame display:YES];
+	static char* atom_names[TWM_X11_ATOM_COUNT] = {
+		[TWM_X11_ATOM_DELETE] = "WM_DELETE_WINDOW",
+		[TWM_X11_ATOM_NET_WM_STATE] = "_NET_WM_STATE",
+		[TWM_X11_ATOM_NET_WM_STATE_HIDDEN] = "_NET_WM_STATE_HIDDEN",
+		[TWM_X11_ATOM_NET_WM_STATE_MAX_HORZ] = "_NET_WM_STATE_MAXIMIZED_HORZ",
+		[TWM_X11_ATOM_NET_WM_STATE_MAX_VERT] = "_NET_WM_STATE_MAXIMIZED_VERT",
+		[TWM_X11_ATOM_NET_WM_STATE_FULLSCREEN] = "_NET_WM_STATE_FULLSCREEN",
+		[TWM_X11_ATOM_MOTIF_WM_HINTS] = "_MOTIF_WM_HINTS",
+	};
 
-            twm_window_borderless(window, enable);
-        }
-    }
-}
+	XInternAtoms(_twm_data.display, atom_names, TWM_X11_ATOM_COUNT, False, _twm_data.atom);
 
-bool twm_window_is_fullscreen(twm_window window) {
-	return window.flags & TWM_WINDOW_FULLSCREEN;
-}
+	_twm_data.xim = XOpenIM(_twm_data.display, NULL, NULL, NULL);
 
-void twm_set_window_ptr(twm_window window, void * ptr) {
-	window.ptr = ptr;
-}
+	char no_data[] = { 0 };
+	Pixmap blank = XCreateBitmapFromData(_twm_data.display, DefaultRootWindow(_twm_data.display), no_data, 1, 1);
 
-void * twm_get_window_ptr(twm_window window) {
-	return window.ptr;
-}
+	XColor dummy;
+	memset(&dummy, 0, sizeof(dummy));
+	_twm_data.cursor[TWM_X11_CURSOR_INVISIBLE] = XCreatePixmapCursor(_twm_data.display, blank, blank, &dummy, &dummy, 0, 0);
 
-void twm_set_window_property(twm_window window, const char * name, int size, const void* value) {
-	void* data = objc_getAssociatedObject(window, name);
-	if (!data) {
-		data = malloc(size);
-	}
+	XFreePixmap(_twm_data.display, blank);
 
-	memcpy(data, value, size);
+	_twm_data.cursor[TWM_X11_CURSOR_DEFAULT] = XCreateFontCursor(_twm_data.display, XC_left_ptr); // cursor padrão (seta)
+	XDefineCursor(_twm_data.display, DefaultRootWindow(_twm_data.display), _twm_data.cursor[TWM_X11_CURSOR_DEFAULT]);
+	XFlush(_twm_data.display);
 
-	objc_setAssociatedObject(window, name, data, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
-}
+#ifdef TWM_GL
+	{
+		int pixel_attribs[] = {
+			GLX_X_RENDERABLE, True,
+			GLX_DRAWABLE_TYPE, GLX_WINDOW_BIT,
+			GLX_RENDER_TYPE,   GLX_RGBA_BIT,
+			GLX_X_VISUAL_TYPE, GLX_TRUE_COLOR,
+			GLX_DOUBLEBUFFER,  True,
+			GLX_RED_SIZE,      8,
+			GLX_GREEN_SIZE,    8,
+			GLX_BLUE_SIZE,     8,
+			GLX_ALPHA_SIZE,    8,
+			GLX_DEPTH_SIZE,    24,
+			GLX_STENCIL_SIZE,  8,
+			GLX_FRAMEBUFFER_SRGB_CAPABLE_ARB, True,
+			GLX_SAMPLE_BUFFERS, False,
+			GLX_SAMPLES, 1,
+			None
+		};
 
-bool twm_get_window_property(twm_window window, const char * name, int size, void* value) {
-	void* data = objc_getAssociatedObject(window, name);
-	if (!data) return 0;
+		memcpy(_twm_data.pixel_attribs, pixel_attribs, sizeof(pixel_attribs));
 
-	memcpy(value, data, size);
+		_twm_data.glXCreateContextAttribsARB = (PFNGLXCREATECONTEXTATTRIBSARBPROC)glXGetProcAddressARB((const GLubyte*)"glXCreateContextAttribsARB");
+		_twm_data.glXSwapIntervalEXT = (PFNGLXSWAPINTERVALEXTPROC) glXGetProcAddress((const GLubyte*)"glXSwapIntervalEXT");
+		_twm_data.swap_interval = 0;
+
+		_twm_data.fbconfigs = glXGetFBConfigs(_twm_data.display, DefaultScreen(_twm_data.display), &_twm_data.fbconfig_count);
+
+		const char* extensions = glXQueryExtensionsString(_twm_data.display, DefaultScreen(_twm_data.display));
+
+		_twm_data.swap_control_tear = _twm_gl_has_extension(extensions, "GLX_EXT_swap_control_tear");
+
+		if (_twm_gl_has_extension(extensions, "GLX_OML_sync_control")) {
+			_twm_data.glXGetSyncValuesOML = (PFNGLXGETSYNCVALUESOMLPROC)glXGetProcAddress((const GLubyte*)"glXGetSyncValuesOML");
+			_twm_data.glXSwapBuffersMscOML = (PFNGLXSWAPBUFFERSMSCOMLPROC)glXGetProcAddress((const GLubyte*)"glXSwapBuffersMscOML");
+			_twm_data.glXWaitForSbcOML = (PFNGLXWAITFORSBCOMLPROC)glXGetProcAddress((const GLubyte*)"glXWaitForSbcOML");
+		}
+	}
+#endif
 
 	return 1;
 }
 
-void twm_free_window_property(twm_window window, const char* name) {
-	void* data = objc_getAssociatedObject(window, name);
-	if (!data) return;
+void twm_finalize() {
+	twm_record_end();
+	twm_replay_end();
 
-	free(data);
+	for (int i = 0; i < _twm_data.screen.count; i++) {
+		free(_twm_data.screen.screen[i].modes.mode);
 
-	objc_setAssociatedObject(window, name, nil, OBJC_ASSOCIATION_ASSIGN);
+		XRRFreeCrtcInfo(_twm_data.screen.screen[i].crtc_info);
+		XRRFreeOutputInfo(_twm_data.screen.screen[i].output_info);
+	}
+	free(_twm_data.screen.screen);
+
+	XRRFreeScreenResources(_twm_data.screen.screen_res);
+
+	XFreeCursor(_twm_data.display, _twm_data.cursor[TWM_X11_CURSOR_DEFAULT]);
+	XFreeCursor(_twm_data.display, _twm_data.cursor[TWM_X11_CURSOR_INVISIBLE]);
+
+#ifdef TWM_GL
+	for (int i = 0; i < _twm_data.config_count; i++) {
+		if (_twm_data.configs[i].visual) XFree(_twm_data.configs[i].visual);
+		if (_twm_data.configs[i].colormap) XFreeColormap(_twm_data.display, _twm_data.configs[i].colormap);
+	}
+	free(_twm_data.configs);
+
+	if (_twm_data.fbconfigs) XFree(_twm_data.fbconfigs);
+#endif
+
+	if (_twm_data.wakeup[0] >= 0) close(_twm_data.wakeup[0]);
+	if (_twm_data.wakeup[1] != _twm_data.wakeup[0] && _twm_data.wakeup[1] >= 0) close(_twm_data.wakeup[1]);
+
+	free(_twm_x11_windows.slot_window);
+	free(_twm_x11_windows.table);
+	free(_twm_x11_windows.data);
+	memset(&_twm_x11_windows, 0, sizeof(_twm_x11_windows));
+
+	XCloseDisplay(_twm_data.display);
 }
 
-void twm_destroy_window(twm_window window) {
-	[window close];
+bool twm_change_screen_mode(int screen_index, int mode_index) {
+	if (screen_index < 0 || screen_index >= _twm_data.screen.count || mode_index < 0) return false;
+
+	twm_screen* screen = &_twm_data.screen.screen[screen_index];
+
+	if (mode_index >= screen->modes.count) return false;
+
+	XRRCrtcInfo * crtc_info = screen->crtc_info;
+
+    return XRRSetCrtcConfig(_twm_data.display, _twm_data.screen.screen_res, screen->output_info->crtc, CurrentTime, crtc_info->x, crtc_info->y, screen->output_info->modes[mode_index],crtc_info->rotation,&screen->output, 1) == Success;
 }
 
-void twm_show_cursor(bool flag) {
-	if (flag) {
-		[NSCursor unhide];
+static void _twm_x11_decode_screen_modes(twm_screen* screen) {
+	XRRScreenResources* screen_res = _twm_data.screen.screen_res;
+
+	screen->modes.mode = (twm_screen_mode*)calloc(screen->modes.count, sizeof(twm_screen_mode));
+
+	if (screen->modes.mode == NULL) return;
+
+	int depth = DefaultDepth(_twm_data.display, DefaultScreen(_twm_data.display));
+
+	int bpp;
+	switch (depth) {
+		case 24: bpp = 32; break;
+		case 16: bpp = 16; break;
+		case 15: bpp = 16; break;
+		case 32: bpp = 32; break;
+		default: bpp = depth; break;
 	}
-	else {
-		[NSCursor hide];
+
+	for (int j = 0; j < screen->modes.count; j++) {
+		RRMode mode = screen->output_info->modes[j];
+
+		screen->modes.mode[j].mode = mode;
+		screen->modes.mode[j].bpp = bpp;
+
+		// The first npreferred modes are the ones the monitor reports as native
+		if (j < screen->output_info->npreferred) screen->modes.mode[j].flags |= TWM_SCREEN_MODE_PREFERRED;
+
+		for (int k = 0; k < screen_res->nmode; k++) {
+			XRRModeInfo* mi = &screen_res->modes[k];
+
+			if (mi->id == mode) {
+				double lines = mi->vTotal;
+
+				if (mi->modeFlags & RR_DoubleScan) {
+					lines *= 2.0;
+					screen->modes.mode[j].flags |= TWM_SCREEN_MODE_DOUBLESCAN;
+				}
+
+				if (mi->modeFlags & RR_Interlace) {
+					lines /= 2.0;
+					screen->modes.mode[j].flags |= TWM_SCREEN_MODE_INTERLACED;
+				}
+
+				screen->modes.mode[j].width = mi->width;
+				screen->modes.mode[j].height = mi->height;
+				screen->modes.mode[j].refresh_rate = mi->hTotal && lines > 0.0 ? mi->dotClock / (mi->hTotal * lines) : 0.0;
+				screen->modes.mode[j].hz = twm_round(screen->modes.mode[j].refresh_rate);
+
+				break;
+			}
+		}
 	}
-    
-    _twm_data.cursor_visible = flag;
 }
 
-bool twm_cursor_is_visible() {
-	return _twm_data.cursor_visible;
+static bool _twm_x11_has_mode(RRMode mode) {
+	for (int k = 0; k < _twm_data.screen.screen_res->nmode; k++) {
+		if (_twm_data.screen.screen_res->modes[k].id == mode) return true;
+	}
+
+	return false;
 }
 
-void twm_cursor_position(int* x, int* y) {
-	CGEventRef ourEvent = CGEventCreate(NULL);
-	CGPoint p = CGEventGetLocation(ourEvent);
-	CFRelease(ourEvent);
+// Mode lists are built from every mode the output offers, not just the one the CRTC is using
+static bool _twm_x11_has_output_modes(const XRROutputInfo* output_info) {
+	for (int j = 0; j < output_info->nmode; j++) {
+		if (!_twm_x11_has_mode(output_info->modes[j])) return false;
+	}
 
-	*x = (int)p.x;
-	*y = (int)p.y;
+	return true;
 }
 
-void twm_move_cursor(int x, int y) {
-	CGWarpMouseCursorPosition(CGPointMake(x, y));
+static void _twm_x11_refresh_screen_res() {
+	XRRScreenResources* screen_res = XRRGetScreenResourcesCurrent(_twm_data.display, DefaultRootWindow(_twm_data.display));
+
+	if (screen_res == NULL) return;
+
+	XRRFreeScreenResources(_twm_data.screen.screen_res);
+	_twm_data.screen.screen_res = screen_res;
 }
 
-void twm_clip_cursor(twm_window window) {
-    _twm_data.clip_window = window;
-    
-    CGAssociateMouseAndMouseCursorPosition(false);
+// Re-queries a single output, returns 1 with a TWM_EVENT_SCREEN_CHANGED in evt if anything visible changed
+static int _twm_x11_update_output(twm_event* evt, RROutput output) {
+	if (_twm_data.screen.screen_res == NULL) return 0;
 
-	CGEventRef event = CGEventCreate(NULL);
-	CGPoint cursorLocation = CGEventGetLocation(event);
-	CFRelease(event);
-	
-	_twm_data.clip_x = cursorLocation.x;
-	_twm_data.clip_y = cursorLocation.y;
+	int index = -1;
+	for (int i = 0; i < _twm_data.screen.count; i++) {
+		if (_twm_data.screen.screen[i].output == output) index = i;
+	}
 
-	NSWindowStyleMask style = [_twm_data.clip_window styleMask];
+	XRROutputInfo* output_info = XRRGetOutputInfo(_twm_data.display, _twm_data.screen.screen_res, output);
+	XRRCrtcInfo* crtc_info = NULL;
 
-	style &= ~NSWindowStyleMaskResizable;
+	if (output_info && output_info->connection == RR_Connected && output_info->crtc) {
+		crtc_info = XRRGetCrtcInfo(_twm_data.display, _twm_data.screen.screen_res, output_info->crtc);
+	}
 
-	[_twm_data.clip_window setStyleMask:style];
+	twm_screen_change change = 0;
+	twm_rect rect = { 0 };
+
+	if (crtc_info == NULL) {
+		if (output_info) XRRFreeOutputInfo(output_info);
+
+		if (index < 0) return 0;
+
+		twm_screen* screen = &_twm_data.screen.screen[index];
+
+		twm_screen_rect(index, &rect);
+
+		free(screen->modes.mode);
+		XRRFreeCrtcInfo(screen->crtc_info);
+		XRRFreeOutputInfo(screen->output_info);
+
+		memmove(screen, screen + 1, (_twm_data.screen.count - index - 1) * sizeof(twm_screen));
+		_twm_data.screen.count--;
+
+		change = TWM_SCREEN_REMOVED;
+	}
+	else {
+		if (index < 0) {
+			twm_screen* screens = (twm_screen*)realloc(_twm_data.screen.screen, (_twm_data.screen.count + 1) * sizeof(twm_screen));
+
+			if (screens == NULL) {
+				XRRFreeCrtcInfo(crtc_info);
+				XRRFreeOutputInfo(output_info);
+
+				return 0;
+			}
+
+			_twm_data.screen.screen = screens;
+			index = _twm_data.screen.count++;
+
+			memset(&screens[index], 0, sizeof(twm_screen));
+			screens[index].output = output;
+
+			change = TWM_SCREEN_ADDED;
+		}
+
+		twm_screen* screen = &_twm_data.screen.screen[index];
+
+		if (screen->crtc_info) {
+			if (screen->crtc_info->x != crtc_info->x || screen->crtc_info->y != crtc_info->y ||
+				screen->crtc_info->width != crtc_info->width || screen->crtc_info->height != crtc_info->height) {
+				change |= TWM_SCREEN_GEOMETRY;
+			}
+
+			if (screen->crtc_info->mode != crtc_info->mode || screen->crtc_info->rotation != crtc_info->rotation ||
+				screen->output_info->nmode != output_info->nmode) {
+				change |= TWM_SCREEN_MODE;
+			}
+		}
+
+		if (change == 0) {
+			XRRFreeCrtcInfo(crtc_info);
+			XRRFreeOutputInfo(output_info);
+
+			return 0;
+		}
+
+		// A newly connected monitor brings modes the cached resources have not seen yet
+		if (!_twm_x11_has_mode(crtc_info->mode) || !_twm_x11_has_output_modes(output_info)) _twm_x11_refresh_screen_res();
+
+		free(screen->modes.mode);
+		if (screen->crtc_info) XRRFreeCrtcInfo(screen->crtc_info);
+		if (screen->output_info) XRRFreeOutputInfo(screen->output_info);
+
+		_twm_x11_set_screen(screen, output_info, crtc_info);
+
+		twm_screen_rect(index, &rect);
+	}
+
+	evt->type = TWM_EVENT_SCREEN_CHANGED;
+	evt->screen.screen = index;
+	evt->screen.change = change;
+	evt->screen.rect = rect;
+
+	return 1;
 }
 
-void twm_unclip_cursor() {
-	if (!_twm_data.clip_window) return;
+static int _twm_x11_screen_event(twm_event* evt, const XEvent* ev) {
+	if (ev->type == _twm_data.rr_event + RRScreenChangeNotify) {
+		XRRUpdateConfiguration((XEvent*)ev);
 
-	CGAssociateMouseAndMouseCursorPosition(true);
+		_twm_x11_refresh_screen_res();
 
-	NSWindowStyleMask style = [_twm_data.clip_window styleMask];
+		return 0;
+	}
 
-	style |= NSWindowStyleMaskResizable;
+	const XRRNotifyEvent* rr = (const XRRNotifyEvent*)ev;
 
-	[_twm_data.clip_window setStyleMask:style];
+	if (rr->subtype == RRNotify_OutputChange) {
+		return _twm_x11_update_output(evt, ((const XRROutputChangeNotifyEvent*)ev)->output);
+	}
 
-	_twm_data.clip_window = NULL;
+	if (rr->subtype == RRNotify_CrtcChange) {
+		RRCrtc crtc = ((const XRRCrtcChangeNotifyEvent*)ev)->crtc;
+
+		for (int i = 0; i < _twm_data.screen.count; i++) {
+			if (_twm_data.screen.screen[i].output_info->crtc == crtc) return _twm_x11_update_output(evt, _twm_data.screen.screen[i].output);
+		}
+	}
+
+	return 0;
 }
 
-static inline twm_keymod twm_get_keymods()
-{
-    NSEventModifierFlags flags = [NSEvent modifierFlags];
-    twm_keymod mods = TWM_KEYMOD_NONE;
+#ifdef TWM_GL
+static int _twm_x11_gl_attrib(GLXFBConfig fbconfig, int attrib) {
+	int value = 0;
 
-    if (flags & NSEventModifierFlagShift)
-    {
-        mods |= TWM_KEYMOD_SHIFT;
-        // Cocoa doesn't distinguish left/right Shift, so assume both
-        mods |= TWM_KEYMOD_LSHIFT | TWM_KEYMOD_RSHIFT;
-    }
-    if (flags & NSEventModifierFlagControl)
-    {
-        mods |= TWM_KEYMOD_CTRL;
-        mods |= TWM_KEYMOD_LCTRL | TWM_KEYMOD_RCTRL; // no distinction in Cocoa
-    }
-    if (flags & NSEventModifierFlagOption)
-    {
-        mods |= TWM_KEYMOD_ALT;
-        mods |= TWM_KEYMOD_LALT | TWM_KEYMOD_RALT;
-    }
-    if (flags & NSEventModifierFlagCommand)
-    {
-        mods |= TWM_KEYMOD_LWIN | TWM_KEYMOD_RWIN;
-    }
-    if (flags & NSEventModifierFlagCapsLock)
-    {
-        mods |= TWM_KEYMOD_CAPSLOCK;
-    }
+	glXGetFBConfigAttrib(_twm_data.display, fbconfig, attrib, &value);
 
-    // Cocoa doesn't provide direct access to NumLock, ScrollLock, Menu key
-    // You can implement detection via IOHID APIs if necessary, but it's non-trivial
+	return value;
+}
 
-    return mods;
+static int _twm_x11_gl_square(int value) {
+	return value * value;
 }
 
-static inline int _twm_translate_event(NSDate * untilDate, twm_event * evt, twm_window window) {
-	@autoreleasepool{
-		NSEvent * event;
-		while ((event = [_twm_data.app nextEventMatchingMask : NSEventMaskAny untilDate : untilDate inMode : NSDefaultRunLoopMode dequeue : YES])) {
-			twm_window window = (twm_window)event.window;
+// Closest match like glfw: drawable, render and visual type are hard constraints, then fewest missing buffers, closest color, closest extras
+static GLXFBConfig _twm_x11_gl_choose_fbconfig(const int* pixel_attribs) {
+	GLXFBConfig best = NULL;
+	int best_missing = INT_MAX, best_color = INT_MAX, best_extra = INT_MAX;
+	int samples = pixel_attribs[25] ? pixel_attribs[27] : 0;
 
-			switch (event.type) {
-				case NSEventTypeLeftMouseDown: {
+	for (int i = 0; i < _twm_data.fbconfig_count; i++) {
+		GLXFBConfig fbconfig = _twm_data.fbconfigs[i];
+
+		if (!(_twm_x11_gl_attrib(fbconfig, GLX_RENDER_TYPE) & GLX_RGBA_BIT)) continue;
+		if ((_twm_x11_gl_attrib(fbconfig, GLX_DRAWABLE_TYPE) & pixel_attribs[3]) != pixel_attribs[3]) continue;
+		if (pixel_attribs[1] == True && !_twm_x11_gl_attrib(fbconfig, GLX_X_RENDERABLE)) continue;
+		if (pixel_attribs[7] != GLX_DONT_CARE && _twm_x11_gl_attrib(fbconfig, GLX_X_VISUAL_TYPE) != pixel_attribs[7]) continue;
+		if ((pixel_attribs[3] & GLX_WINDOW_BIT) && !_twm_x11_gl_attrib(fbconfig, GLX_DOUBLEBUFFER) != !pixel_attribs[9]) continue;
+
+		int alpha = _twm_x11_gl_attrib(fbconfig, GLX_ALPHA_SIZE);
+		int depth = _twm_x11_gl_attrib(fbconfig, GLX_DEPTH_SIZE);
+		int stencil = _twm_x11_gl_attrib(fbconfig, GLX_STENCIL_SIZE);
+		int config_samples = _twm_x11_gl_attrib(fbconfig, GLX_SAMPLE_BUFFERS) ? _twm_x11_gl_attrib(fbconfig, GLX_SAMPLES) : 0;
+
+		int missing = (pixel_attribs[17] > 0 && alpha == 0) + (pixel_attribs[19] > 0 && depth == 0) + (pixel_attribs[21] > 0 && stencil == 0) + (samples > 0 && config_samples == 0);
+
+		int color = _twm_x11_gl_square(pixel_attribs[11] - _twm_x11_gl_attrib(fbconfig, GLX_RED_SIZE)) +
+			_twm_x11_gl_square(pixel_attribs[13] - _twm_x11_gl_attrib(fbconfig, GLX_GREEN_SIZE)) +
+			_twm_x11_gl_square(pixel_attribs[15] - _twm_x11_gl_attrib(fbconfig, GLX_BLUE_SIZE)) +
+			_twm_x11_gl_square(pixel_attribs[17] - alpha);
+
+		int extra = _twm_x11_gl_square(pixel_attribs[19] - depth) +
+			_twm_x11_gl_square(pixel_attribs[21] - stencil) +
+			_twm_x11_gl_square(samples - config_samples) +
+			(pixel_attribs[23] && !_twm_x11_gl_attrib(fbconfig, GLX_FRAMEBUFFER_SRGB_CAPABLE_ARB));
+
+		if (missing < best_missing ||
+			(missing == best_missing && (color < best_color || (color == best_color && extra < best_extra)))) {
+			best = fbconfig;
+			best_missing = missing;
+			best_color = color;
+			best_extra = extra;
+		}
+	}
+
+	return best;
+}
+
+// Windows created with the same pixel attributes share the config, visual and colormap, which live until twm_finalize
+static _twm_gl_config* _twm_x11_gl_config(const int* pixel_attribs) {
+	for (int i = 0; i < _twm_data.config_count; i++) {
+		if (memcmp(_twm_data.configs[i].pixel_attribs, pixel_attribs, sizeof(_twm_data.configs[i].pixel_attribs)) == 0) return &_twm_data.configs[i];
+	}
+
+	GLXFBConfig fbconfig = _twm_x11_gl_choose_fbconfig(pixel_attribs);
+
+	if (fbconfig == NULL) return NULL;
+
+	_twm_gl_config* configs = (_twm_gl_config*)realloc(_twm_data.configs, (_twm_data.config_count + 1) * sizeof(_twm_gl_config));
+
+	if (configs == NULL) return NULL;
+
+	_twm_data.configs = configs;
+
+	_twm_gl_config* config = &configs[_twm_data.config_count++];
+
+	memcpy(config->pixel_attribs, pixel_attribs, sizeof(config->pixel_attribs));
+	config->fbconfig = fbconfig;
+	config->visual = pixel_attribs[1] == True ? glXGetVisualFromFBConfig(_twm_data.display, fbconfig) : NULL;
+	config->colormap = config->visual ? XCreateColormap(_twm_data.display, RootWindow(_twm_data.display, DefaultScreen(_twm_data.display)), config->visual->visual, AllocNone) : None;
+
+	return config;
+}
+#endif
+
+twm_window twm_create_window(const char* title, int x, int y, int width, int height, twm_window_flags flags) {
+	twm_window_data window_data = { 0 };
+	twm_window_data* data = &window_data;
+
+	data->width = width;
+	data->height = height;
+	data->state = 0;
+	data->flags = flags;
+
+	int screen = twm_screen_from_cursor();
+	twm_rect screen_rect;
+	twm_screen_rect(screen, &screen_rect);
+
+	data->x = x == TWM_CENTER ? screen_rect.x + ((screen_rect.width - data->width) >> 1) : x;
+	data->y = y == TWM_CENTER ? screen_rect.y + ((screen_rect.height - data->height) >> 1) : y;
+
+	twm_window window;
+
+	XSetWindowAttributes swa = { 0 };
+	swa.event_mask = ExposureMask | StructureNotifyMask | PropertyChangeMask | FocusChangeMask | KeyPressMask | KeyReleaseMask | KeymapStateMask | EnterWindowMask | LeaveWindowMask;
+
+	// Pointer input comes through XI2 device events when available for sub-pixel coordinates
+	if (!_twm_data.xi2) swa.event_mask |= PointerMotionMask | ButtonPressMask | ButtonReleaseMask;
+
+#if defined(TWM_GL)
+	_twm_gl_config* config = _twm_x11_gl_config(_twm_data.pixel_attribs);
+
+	if (config == NULL || config->visual == NULL) return None;
+
+	swa.colormap = config->colormap;
+
+	window = XCreateWindow(_twm_data.display, RootWindow(_twm_data.display, DefaultScreen(_twm_data.display)),
+		data->x, data->y, data->width, data->height, 0,
+		config->visual->depth, InputOutput,
+		config->visual->visual,
+		CWColormap | CWEventMask, &swa);
+
+	data->colorMap = config->colormap;
+	data->visual = config->visual;
+	data->fbconfig = config->fbconfig;
+#elif defined(TWM_VULKAN)
+	window = XCreateWindow(_twm_data.display, RootWindow(_twm_data.display, DefaultScreen(_twm_data.display)),
+		data->x, data->y, data->width, data->height, 0,
+		CopyFromParent, InputOutput,
+		CopyFromParent,
+		CWEventMask, &swa);
+#else
+    swa.background_pixel = BlackPixel(_twm_data.display, DefaultScreen(_twm_data.display));
+
+	window = XCreateWindow(_twm_data.display, RootWindow(_twm_data.display, DefaultScreen(_twm_data.display)),
+		data->x, data->y, data->width, data->height, 0,
+		CopyFromParent, InputOutput,
+		CopyFromParent,
+		CWBackPixel | CWEventMask, &swa);
+#endif
+
+	data = _twm_x11_add_window(window);
+
+	if (data == NULL) {
+		XDestroyWindow(_twm_data.display, window);
+
+		return None;
+	}
+
+	*data = window_data;
+	data->parent = RootWindow(_twm_data.display, DefaultScreen(_twm_data.display));
+
+	if (_twm_data.xi2) {
+		XIEventMask evmask;
+		unsigned char mask[XIMaskLen(XI_LASTEVENT)] = { 0 };
+
+		evmask.deviceid = XIAllMasterDevices;
+		evmask.mask_len = sizeof(mask);
+		evmask.mask = mask;
+
+		XISetMask(mask, XI_Motion);
+		XISetMask(mask, XI_ButtonPress);
+		XISetMask(mask, XI_ButtonRelease);
+
+		XISelectEvents(_twm_data.display, window, &evmask, 1);
+	}
+
+	XSizeHints *hints = XAllocSizeHints();
+	hints->flags = PPosition;
+	hints->x = data->x;
+	hints->y = data->y;
+
+	if (!(flags & TWM_WINDOW_RESIZABLE)) {
+		hints->flags |= PMinSize | PMaxSize;
+
+		hints->min_width = hints->max_width = data->width;
+		hints->min_height = hints->max_height = data->height;
+	}
+
+	XSetWMNormalHints(_twm_data.display, window, hints);
+	XFree(hints);
+
+	if (flags & TWM_WINDOW_BORDERLESS) {
+		twm_window_borderless(window, true);
+	}
+
+	XSetWMProtocols(_twm_data.display, window, &_twm_data.atom[TWM_X11_ATOM_DELETE], 1);
+
+	twm_title_window(window, (char*)title);
+
+	_twm_data.xic = XCreateIC(_twm_data.xim, XNInputStyle, XIMPreeditNothing | XIMStatusNothing, XNClientWindow, window, NULL);
+
+	return window;
+}
+
+static inline twm_window_data * twm_get_window_data(twm_window window) {
+	if (window == _twm_x11_windows.last_window && window != None) return _twm_x11_windows.last_data;
+
+	int i = _twm_x11_window_find(window);
+
+	if (i < 0) return NULL;
+
+	_twm_x11_windows.last_window = window;
+	_twm_x11_windows.last_data = &_twm_x11_windows.data[_twm_x11_windows.table[i].slot];
+
+	return _twm_x11_windows.last_data;
+}
+
+void twm_destroy_window(twm_window window) {
+	_twm_x11_remove_window(window);
+
+	if (_twm_data.raw_input.focus == window) {
+		_twm_data.raw_input.focus = None;
+		_twm_x11_update_raw_input();
+	}
+
+	XDestroyWindow(_twm_data.display, window);
+}
+
+bool twm_window_was_closed(twm_window window) {
+	twm_window_data* data = twm_get_window_data(window);
+
+	if (!data->was_closed) return false;
+	
+	data->was_closed = false;
+
+	return true;
+}
+
+bool twm_window_was_resized(twm_window window, int * width, int * height) {
+	twm_window_data* data = twm_get_window_data(window);
+
+	if (!data->was_resized) return false;
+
+	data->was_resized = false;
+
+	*width = data->width;
+	*height = data->height;
+
+	return true;
+}
+
+void twm_show_window(twm_window window, bool visible) {
+	if (visible) {
+		XMapWindow(_twm_data.display, window);
+	}
+	else {
+		XUnmapWindow(_twm_data.display, window);
+	}
+
+	XFlush(_twm_data.display);
+}
+
+bool twm_window_is_visible(twm_window window) {
+	XWindowAttributes attr;
+	XGetWindowAttributes(_twm_data.display, window, &attr);
+
+	return (attr.map_state == IsViewable);
+}
+
+void twm_move_window(twm_window window, int x, int y, int width, int height) {
+	twm_window_data* data = twm_get_window_data(window);
+	
+	int new_x = x, new_y = y;
+	int new_width = width, new_height = height;
+
+	if (x == TWM_CURRENT || x == TWM_CENTER) new_x = data->x;
+	if (y == TWM_CURRENT || y == TWM_CENTER) new_y = data->y;
+
+	int screen = twm_screen_from_position(new_x, new_y);
+	twm_rect screen_rect;
+	twm_screen_rect(screen, &screen_rect);
+
+	if (width == TWM_CURRENT || width == TWM_STRETCH) new_width = data->width;
+	if (height == TWM_CURRENT || height == TWM_STRETCH) new_height = data->height;
+
+	if (width == TWM_STRETCH) new_width = screen_rect.width - new_x;
+	if (height == TWM_STRETCH) new_height = screen_rect.height - new_y;
+
+	if (x == TWM_CENTER) new_x = screen_rect.x + ((screen_rect.width - new_width) >> 1);
+	if (y == TWM_CENTER) new_y = screen_rect.y + ((screen_rect.height - new_height) >> 1);
+
+	XMoveResizeWindow(_twm_data.display, window, new_x, new_y, new_width, new_height);
+	XFlush(_twm_data.display);
+
+	data->x = new_x;
+	data->y = new_y;
+}
+
+int twm_window_width(twm_window window) {
+	return twm_get_window_data(window)->width;
+}
+
+int twm_window_height(twm_window window) {
+	return twm_get_window_data(window)->height;
+}
+
+void twm_window_size(twm_window window, int* width, int* height) {
+	twm_window_data* data = twm_get_window_data(window);
+	*width = data->width;
+	*height = data->height;
+}
+
+int twm_window_x(twm_window window) {
+	return twm_get_window_data(window)->x;
+}
+
+int twm_window_y(twm_window window) {
+	return twm_get_window_data(window)->y;
+}
+
+void twm_window_position(twm_window window, int* x, int* y) {
+	twm_window_data* data = twm_get_window_data(window);
+	*x = data->x;
+	*y = data->y;
+}
+
+void twm_window_rect(twm_window window, twm_rect* rect) {
+	twm_window_data* data = twm_get_window_data(window);
+	rect->x = data->x;
+	rect->y = data->y;
+	rect->width = data->width;
+	rect->height = data->height;
+}
+
+void twm_title_window(twm_window window, const char * title) {
+	XStoreName(_twm_data.display, window, title);
+	XSetIconName(_twm_data.display, window, title);
+}
+
+#define MWM_HINTS_FUNCTIONS   (1L << 0)
+#define MWM_HINTS_DECORATIONS (1L << 1)
+
+#define MWM_DECOR_ALL         (1L << 0)
+#define MWM_DECOR_BORDER      (1L << 1)
+#define MWM_DECOR_RESIZEH     (1L << 2)
+#define MWM_DECOR_TITLE       (1L << 3)
+#define MWM_DECOR_MENU        (1L << 4)
+#define MWM_DECOR_MINIMIZE    (1L << 5)
+#define MWM_DECOR_MAXIMIZE    (1L << 6)
+
+struct MotifWmHints {
+	unsigned long flags;
+	unsigned long functions;
+	unsigned long decorations;
+	long input_mode;
+	unsigned long status;
+};
+
+void twm_window_borderless(twm_window window, bool enable) {
+	XWindowAttributes attr;
+	XGetWindowAttributes(_twm_data.display, window, &attr);
+
+	struct MotifWmHints hints = {0};
+	hints.flags = MWM_HINTS_DECORATIONS;
+	hints.decorations = !enable ? MWM_DECOR_TITLE | MWM_DECOR_BORDER : 0;
+
+	Atom prop = _twm_data.atom[TWM_X11_ATOM_MOTIF_WM_HINTS];
+	XChangeProperty(_twm_data.display, window, prop, prop, 32, PropModeReplace, (unsigned char*)&hints, 5);
+	XFlush(_twm_data.display);
+
+	twm_window_data* data = twm_get_window_data(window);
+
+	if (enable) {
+		data->flags |= TWM_WINDOW_BORDERLESS;
+
+		XResizeWindow(_twm_data.display, window, attr.width, attr.height);
+		XFlush(_twm_data.display);
+	}
+	else {
+		data->flags &= ~TWM_WINDOW_BORDERLESS;
+	}
+}
+
+bool twm_window_is_borderless(twm_window window) {
+	return twm_get_window_data(window)->flags & TWM_WINDOW_BORDERLESS;
+}
+
+void twm_window_fullscreen(twm_window window, bool enable) {
+    Atom wm_state = _twm_data.atom[TWM_X11_ATOM_NET_WM_STATE];
+    Atom fullscreen = _twm_data.atom[TWM_X11_ATOM_NET_WM_STATE_FULLSCREEN];
+
+    XEvent xev = {0};
+    xev.xclient.type = ClientMessage;
+    xev.xclient.window = window;
+    xev.xclient.message_type = wm_state;
+    xev.xclient.format = 32;
+    xev.xclient.data.l[0] = enable ? 1 : 0;
+    xev.xclient.data.l[1] = fullscreen;
+    xev.xclient.data.l[2] = 0;
+    xev.xclient.data.l[3] = 1;
+    xev.xclient.data.l[4] = 0;
+
+    XSendEvent(_twm_data.display, DefaultRootWindow(_twm_data.display), False, SubstructureRedirectMask | SubstructureNotifyMask, &xev);
+
+	twm_window_data * data = twm_get_window_data(window);
+
+	if (enable) {
+		data->flags |= TWM_WINDOW_BORDERLESS | TWM_WINDOW_FULLSCREEN;
+	}
+	else {
+		data->flags &= ~(TWM_WINDOW_BORDERLESS | TWM_WINDOW_FULLSCREEN);
+	}
+}
+
+bool twm_window_is_fullscreen(twm_window window) {
+	return twm_get_window_data(window)->flags & TWM_WINDOW_FULLSCREEN;
+}
+
+void twm_cursor_position(int* x, int* y) {
+	int win_x, win_y;
+	unsigned int mask;
+	Window child, root_return;
+
+	XQueryPointer(_twm_data.display, DefaultRootWindow(_twm_data.display), &root_return, &child, x, y, &win_x, &win_y, &mask);
+}
+
+void twm_move_cursor(int x, int y) {
+	XWarpPointer(_twm_data.display, None, DefaultRootWindow(_twm_data.display), 0, 0, 0, 0, x, y);
+    XFlush(_twm_data.display);
+}
+
+void twm_rawmouse_master_only(bool enable) {
+	_twm_data.mouse.raw.master_only = enable;
+
+	_twm_x11_update_raw_input();
+	XFlush(_twm_data.display);
+}
+
+void twm_clip_cursor(twm_window window) {
+	XGrabPointer(_twm_data.display, window, True, ButtonPressMask | ButtonReleaseMask | PointerMotionMask, GrabModeAsync, GrabModeAsync, window, None, CurrentTime);
+
+	_twm_data.raw_input.grabbed = true;
+	_twm_x11_update_raw_input();
+
+	XFlush(_twm_data.display);
+}
+
+void twm_unclip_cursor() {
+	XUngrabPointer(_twm_data.display, CurrentTime);
+
+	_twm_data.raw_input.grabbed = false;
+	_twm_x11_update_raw_input();
+
+	XFlush(_twm_data.display);
+}
+
+void twm_show_cursor(bool flag) {
+	XDefineCursor(_twm_data.display, DefaultRootWindow(_twm_data.display), _twm_data.cursor[flag ? TWM_X11_CURSOR_DEFAULT : TWM_X11_CURSOR_INVISIBLE]);
+	XFlush(_twm_data.display);
+
+	_twm_data.cursor_visible = flag;
+}
+
+bool twm_cursor_is_visible() {
+	return _twm_data.cursor_visible;
+}
+
+void twm_set_window_ptr(twm_window window, void * ptr) {
+	twm_window_data* data = twm_get_window_data(window);
+
+	data->ptr = ptr;
+}
+
+void * twm_get_window_ptr(twm_window window) {
+	return twm_get_window_data(window)->ptr;
+}
+
+void twm_set_window_property(twm_window window, const char * name, int size, const void* value) {
+	Atom property = XInternAtom(_twm_data.display, name, False);
+
+	XChangeProperty(_twm_data.display, window, property, XA_CARDINAL, 8,
+		PropModeReplace, (const unsigned char*)value, size);
+}
+
+bool twm_get_window_property(twm_window window, const char * name, int size, void* value_out) {
+	Atom property = XInternAtom(_twm_data.display, name, False);
+	Atom actual_type;
+	int actual_format;
+	unsigned long nitems, bytes_after;
+	unsigned char* prop = NULL;
+
+	int status = XGetWindowProperty(_twm_data.display, window, property, 0, size, False,
+		XA_CARDINAL, &actual_type, &actual_format,
+		&nitems, &bytes_after, &prop);
+
+	if (status == Success && prop != NULL && actual_format == 8) {
+		memcpy(value_out, prop, (nitems < size) ? nitems : size);
+		XFree(prop);
+		return 1;
+	}
+
+	if (prop) XFree(prop);
+	return 0;
+}
+
+void twm_free_window_property(twm_window window, const char* name) {
+	Atom property = XInternAtom(_twm_data.display, name, False);
+	XDeleteProperty(_twm_data.display, window, property);
+}
+
+static inline unsigned long _twm_x11_event_time(const XEvent* ev) {
+	switch (ev->type) {
+		case KeyPress:
+		case KeyRelease:
+			return ev->xkey.time;
+
+		case ButtonPress:
+		case ButtonRelease:
+			return ev->xbutton.time;
+
+		case MotionNotify:
+			return ev->xmotion.time;
+
+		case EnterNotify:
+		case LeaveNotify:
+			return ev->xcrossing.time;
+
+		case PropertyNotify:
+			return ev->xproperty.time;
+
+		case ClientMessage:
+			return ev->xclient.data.l[0] == (long)_twm_data.atom[TWM_X11_ATOM_DELETE] ? (unsigned long)ev->xclient.data.l[1] : CurrentTime;
+
+		default:
+			return CurrentTime;
+	}
+}
+
+struct _twm_framebuffer {
+	Window window;
+	GC gc;
+	Visual* visual;
+	int depth;
+	int width, height;
+	int back;
+	bool shm;
+	struct {
+		XImage* image;
+		XShmSegmentInfo info;
+		bool busy;
+	} buffer[2];
+	struct _twm_framebuffer* next;
+};
+
+static inline void _twm_x11_shm_completed(ShmSeg shmseg) {
+	for (twm_framebuffer framebuffer = _twm_data.framebuffers; framebuffer; framebuffer = framebuffer->next) {
+		for (int i = 0; i < 2; i++) {
+			if (framebuffer->buffer[i].image && framebuffer->buffer[i].info.shmseg == shmseg) {
+				framebuffer->buffer[i].busy = false;
+
+				return;
+			}
+		}
+	}
+}
+
+static inline void _twm_x11_window_event(twm_event* evt, twm_event_type type, Window window, const twm_window_data* data) {
+	evt->type = type;
+	evt->window.window = window;
+	evt->window.x = data->x;
+	evt->window.y = data->y;
+	evt->window.width = data->width;
+	evt->window.height = data->height;
+}
+
+static inline int _twm_x11_mouse_button(twm_event* evt, Window window, int button, double x, double y, bool down) {
+	evt->mouse.window = window;
+	evt->mouse.x = (int)floor(x);
+	evt->mouse.y = (int)floor(y);
+	evt->mouse.fx = x;
+	evt->mouse.fy = y;
+	evt->mouse.z = evt->mouse.w = 0;
+
+	switch (button) {
+		case 1: evt->mouse.button = TWM_MB_LEFT; break;
+		case 2: evt->mouse.button = TWM_MB_MIDDLE; break;
+		case 3: evt->mouse.button = TWM_MB_RIGHT; break;
+		case 8: evt->mouse.button = TWM_MB_X1; break;
+		case 9: evt->mouse.button = TWM_MB_X2; break;
+
+		case 4:
+		case 5:
+		case 6:
+		case 7: {
+			if (!down) return 0;
+
+			evt->type = TWM_EVENT_MOUSE_WHEEL;
+			evt->mouse.button = TWM_MB_RIGHT;
+			evt->mouse.z = button == 4 ? 1 : button == 5 ? -1 : 0;
+			evt->mouse.w = button == 6 ? 1 : button == 7 ? -1 : 0;
+
+			return 1;
+		}
+
+		default:
+			return 0;
+	}
+
+	evt->type = down ? TWM_EVENT_MOUSE_DOWN : TWM_EVENT_MOUSE_UP;
+	_twm_data.mouse.buttons[evt->mouse.button] = down;
+
+	return 1;
+}
+
+static inline void _twm_x11_emit_motion(twm_event* evt, Window window, twm_window_data* data) {
+	data->pending_motion = false;
+
+	_twm_stamp_event(evt, data->motion_time);
+
+	evt->type = TWM_EVENT_MOUSE_MOVE;
+	evt->mouse.window = window;
+	evt->mouse.x = (int)data->motion_x;
+	evt->mouse.y = (int)data->motion_y;
+	evt->mouse.fx = data->motion_x;
+	evt->mouse.fy = data->motion_y;
+}
+
+// Only the latest position per window is kept, it is emitted when the drain ends or an event that must follow it arrives
+static inline int _twm_x11_mouse_motion(twm_event* evt, Window window, double x, double y) {
+	twm_window_data* data = twm_get_window_data(window);
+
+	if (!data || x < 0 || y < 0 || x >= data->width || y >= data->height) return 0;
+
+	_twm_data.mouse.x = (int)x;
+	_twm_data.mouse.y = (int)y;
+	_twm_data.mouse.fx = x;
+	_twm_data.mouse.fy = y;
+
+	data->pending_motion = true;
+	data->motion_x = x;
+	data->motion_y = y;
+	data->motion_time = evt->common.server_time;
+
+	return 0;
+}
+
+// Buttons, keys and crossings of a window are delivered after its pending motion, which then takes evt's place
+static inline void _twm_x11_order_after_motion(twm_event* evt) {
+	switch (evt->type) {
+		case TWM_EVENT_MOUSE_DOWN:
+		case TWM_EVENT_MOUSE_UP:
+		case TWM_EVENT_MOUSE_WHEEL:
+		case TWM_EVENT_MOUSE_ENTER:
+		case TWM_EVENT_MOUSE_LEAVE:
+		case TWM_EVENT_KEY_DOWN:
+		case TWM_EVENT_KEY_UP:
+		case TWM_EVENT_KEY_CHAR:
+			break;
+
+		default:
+			return;
+	}
+
+	Window window = evt->mouse.window;
+	twm_window_data* data = twm_get_window_data(window);
+
+	if (!data || !data->pending_motion) return;
+
+	// _twm_push_event leaves a slot free, so the event is always deferred and the motion goes first
+	_twm_push_event_front(evt);
+	_twm_x11_emit_motion(evt, window, data);
+}
+
+static inline int _twm_x11_flush_motion(twm_event* evt) {
+	for (int i = 0; i < _twm_x11_windows.count; i++) {
+		if (!_twm_x11_windows.data[i].pending_motion) continue;
+
+		_twm_x11_emit_motion(evt, _twm_x11_windows.slot_window[i], &_twm_x11_windows.data[i]);
+
+		return 1;
+	}
+
+	return 0;
+}
+
+// Emits one deferred size or move event per call when window events are coalesced
+static inline int _twm_x11_flush_window_events(twm_event* evt) {
+	for (int i = 0; i < _twm_x11_windows.count; i++) {
+		Window window = _twm_x11_windows.slot_window[i];
+		twm_window_data* data = &_twm_x11_windows.data[i];
+
+		if (!(data->pending_size || data->pending_move)) continue;
+
+		_twm_stamp_event(evt, CurrentTime);
+
+		if (data->pending_size) {
+			data->pending_size = false;
+			_twm_x11_window_event(evt, TWM_EVENT_WINDOW_SIZE, window, data);
+		}
+		else {
+			data->pending_move = false;
+			_twm_x11_window_event(evt, TWM_EVENT_WINDOW_MOVE, window, data);
+		}
+
+		return 1;
+	}
+
+	return 0;
+}
+
+static inline int _twm_x11_translate_event(twm_event * evt) {
+	XEvent ev;
+	XNextEvent(_twm_data.display, &ev);
+
+	_twm_stamp_event(evt, _twm_x11_event_time(&ev));
+
+	if (_twm_data.shm_event >= 0 && ev.type == _twm_data.shm_event + ShmCompletion) {
+		_twm_x11_shm_completed(((XShmCompletionEvent*)&ev)->shmseg);
+
+		return 0;
+	}
+
+	if (_twm_data.rr_event >= 0 && (ev.type == _twm_data.rr_event + RRScreenChangeNotify || ev.type == _twm_data.rr_event + RRNotify)) {
+		return _twm_x11_screen_event(evt, &ev);
+	}
+
+	if (ev.type == _twm_data.xkb_event) {
+		XkbEvent* xkb = (XkbEvent*)&ev;
+
+		switch (xkb->any.xkb_type) {
+			case XkbStateNotify:
+				_twm_data.keymods.locked = xkb->state.locked_mods;
+				_twm_data.keyboard.modifiers = twm_get_keymods(NULL);
+				break;
+
+			case XkbMapNotify:
+			case XkbNewKeyboardNotify:
+				_twm_x11_update_keymods();
+				break;
+		}
+
+		return 0;
+	}
+	
+	switch (ev.type) {
+		case MappingNotify:
+			if (ev.xmapping.request == MappingKeyboard || ev.xmapping.request == MappingModifier) {
+				XRefreshKeyboardMapping(&ev.xmapping);
+				_twm_x11_update_keymods();
+			}
+		break;
+
+		case KeymapNotify:
+			_twm_x11_track_keymap(ev.xkeymap.key_vector);
+			_twm_data.keyboard.modifiers = twm_get_keymods(NULL);
+		break;
+
+		case MapNotify:
+			XSetInputFocus(ev.xmap.display, ev.xmap.window, RevertToParent, CurrentTime);
+			XFlush(ev.xmap.display);
+		break;
+
+		case GenericEvent: {
+#ifdef TWM_PRESENT
+			if (ev.xcookie.extension == _twm_data.present_opcode && XGetEventData(_twm_data.display, &ev.xcookie)) {
+				int result = 0;
+
+				if (ev.xcookie.evtype == PresentCompleteNotify) {
+					XPresentCompleteNotifyEvent* ce = (XPresentCompleteNotifyEvent*)ev.xcookie.data;
+					twm_window_data* data = twm_get_window_data(ce->window);
+
+					if (data && ce->kind == PresentCompleteKindPixmap) {
+						if (ce->mode == PresentCompleteModeSkip) {
+							data->skipped++;
+						}
+						else {
+							evt->type = TWM_EVENT_FRAME_PRESENTED;
+							evt->frame.window = ce->window;
+							evt->frame.serial = ce->serial_number;
+							evt->frame.ust = ce->ust;
+							evt->frame.msc = ce->msc;
+							evt->frame.present_time = ce->ust / 1000000.0;
+							evt->frame.missed = data->skipped;
+
+							if (data->last_msc != 0 && ce->msc > data->last_msc + 1) {
+								evt->frame.missed += (int)(ce->msc - data->last_msc - 1);
+							}
+
+							data->last_msc = ce->msc;
+							data->skipped = 0;
+
+							result = 1;
+						}
+					}
+				}
+
+				XFreeEventData(_twm_data.display, &ev.xcookie);
+
+				return result;
+			}
+#endif
+
+			if (ev.xcookie.extension == _twm_data.opcode && XGetEventData(_twm_data.display, &ev.xcookie)) {
+				if (ev.xcookie.evtype == XI_RawMotion) {
+					XIRawEvent* re = (XIRawEvent*)ev.xcookie.data;
+
+					double dx = 0.0, dy = 0.0;
+					int valuators = 0;
+
+					for (int i = 0; i < re->valuators.mask_len * 8; i++) {
+						if (XIMaskIsSet(re->valuators.mask, i)) {
+							double val = re->raw_values[valuators++];
+							if (i == 0) dx = val;
+							if (i == 1) dy = val;
+						}
+					}
+
+					_twm_stamp_event(evt, re->time);
+					XFreeEventData(_twm_data.display, &ev.xcookie);
+
+					return _twm_translate_rawmouse(evt, None, dx, dy);
+				}
+
+				if (ev.xcookie.evtype == XI_Motion || ev.xcookie.evtype == XI_ButtonPress || ev.xcookie.evtype == XI_ButtonRelease) {
+					XIDeviceEvent* de = (XIDeviceEvent*)ev.xcookie.data;
+
+					int type = ev.xcookie.evtype;
+					Window window = de->event;
+					int button = de->detail;
+					double x = de->event_x, y = de->event_y;
+
+					_twm_stamp_event(evt, de->time);
+					XFreeEventData(_twm_data.display, &ev.xcookie);
+
+					if (type == XI_Motion) return _twm_x11_mouse_motion(evt, window, x, y);
+
+					return _twm_x11_mouse_button(evt, window, button, x, y, type == XI_ButtonPress);
+				}
+
+				XFreeEventData(_twm_data.display, &ev.xcookie);
+			}
+
+			break;
+		}
+
+		case ClientMessage: {
+			if (ev.xclient.data.l[0] == _twm_data.atom[TWM_X11_ATOM_DELETE]) {
+				evt->type = TWM_EVENT_WINDOW_CLOSE;
+				evt->window.window = ev.xclient.window;
+
+				twm_window_data* data = twm_get_window_data(ev.xclient.window);
+
+				if (data) data->was_closed = true;
+
+				return 1;
+			}
+
+			break;
+		}
+
+		case PropertyNotify: {
+			if (ev.xproperty.atom == _twm_data.atom[TWM_X11_ATOM_NET_WM_STATE]) {
+				twm_window_data* data = twm_get_window_data(ev.xproperty.window);
+
+				if (!data) break;
+
+				Atom actual_type;
+				int actual_format;
+				unsigned long nitems, bytes_after;
+				unsigned char* prop = NULL;
+
+				if (XGetWindowProperty(ev.xproperty.display, ev.xproperty.window, _twm_data.atom[TWM_X11_ATOM_NET_WM_STATE], 0, (~0L), False, XA_ATOM,
+					&actual_type, &actual_format,
+					&nitems, &bytes_after, &prop) == Success && prop)
+				{
+					int maximized = 0, minimized = 0;
+
+					for (unsigned long i = 0; i < nitems; ++i) {
+						Atom state = ((Atom*)prop)[i];
+						if (state == _twm_data.atom[TWM_X11_ATOM_NET_WM_STATE_MAX_HORZ] || state == _twm_data.atom[TWM_X11_ATOM_NET_WM_STATE_MAX_VERT])
+							maximized++;
+						if (state == _twm_data.atom[TWM_X11_ATOM_NET_WM_STATE_HIDDEN])
+							minimized = 1;
+					}
+
+					XFree(prop);
+
+					if (minimized) {
+						if (data->state != 1) {
+							data->state = 1;
+							evt->type = TWM_EVENT_WINDOW_MINIMIZE;
+							evt->window.window = ev.xclient.window;
+
+							return 1;
+						}
+					}
+					else if (maximized >= 2) {
+						if (data->state != 2) {
+							data->state = 2;
+							evt->type = TWM_EVENT_WINDOW_MAXIMIZE;
+							evt->window.window = ev.xclient.window;
+
+							return 1;
+						}
+					}
+					else if (data->state != 0) {
+						data->state = 0;
+						evt->type = TWM_EVENT_WINDOW_RESTORE;
+						evt->window.window = ev.xclient.window;
+
+						return 1;
+					}
+				}
+			}
+
+			break;
+		}
+
+		case ReparentNotify: {
+			twm_window_data* data = twm_get_window_data(ev.xreparent.window);
+
+			if (data) data->parent = ev.xreparent.parent;
+
+			break;
+		}
+
+		case ConfigureNotify: {
+			twm_window_data* data = twm_get_window_data(ev.xconfigure.window);
+
+			if (!data) break;
+
+			// Synthetic configures from the WM carry root coordinates, real ones only do when not reparented
+			bool root_relative = ev.xconfigure.send_event || data->parent == DefaultRootWindow(_twm_data.display);
+			bool moved = root_relative && (data->x != ev.xconfigure.x || data->y != ev.xconfigure.y);
+			bool resized = data->width != ev.xconfigure.width || data->height != ev.xconfigure.height;
+
+			if (moved) {
+				data->x = ev.xconfigure.x;
+				data->y = ev.xconfigure.y;
+			}
+
+			if (resized) {
+				data->width = ev.xconfigure.width;
+				data->height = ev.xconfigure.height;
+				data->was_resized = true;
+			}
+
+			if (_twm_data.window.coalesce) {
+				data->pending_size |= resized;
+				data->pending_move |= moved;
+
+				break;
+			}
+
+			if (resized) {
+				_twm_x11_window_event(evt, TWM_EVENT_WINDOW_SIZE, ev.xconfigure.window, data);
+
+				if (moved) {
+					twm_event move = *evt;
+					_twm_x11_window_event(&move, TWM_EVENT_WINDOW_MOVE, ev.xconfigure.window, data);
+					_twm_push_event(&move);
+				}
+
+				return 1;
+			}
+
+			if (moved) {
+				_twm_x11_window_event(evt, TWM_EVENT_WINDOW_MOVE, ev.xconfigure.window, data);
+
+				return 1;
+			}
+
+			break;
+		}
+
+		case FocusIn: {
+			if ((ev.xfocus.mode == NotifyNormal || ev.xfocus.mode == NotifyUngrab) && (ev.xfocus.detail == NotifyNonlinear || ev.xfocus.detail == NotifyNonlinearVirtual)) {
+				evt->type = TWM_EVENT_WINDOW_ACTIVE;
+				evt->window.window = ev.xfocus.window;
+
+				_twm_data.raw_input.focus = ev.xfocus.window;
+				_twm_x11_update_raw_input();
+
+				return 1;
+			}
+
+			break;
+		}
+
+		case FocusOut: {
+			if ((ev.xfocus.mode == NotifyNormal || ev.xfocus.mode == NotifyGrab) && ev.xfocus.detail != NotifyInferior) {
+				evt->type = TWM_EVENT_WINDOW_INACTIVE;
+				evt->window.window = ev.xfocus.window;
+
+				if (_twm_data.raw_input.focus == ev.xfocus.window) {
+					_twm_data.raw_input.focus = None;
+					_twm_x11_update_raw_input();
+				}
+
+				return 1;
+			}
+
+			break;
+		}
+
+		case ButtonPress:
+		case ButtonRelease:
+			return _twm_x11_mouse_button(evt, ev.xbutton.window, ev.xbutton.button, ev.xbutton.x, ev.xbutton.y, ev.type == ButtonPress);
+
+		case MotionNotify:
+			return _twm_x11_mouse_motion(evt, ev.xmotion.window, ev.xmotion.x, ev.xmotion.y);
+
+		case EnterNotify:
+			if (ev.type == EnterNotify && ev.xcrossing.mode == NotifyNormal && ev.xcrossing.detail != NotifyInferior) {
+				evt->type = TWM_EVENT_MOUSE_ENTER;
+				evt->window.window = ev.xbutton.window;
+
+				return 1;
+			}
+			break;
+
+		case LeaveNotify:
+			if (ev.type == LeaveNotify && ev.xcrossing.mode == NotifyNormal && ev.xcrossing.detail != NotifyInferior) {
+				evt->type = TWM_EVENT_MOUSE_LEAVE;
+				evt->window.window = ev.xbutton.window;
+
+				return 1;
+			}
+			break;
+
+		case KeyPress: {
+			evt->type = TWM_EVENT_KEY_DOWN;
+			evt->keyboard.window = ev.xkey.window;
+
+			_twm_x11_track_keymod(ev.xkey.keycode, true);
+
+			evt->keyboard.key = XkbKeycodeToKeysym(_twm_data.display, ev.xkey.keycode, 0, 1) & 0x1FF;
+			evt->keyboard.modifiers = _twm_data.keyboard.modifiers = twm_get_keymods(&ev.xkey);
+
+			_twm_data.keyboard.keys[evt->keyboard.key] = true;
+
+			Status status;
+
+			memset(evt->keyboard.chr, 0, sizeof(evt->keyboard.chr));
+			Xutf8LookupString(_twm_data.xic, &ev.xkey, evt->keyboard.chr, 5, NULL, &status);
+
+			// The character follows its KEY_DOWN through the local queue, no round trip to the server
+			if (!XFilterEvent(&ev, ev.xany.window) && status == XLookupChars) {
+				twm_event chr = *evt;
+				chr.type = TWM_EVENT_KEY_CHAR;
+
+				if (evt->keyboard.key <= 0) {
+					*evt = chr;
+
+					return 1;
+				}
+
+				_twm_push_event(&chr);
+			}
+
+			if (evt->keyboard.key <= 0) break;
+
+			return 1;
+		}
+
+		case KeyRelease: {
+			if (XEventsQueued(ev.xkey.display, QueuedAfterReading)) {
+				XEvent e;
+				XPeekEvent(ev.xkey.display, &e);
+
+				if (e.type == KeyPress && e.xkey.time == ev.xkey.time && e.xkey.keycode == ev.xkey.keycode)
+				{
+					XNextEvent(ev.xkey.display, &ev);
+
+					if (!XFilterEvent(&ev, ev.xkey.window)) {
+						Status status;
+
+						int len = Xutf8LookupString(_twm_data.xic, &ev.xkey, evt->keyboard.chr, 5, NULL, &status);
+
+						if (status == XLookupChars) {
+							evt->type = TWM_EVENT_KEY_CHAR;
+
+							evt->keyboard.key = XkbKeycodeToKeysym(_twm_data.display, ev.xkey.keycode, 0, 1) & 0x1FF;
+							evt->keyboard.modifiers = twm_get_keymods(&ev.xkey);
+
+							return 1;
+						}
+					}
+				}
+			}
+
+			evt->type = TWM_EVENT_KEY_UP;
+			evt->keyboard.window = ev.xkey.window;
+
+			_twm_x11_track_keymod(ev.xkey.keycode, false);
+
+			evt->keyboard.key = XkbKeycodeToKeysym(_twm_data.display, ev.xkey.keycode, 0, 1) & 0x1FF;
+			evt->keyboard.modifiers = _twm_data.keyboard.modifiers = twm_get_keymods(&ev.xkey);
+			_twm_data.keyboard.keys[evt->keyboard.key] = false;
+
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+static void _twm_platform_wait_event(twm_event * evt) {
+	_twm_platform_wait_event_timeout(evt, -1.0);
+}
+
+// A negative timeout waits forever, returns 0 when the timeout expires
+static int _twm_platform_wait_event_timeout(twm_event* evt, double seconds) {
+	double deadline = twm_time() + seconds;
+
+	struct pollfd fds[2 + TWM_MAX_WATCH_FDS];
+
+	for (;;) {
+		if (_twm_platform_peek_event(evt)) return 1;
+
+		int timeout = -1;
+
+		if (seconds >= 0.0) {
+			double remaining = deadline - twm_time();
+
+			if (remaining <= 0.0) return 0;
+
+			timeout = (int)ceil(remaining * 1000.0);
+		}
+
+		fds[0].fd = ConnectionNumber(_twm_data.display);
+		fds[0].events = POLLIN;
+		fds[0].revents = 0;
+
+		fds[1].fd = _twm_data.wakeup[0];
+		fds[1].events = POLLIN;
+		fds[1].revents = 0;
+
+		for (int i = 0; i < _twm_data.watch.count; i++) {
+			fds[i + 2].fd = _twm_data.watch.fd[i];
+			fds[i + 2].events = POLLIN;
+			fds[i + 2].revents = 0;
+		}
+
+		int ready = poll(fds, 2 + _twm_data.watch.count, timeout);
+
+		if (ready < 0 && errno != EINTR) return 0;
+		if (ready <= 0) continue;
+
+		if (fds[1].revents & POLLIN) {
+			char drain[64];
+			while (read(_twm_data.wakeup[0], drain, sizeof(drain)) > 0);
+		}
+
+		// Start after the last reported fd so a busy one cannot starve the others
+		for (int i = 0; i < _twm_data.watch.count; i++) {
+			int index = (_twm_data.watch.next + i) % _twm_data.watch.count;
+
+			if (fds[index + 2].revents & (POLLIN | POLLHUP | POLLERR | POLLNVAL)) {
+				_twm_data.watch.next = index + 1;
+
+				_twm_stamp_event(evt, 0);
+				evt->type = TWM_EVENT_FD_READY;
+				evt->fd.fd = fds[index + 2].fd;
+
+				// Closed without twm_unwatch_fd, poll would report it again on every pass
+				if (fds[index + 2].revents & POLLNVAL) twm_unwatch_fd(evt->fd.fd);
+
+				return 1;
+			}
+		}
+	}
+}
+
+int twm_connection_fd() {
+	return ConnectionNumber(_twm_data.display);
+}
+
+// For tools that need the connection itself, such as counting requests, events still go through tinywm
+Display* twm_x11_display() {
+	return _twm_data.display;
+}
+
+bool twm_post_event(const twm_event* evt) {
+	if (!_twm_post_push(evt)) return false;
+
+	#ifdef __linux__
+		unsigned long long one = 1;
+		ssize_t written = write(_twm_data.wakeup[1], &one, sizeof(one));
+	#else
+		char one = 1;
+		ssize_t written = write(_twm_data.wakeup[1], &one, sizeof(one));
+	#endif
+
+	(void)written;
+
+	return true;
+}
+
+bool twm_watch_fd(int fd) {
+	if (fd < 0 || _twm_data.watch.count == TWM_MAX_WATCH_FDS) return false;
+
+	for (int i = 0; i < _twm_data.watch.count; i++) {
+		if (_twm_data.watch.fd[i] == fd) return true;
+	}
+
+	_twm_data.watch.fd[_twm_data.watch.count++] = fd;
+
+	return true;
+}
+
+void twm_unwatch_fd(int fd) {
+	for (int i = 0; i < _twm_data.watch.count; i++) {
+		if (_twm_data.watch.fd[i] == fd) {
+			_twm_data.watch.fd[i] = _twm_data.watch.fd[--_twm_data.watch.count];
+			_twm_data.watch.next = 0;
+
+			return;
+		}
+	}
+}
+
+static inline int _twm_translate_event(twm_event* evt) {
+	if (!_twm_x11_translate_event(evt)) return 0;
+
+	_twm_x11_order_after_motion(evt);
+
+	return 1;
+}
+
+static int _twm_platform_peek_event(twm_event* evt) {
+	if (_twm_pop_event(evt)) return 1;
+
+	while (XPending(_twm_data.display)) {
+		if (_twm_translate_event(evt)) return 1;
+		if (_twm_pop_event(evt)) return 1;
+	}
+
+	if (_twm_x11_flush_motion(evt)) return 1;
+	if (_twm_flush_rawmouse(evt)) return 1;
+
+	return _twm_x11_flush_window_events(evt);
+}
+
+static int _twm_platform_peek_events(twm_event* events, int max) {
+	int count = 0;
+	while (count < max && _twm_pop_event(&events[count])) count++;
+
+	// One read from the socket per batch, then drain Xlib's local queue without further I/O
+	if (count < max) XEventsQueued(_twm_data.display, QueuedAfterReading);
+
+	while (count < max && XQLength(_twm_data.display) > 0) {
+		if (_twm_translate_event(&events[count])) count++;
+		while (count < max && _twm_pop_event(&events[count])) count++;
+	}
+
+	while (count < max && _twm_x11_flush_motion(&events[count])) count++;
+	if (count < max) count += _twm_flush_rawmouse(&events[count]);
+	while (count < max && _twm_x11_flush_window_events(&events[count])) count++;
+
+	return count;
+}
+
+static int _twm_x11_shm_error;
+
+static int _twm_x11_shm_error_handler(Display* display, XErrorEvent* error) {
+	_twm_x11_shm_error = 1;
+
+	return 0;
+}
+
+static Bool _twm_x11_shm_completion_predicate(Display* display, XEvent* ev, XPointer arg) {
+	return ev->type == _twm_data.shm_event + ShmCompletion && ((XShmCompletionEvent*)ev)->shmseg == *(ShmSeg*)arg;
+}
+
+static inline void _twm_x11_free_framebuffer_buffers(twm_framebuffer framebuffer) {
+	for (int i = 0; i < 2; i++) {
+		XImage* image = framebuffer->buffer[i].image;
+
+		if (!image) continue;
+
+		if (framebuffer->shm) {
+			XShmDetach(_twm_data.display, &framebuffer->buffer[i].info);
+			shmdt(framebuffer->buffer[i].info.shmaddr);
+			image->data = NULL;
+		}
+
+		XDestroyImage(image);
+
+		framebuffer->buffer[i].image = NULL;
+		framebuffer->buffer[i].busy = false;
+	}
+}
+
+static inline bool _twm_x11_alloc_shm_image(twm_framebuffer framebuffer, int i, int width, int height) {
+	XShmSegmentInfo* info = &framebuffer->buffer[i].info;
+
+	XImage* image = XShmCreateImage(_twm_data.display, framebuffer->visual, framebuffer->depth, ZPixmap, NULL, info, width, height);
+
+	if (!image) return false;
+
+	info->shmid = shmget(IPC_PRIVATE, image->bytes_per_line * image->height, IPC_CREAT | 0600);
+
+	if (info->shmid < 0) {
+		XDestroyImage(image);
+
+		return false;
+	}
+
+	info->shmaddr = image->data = (char*)shmat(info->shmid, NULL, 0);
+	info->readOnly = False;
+
+	// Attaching fails asynchronously on remote displays, so sync and catch the error here
+	_twm_x11_shm_error = 0;
+	XErrorHandler handler = XSetErrorHandler(_twm_x11_shm_error_handler);
+
+	if (info->shmaddr != (char*)-1) {
+		XShmAttach(_twm_data.display, info);
+		XSync(_twm_data.display, False);
+	}
+
+	XSetErrorHandler(handler);
+
+	// The segment goes away once both sides detach
+	shmctl(info->shmid, IPC_RMID, NULL);
+
+	if (info->shmaddr == (char*)-1 || _twm_x11_shm_error) {
+		if (info->shmaddr != (char*)-1) shmdt(info->shmaddr);
+
+		image->data = NULL;
+		XDestroyImage(image);
+
+		return false;
+	}
+
+	framebuffer->buffer[i].image = image;
+
+	return true;
+}
+
+static inline bool _twm_x11_alloc_framebuffer_buffers(twm_framebuffer framebuffer, int width, int height) {
+	if (width <= 0 || height <= 0) return false;
+
+	framebuffer->width = width;
+	framebuffer->height = height;
+
+	if (framebuffer->shm) {
+		if (_twm_x11_alloc_shm_image(framebuffer, 0, width, height) && _twm_x11_alloc_shm_image(framebuffer, 1, width, height)) return true;
+
+		_twm_x11_free_framebuffer_buffers(framebuffer);
+
+		framebuffer->shm = false;
+	}
+
+	for (int i = 0; i < 2; i++) {
+		char* data = (char*)malloc((size_t)width * height * 4);
+
+		if (data) framebuffer->buffer[i].image = XCreateImage(_twm_data.display, framebuffer->visual, framebuffer->depth, ZPixmap, 0, data, width, height, 32, width * 4);
+
+		if (!framebuffer->buffer[i].image) {
+			free(data);
+			_twm_x11_free_framebuffer_buffers(framebuffer);
+
+			return false;
+		}
+	}
+
+	return true;
+}
+
+twm_framebuffer twm_create_framebuffer(twm_window window) {
+	XWindowAttributes attributes;
+
+	if (!XGetWindowAttributes(_twm_data.display, window, &attributes)) return NULL;
+
+	// Pixels are handed out as XRGB8888
+	if (attributes.depth != 24 && attributes.depth != 32) return NULL;
+
+	twm_framebuffer framebuffer = (twm_framebuffer)calloc(1, sizeof(struct _twm_framebuffer));
+
+	if (framebuffer == NULL) return NULL;
+
+	framebuffer->window = window;
+	framebuffer->visual = attributes.visual;
+	framebuffer->depth = attributes.depth;
+	framebuffer->gc = XCreateGC(_twm_data.display, window, 0, NULL);
+	framebuffer->shm = _twm_data.shm_event >= 0;
+
+	if (!_twm_x11_alloc_framebuffer_buffers(framebuffer, attributes.width, attributes.height)) {
+		XFreeGC(_twm_data.display, framebuffer->gc);
+		free(framebuffer);
+
+		return NULL;
+	}
+
+	framebuffer->next = _twm_data.framebuffers;
+	_twm_data.framebuffers = framebuffer;
+
+	return framebuffer;
+}
+
+void twm_destroy_framebuffer(twm_framebuffer framebuffer) {
+	if (framebuffer == NULL) return;
+
+	for (twm_framebuffer* link = &_twm_data.framebuffers; *link; link = &(*link)->next) {
+		if (*link == framebuffer) {
+			*link = framebuffer->next;
+			break;
+		}
+	}
+
+	_twm_x11_free_framebuffer_buffers(framebuffer);
+	XFreeGC(_twm_data.display, framebuffer->gc);
+	free(framebuffer);
+}
+
+unsigned int* twm_framebuffer_pixels(twm_framebuffer framebuffer, int* width, int* height, int* stride) {
+	twm_window_data* data = twm_get_window_data(framebuffer->window);
+
+	if (data && (data->width != framebuffer->width || data->height != framebuffer->height)) {
+		_twm_x11_free_framebuffer_buffers(framebuffer);
+
+		framebuffer->shm = _twm_data.shm_event >= 0;
+
+		if (!_twm_x11_alloc_framebuffer_buffers(framebuffer, data->width, data->height)) return NULL;
+	}
+
+	XImage* image = framebuffer->buffer[framebuffer->back].image;
+
+	if (!image) return NULL;
+
+	// The server may still be reading this buffer from two frames ago
+	if (framebuffer->buffer[framebuffer->back].busy) {
+		XEvent ev;
+		XIfEvent(_twm_data.display, &ev, _twm_x11_shm_completion_predicate, (XPointer)&framebuffer->buffer[framebuffer->back].info.shmseg);
+
+		framebuffer->buffer[framebuffer->back].busy = false;
+	}
+
+	if (width) *width = framebuffer->width;
+	if (height) *height = framebuffer->height;
+	if (stride) *stride = image->bytes_per_line / 4;
+
+	return (unsigned int*)image->data;
+}
+
+void twm_present_framebuffer(twm_framebuffer framebuffer) {
+	XImage* image = framebuffer->buffer[framebuffer->back].image;
+
+	if (!image) return;
+
+	if (framebuffer->shm) {
+		XShmPutImage(_twm_data.display, framebuffer->window, framebuffer->gc, image, 0, 0, 0, 0, framebuffer->width, framebuffer->height, True);
+		framebuffer->buffer[framebuffer->back].busy = true;
+	}
+	else {
+		XPutImage(_twm_data.display, framebuffer->window, framebuffer->gc, image, 0, 0, 0, 0, framebuffer->width, framebuffer->height);
+	}
+
+	XFlush(_twm_data.display);
+
+	framebuffer->back ^= 1;
+}
+
+// Present reports completions for every client presenting to the window, including the GL driver
+bool twm_window_present_feedback(twm_window window, bool enable) {
+#ifdef TWM_PRESENT
+	twm_window_data* data = twm_get_window_data(window);
+
+	if (!data || _twm_data.present_opcode < 0) return false;
+
+	if (enable && !data->present_eid) {
+		data->present_eid = XPresentSelectInput(_twm_data.display, window, PresentCompleteNotifyMask);
+		data->last_msc = 0;
+		data->skipped = 0;
+	}
+	else if (!enable && data->present_eid) {
+		XPresentFreeInput(_twm_data.display, window, data->present_eid);
+		data->present_eid = 0;
+	}
+
+	XFlush(_twm_data.display);
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+#ifdef TWM_GL
+void twm_gl_set_pixel_attribs(int pixel_attribs[]) {
+	int i = 0;
+	while (pixel_attribs[i] != 0) {
+		switch (pixel_attribs[i]) {
+		case TWM_GL_DOUBLE_BUFFER:
+			_twm_data.pixel_attribs[9] = pixel_attribs[++i];
+			break;
+		case TWM_GL_COLOR_BITS: {
+			// Split the total over the channels: 16 is 5/6/5, 24 is 8/8/8, 32 and up also carry a quarter as alpha
+			int bits = pixel_attribs[++i];
+			int alpha = bits >= 32 ? bits / 4 : 0;
+			int channel = (bits - alpha) / 3;
+
+			_twm_data.pixel_attribs[11] = channel;
+			_twm_data.pixel_attribs[13] = bits - alpha - channel * 2;
+			_twm_data.pixel_attribs[15] = channel;
+			_twm_data.pixel_attribs[17] = alpha;
+			break;
+		}
+		case TWM_GL_ALPHA_BITS:
+			_twm_data.pixel_attribs[17] = pixel_attribs[++i];
+			break;
+		case TWM_GL_DEPTH_BITS:
+			_twm_data.pixel_attribs[19] = pixel_attribs[++i];
+			break;
+		case TWM_GL_STENCIL_BITS:
+			_twm_data.pixel_attribs[21] = pixel_attribs[++i];
+			break;
+		case TWM_GL_SRGB_CAPABLE:
+			_twm_data.pixel_attribs[23] = pixel_attribs[++i];
+			break;
+		case TWM_GL_SAMPLE_BUFFERS:
+			_twm_data.pixel_attribs[25] = pixel_attribs[++i];
+			break;
+		case TWM_GL_SAMPLES:
+			_twm_data.pixel_attribs[27] = pixel_attribs[++i];
+			break;
+		}
+		i++;
+	}
+}
+
+static GLXContext _twm_x11_gl_create_context(GLXFBConfig fbconfig, int* attribs, twm_gl_context share) {
+	int context_attribs[] = {
+		GLX_CONTEXT_MAJOR_VERSION_ARB, 4,
+		GLX_CONTEXT_MINOR_VERSION_ARB, 6,
+		GLX_CONTEXT_PROFILE_MASK_ARB,  GLX_CONTEXT_CORE_PROFILE_BIT_ARB,
+		None
+	};
+
+	int i = 0;
+	while (attribs && attribs[i] != 0) {
+		switch (attribs[i]) {
+		case TWM_GL_CONTEXT_MAJOR_VERSION:
+			context_attribs[1] = attribs[++i];
+			break;
+
+		case TWM_GL_CONTEXT_MINOR_VERSION:
+			context_attribs[3] = attribs[++i];
+			break;
+
+		case TWM_GL_CONTEXT_PROFILE_MASK:
+			switch (attribs[++i]) {
+			case TWM_GL_CONTEXT_CORE_PROFILE:
+				context_attribs[5] = GLX_CONTEXT_CORE_PROFILE_BIT_ARB;
+				break;
+			case TWM_GL_CONTEXT_COMPATIBILITY_PROFILE:
+				context_attribs[5] = GLX_CONTEXT_COMPATIBILITY_PROFILE_BIT_ARB;
+				break;
+			}
+			break;
+		}
+		i++;
+	}
+
+	return _twm_data.glXCreateContextAttribsARB(_twm_data.display, fbconfig, share ? share->context : NULL, True, context_attribs);
+}
+
+twm_gl_context twm_gl_create_context(twm_window window, int* attribs) {
+	return twm_gl_create_shared_context(window, attribs, NULL);
+}
+
+// Shares textures, buffers and other objects with share, which may be current on another thread
+twm_gl_context twm_gl_create_shared_context(twm_window window, int* attribs, twm_gl_context share) {
+	twm_window_data* data = twm_get_window_data(window);
+
+	if (data == NULL) return NULL;
+
+	twm_gl_context context = (twm_gl_context)calloc(1, sizeof(struct _twm_gl_context));
+
+	if (context == NULL) return NULL;
+
+	context->window = window;
+	context->context = _twm_x11_gl_create_context(data->fbconfig, attribs, share);
+
+	if (context->context == NULL) {
+		free(context);
+
+		return NULL;
+	}
+
+	return context;
+}
+
+// Windowless context on a 1x1 pbuffer for worker threads uploading resources, render into FBOs only
+twm_gl_context twm_gl_create_offscreen_context(int* attribs, twm_gl_context share) {
+	int pixel_attribs[TWM_GL_PIXEL_ATTRIBS_SIZE];
+	memcpy(pixel_attribs, _twm_data.pixel_attribs, sizeof(pixel_attribs));
+
+	// Configs usable for both windows and pbuffers are the likeliest to be share compatible
+	pixel_attribs[1] = False;
+	pixel_attribs[3] = GLX_WINDOW_BIT | GLX_PBUFFER_BIT;
+	pixel_attribs[7] = GLX_DONT_CARE;
+
+	_twm_gl_config* config = _twm_x11_gl_config(pixel_attribs);
+
+	if (config == NULL) {
+		pixel_attribs[3] = GLX_PBUFFER_BIT;
+		config = _twm_x11_gl_config(pixel_attribs);
+	}
+
+	if (config == NULL) return NULL;
+
+	GLXFBConfig fbconfig = config->fbconfig;
+
+	twm_gl_context context = (twm_gl_context)calloc(1, sizeof(struct _twm_gl_context));
+
+	if (context == NULL) return NULL;
+
+	int pbuffer_attribs[] = {
+		GLX_PBUFFER_WIDTH, 1,
+		GLX_PBUFFER_HEIGHT, 1,
+		None
+	};
+
+	context->pbuffer = glXCreatePbuffer(_twm_data.display, fbconfig, pbuffer_attribs);
+	context->window = context->pbuffer;
+	context->context = _twm_x11_gl_create_context(fbconfig, attribs, share);
+
+	if (context->context == NULL) {
+		if (context->pbuffer) glXDestroyPbuffer(_twm_data.display, context->pbuffer);
+		free(context);
+
+		return NULL;
+	}
+
+	return context;
+}
+
+void twm_gl_delete_context(twm_gl_context context) {
+	if (glXGetCurrentContext() == context->context) {
+		glXMakeContextCurrent(_twm_data.display, None, None, NULL);
+	}
+
+	glXDestroyContext(_twm_data.display, context->context);
+
+	if (context->pbuffer) glXDestroyPbuffer(_twm_data.display, context->pbuffer);
+
+	free(context);
+}
+#endif
+
+#ifdef TWM_VULKAN
+const char** twm_vk_get_instance_extensions(int* extension_count) {
+	static const char* extensions[] = {
+		VK_KHR_SURFACE_EXTENSION_NAME,
+		VK_KHR_XLIB_SURFACE_EXTENSION_NAME
+	};
+
+	*extension_count = sizeof(extensions) / sizeof(extensions[0]);
+
+	return extensions;
+}
+
+VkResult twm_vk_create_surface(twm_window window, VkInstance instance, const VkAllocationCallbacks* pAllocator, VkSurfaceKHR* pSurface) {
+	VkXlibSurfaceCreateInfoKHR surface_info;
+	surface_info.sType = VK_STRUCTURE_TYPE_XLIB_SURFACE_CREATE_INFO_KHR;
+	surface_info.dpy = _twm_data.display;
+	surface_info.window = window;
+	surface_info.flags = 0;
+	surface_info.pNext = NULL;
+
+	return vkCreateXlibSurfaceKHR(instance, &surface_info, pAllocator, pSurface);
+}
+#endif
+
+#elif defined(TWM_COCOA)
+
+#ifdef __OBJC__
+twm_data _twm_data = { 0 };
+
+#define RESIZE_BORDER 10
+
+NSString* translate_input_for_keydown(NSEvent* event, UInt32* deadKeyState);
+ResizeEdge detect_resize_edge(NSPoint mousePos, NSRect frame);
+bool is_mouse_in_client_area(NSEvent* event);
+
+@implementation _twm_window
+- (BOOL)windowShouldClose:(NSWindow*)sender {
+    self.was_closed = true;
+    
+    NSEvent* customEvent = [NSEvent otherEventWithType : NSEventTypeApplicationDefined
+		location : sender.frame.origin
+		modifierFlags : 0
+		timestamp : [NSDate timeIntervalSinceReferenceDate]
+		windowNumber : [sender windowNumber]
+		context : nil
+		subtype : TWM_EVENT_WINDOW_CLOSE
+		data1 : sender.frame.origin.x
+		data2 : sender.frame.origin.y];
+	[NSApp postEvent : customEvent atStart : NO] ;
+
+	return FALSE;
+}
+
+- (void)windowDidResize:(NSNotification*)notification {
+    NSRect frame = [self frame];
+    NSSize contentSize = [[self contentView] frame].size;
+    
+    if (contentSize.width != self.width || contentSize.height != self.height) {
+        self.was_resized = true;
+        self.width = contentSize.width;
+        self.height = contentSize.height;
+        
+        NSEvent* customEvent = [NSEvent otherEventWithType : NSEventTypeApplicationDefined
+            location : self.frame.origin
+            modifierFlags : 0
+            timestamp : [NSDate timeIntervalSinceReferenceDate]
+            windowNumber : [self windowNumber]
+            context : nil
+            subtype : TWM_EVENT_WINDOW_SIZE
+            data1 : contentSize.width
+            data2 : contentSize.height];
+
+        [NSApp postEvent : customEvent atStart : YES];
+    }
+}
+
+- (void)windowDidMove:(NSNotification*)notification {
+	NSRect frame = [self frame];
+
+	NSScreen* screen = [self screen];
+	CGFloat screenHeight = screen.frame.size.height;
+
+	CGFloat yFromTop = screenHeight - frame.origin.y - frame.size.height;
+
+	self.x = (int)self.frame.origin.x;
+    self.y = (int)yFromTop;
+
+	NSEvent* customEvent = [NSEvent otherEventWithType : NSEventTypeApplicationDefined
+		location : self.frame.origin
+		modifierFlags : 0
+		timestamp : [NSDate timeIntervalSinceReferenceDate]
+		windowNumber : [self windowNumber]
+		context : nil
+		subtype : TWM_EVENT_WINDOW_MOVE
+		data1 : self.frame.origin.x
+		data2 : yFromTop];
+	[NSApp postEvent : customEvent atStart : NO];
+}
+
+- (void)windowDidMiniaturize:(NSNotification*)notification {
+	NSWindow* sender = notification.object;
+
+	NSEvent* customEvent = [NSEvent otherEventWithType : NSEventTypeApplicationDefined
+		location : self.frame.origin
+		modifierFlags : 0
+		timestamp : [NSDate timeIntervalSinceReferenceDate]
+		windowNumber : [self windowNumber]
+		context : nil
+		subtype : TWM_EVENT_WINDOW_MINIMIZE
+		data1 : 0
+		data2 : 0];
+	[NSApp postEvent : customEvent atStart : NO] ;
+}
+
+- (void)windowDidDeminiaturize:(NSNotification*)notification {
+	NSWindow* sender = notification.object;
+
+	NSEvent* customEvent = [NSEvent otherEventWithType : NSEventTypeApplicationDefined
+		location : self.frame.origin
+		modifierFlags : 0
+		timestamp : [NSDate timeIntervalSinceReferenceDate]
+		windowNumber : [self windowNumber]
+		context : nil
+		subtype : TWM_EVENT_WINDOW_RESTORE
+		data1 : 0
+		data2 : 0];
+	[NSApp postEvent : customEvent atStart : NO] ;
+}
+
+- (void)windowDidBecomeKey:(NSNotification*)notification {
+	NSWindow* sender = notification.object;
+
+	NSEvent* customEvent = [NSEvent otherEventWithType : NSEventTypeApplicationDefined
+		location : self.frame.origin
+		modifierFlags : 0
+		timestamp : [NSDate timeIntervalSinceReferenceDate]
+		windowNumber : [self windowNumber]
+		context : nil
+		subtype : TWM_EVENT_WINDOW_ACTIVE
+		data1 : 0
+		data2 : 0];
+	[NSApp postEvent : customEvent atStart : NO] ;
+}
+
+- (void)windowDidResignKey:(NSNotification*)notification {
+	NSEvent* customEvent = [NSEvent otherEventWithType : NSEventTypeApplicationDefined
+		location : self.frame.origin
+		modifierFlags : 0
+		timestamp : [NSDate timeIntervalSinceReferenceDate]
+		windowNumber : [self windowNumber]
+		context : nil
+		subtype : TWM_EVENT_WINDOW_INACTIVE
+		data1 : 0
+		data2 : 0];
+	[NSApp postEvent : customEvent atStart : NO] ;
+}
+@end
+
+int twm_init() {
+	setlocale(LC_ALL, "");
+
+    _twm_data.cursor_visible = true;
+
+	_twm_init_post_queue();
+    
+    #pragma clang diagnostic push
+    #pragma clang diagnostic ignored "-Wdeprecated-declarations"
+    
+    CGGetActiveDisplayList(0, NULL, (uint32_t*)&_twm_data.screen.count);
+	_twm_data.screen.display_ids = malloc(sizeof(CGDirectDisplayID) * _twm_data.screen.count);
+    CGGetActiveDisplayList(_twm_data.screen.count, _twm_data.screen.display_ids, (uint32_t*)&_twm_data.screen.count);
+
+	_twm_data.screen.screen = malloc(sizeof(twm_screen) * _twm_data.screen.count);
+
+    for (uint32_t i = 0; i < _twm_data.screen.count; i++) {
+        twm_screen* screen = &_twm_data.screen.screen[i];
+
+        screen->display_id = _twm_data.screen.display_ids[i];
+
+		CGRect bounds = CGDisplayBounds(screen->display_id);
+		screen->x = bounds.origin.x;
+		screen->y = bounds.origin.y;
+		screen->width = bounds.size.width;
+		screen->height = bounds.size.height;
+
+		io_service_t servicePort = CGDisplayIOServicePort(screen->display_id);
+		CFDictionaryRef dict = IODisplayCreateInfoDictionary(servicePort, kIODisplayOnlyPreferredName);
+		if (dict) {
+			CFDictionaryRef names;
+			if (CFDictionaryGetValueIfPresent(dict, CFSTR(kDisplayProductName), (const void**)&names)) {
+				CFStringRef name;
+				if (CFDictionaryGetValueIfPresent(names, CFSTR("en_US"), (const void**)&name)) {
+					CFStringGetCString(name, screen->name, sizeof(screen->name), kCFStringEncodingUTF8);
+				}
+			}
+			CFRelease(dict);
+        }
+
+        CGDisplayModeRef current_mode = CGDisplayCopyDisplayMode(screen->display_id);
+
+        int width = (int)CGDisplayModeGetWidth(current_mode);
+        int height = (int)CGDisplayModeGetHeight(current_mode);
+        int current_bpp = 0;
+        int current_hz = (int)round(CGDisplayModeGetRefreshRate(current_mode));
+
+        CFStringRef encoding = CGDisplayModeCopyPixelEncoding(current_mode);
+        if (encoding) {
+            const char* bppStr = "Unknown";
+            if (CFStringCompare(encoding, CFSTR(IO32BitDirectPixels), 0) == kCFCompareEqualTo) {
+                current_bpp = 32;
+            } else if (CFStringCompare(encoding, CFSTR(IO16BitDirectPixels), 0) == kCFCompareEqualTo) {
+                current_bpp = 16;
+            } else if (CFStringCompare(encoding, CFSTR(IO8BitIndexedPixels), 0) == kCFCompareEqualTo) {
+                current_bpp = 8;
+            }
+         
+            CFRelease(encoding);
+        }
+
+        CGDisplayModeRelease(current_mode);
+		
+		screen->modes_ref = CGDisplayCopyAllDisplayModes(screen->display_id, NULL);
+		if (screen->modes_ref) {
+			screen->modes.count = (int)CFArrayGetCount(screen->modes_ref);
+			screen->modes.mode = malloc(sizeof(twm_screen_mode) * screen->modes.count);
+
+			for (int j = 0; j < CFArrayGetCount(screen->modes_ref); j++) {
+				twm_screen_mode * mode = &screen->modes.mode[j];
+
+				mode->mode_ref = (CGDisplayModeRef)CFArrayGetValueAtIndex(screen->modes_ref, j);
+
+				mode->width = (int)CGDisplayModeGetWidth(mode->mode_ref);
+				mode->height = (int)CGDisplayModeGetHeight(mode->mode_ref);
+				mode->refresh_rate = CGDisplayModeGetRefreshRate(mode->mode_ref);
+				mode->hz = (int)round(mode->refresh_rate);
+				mode->flags = 0;
+
+				uint32_t io_flags = CGDisplayModeGetIOFlags(mode->mode_ref);
+				if (io_flags & kDisplayModeNativeFlag) mode->flags |= TWM_SCREEN_MODE_PREFERRED;
+				if (io_flags & kDisplayModeInterlacedFlag) mode->flags |= TWM_SCREEN_MODE_INTERLACED;
+
+				encoding = CGDisplayModeCopyPixelEncoding(mode->mode_ref);
+				if (encoding) {
+					const char* bppStr = "Unknown";
+					if (CFStringCompare(encoding, CFSTR(IO32BitDirectPixels), 0) == kCFCompareEqualTo) {
+						mode->bpp = 32;
+					} else if (CFStringCompare(encoding, CFSTR(IO16BitDirectPixels), 0) == kCFCompareEqualTo) {
+						mode->bpp = 16;
+					} else if (CFStringCompare(encoding, CFSTR(IO8BitIndexedPixels), 0) == kCFCompareEqualTo) {
+						mode->bpp = 8;
+					}
+				
+					CFRelease(encoding);
+				}
+                
+                if (width == mode->width && height && mode->height && current_bpp == mode->bpp && current_hz == mode->hz) {
+                    screen->modes.current = j;
+                }
+			}
+         }
+    }
+    
+    #pragma clang diagnostic pop
+
+	@autoreleasepool{
+		_twm_data.app = [NSApplication sharedApplication];
+		[NSApp setActivationPolicy : NSApplicationActivationPolicyRegular];
+
+		#ifdef TWM_GL
+		#pragma clang diagnostic push
+		#pragma clang diagnostic ignored "-Wdeprecated-declarations"
+			NSOpenGLPixelFormatAttribute pixel_attribs[] = {
+				NSOpenGLPFAAccelerated,
+				NSOpenGLPFAOpenGLProfile, NSOpenGLProfileVersion4_1Core,
+				NSOpenGLPFAColorSize, 24,
+				NSOpenGLPFAAlphaSize, 8,
+				NSOpenGLPFADepthSize, 24,
+				NSOpenGLPFAStencilSize, 8,
+				NSOpenGLPFASampleBuffers, 1,
+				NSOpenGLPFASamples, 1,
+				NSOpenGLPFADoubleBuffer,
+				0
+			};
+
+			memcpy(_twm_data.pixel_attribs, pixel_attribs, sizeof(pixel_attribs));
+        
+            _twm_data.swap_interval = 0;
+        
+            CGDirectDisplayID displayID = CGMainDisplayID();
+        
+            twm_screen * screen = &_twm_data.screen.screen[twm_screen_default()];
+        
+            _twm_data.refresh_rate = round(CGDisplayModeGetRefreshRate(CGDisplayCopyDisplayMode(screen->display_id)));
+		#pragma clang diagnostic pop
+		#endif
+
+		return 1;
+	}
+}
+
+void twm_finalize() {
+	twm_record_end();
+	twm_replay_end();
+
+	for (int i = 0; i < _twm_data.screen.count; i++) {
+		CFRelease(_twm_data.screen.screen[i].modes_ref);
+		free(_twm_data.screen.screen[i].modes.mode);
+	}
+	free(_twm_data.screen.screen);
+	free(_twm_data.screen.display_ids);
+	
+	[_twm_data.app terminate : nil] ;
+}
+
+bool twm_change_screen_mode(int screen_index, int mode_index) {
+	if (screen_index < 0 || screen_index >= _twm_data.screen.count || mode_index < 0) return false;
+
+	twm_screen* screen = &_twm_data.screen.screen[screen_index];
+
+	if (mode_index >= screen->modes.count) return false;
+
+	if (CGDisplaySetDisplayMode(screen->display_id, screen->modes.mode[mode_index].mode_ref, NULL) != kCGErrorSuccess) return false;
+
+	screen->modes.current = mode_index;
+    
+#ifdef TWM_GL
+    _twm_data.refresh_rate = round(CGDisplayModeGetRefreshRate(screen->modes.mode[mode_index].mode_ref));
+#endif
+
+	return true;
+}
+
+twm_window twm_create_window(const char* title, int x, int y, int width, int height, unsigned int flags) {
+	int screen = twm_screen_from_cursor();
+	twm_rect screen_rect;
+	twm_screen_rect(screen, &screen_rect);
+
+    NSUInteger style = NSWindowStyleMaskClosable | NSWindowStyleMaskMiniaturizable;
+    
+    if (!(flags & TWM_WINDOW_BORDERLESS)) {
+        style |= NSWindowStyleMaskTitled;
+    }
+
+    if (flags & TWM_WINDOW_RESIZABLE) {
+        style |= NSWindowStyleMaskResizable;
+    }
+
+    NSRect contentRect = NSMakeRect(0, 0, width, height);
+    NSRect windowFrame = [NSWindow frameRectForContentRect:contentRect styleMask:style];
+
+    if (x == TWM_CENTER) x = (screen_rect.x + (screen_rect.width - width)) >> 1;
+    if (y == TWM_CENTER) y = (screen_rect.y + (screen_rect.height - (int)windowFrame.size.height)) >> 1;
+	
+	@autoreleasepool{
+        NSRect frame = NSMakeRect(x, screen_rect.height - (int)windowFrame.size.height - y, width, height);
+
+		_twm_window* window = [[_twm_window alloc]initWithContentRect:frame
+														  styleMask : style
+															backing : NSBackingStoreBuffered
+															  defer : NO];
+
+        if (flags & TWM_WINDOW_BORDERLESS) {
+            [window setHasShadow:NO];
+        }
+        
+        [window setCollectionBehavior:NSWindowCollectionBehaviorFullScreenNone];
+
+		window.resizeEdge = ResizeNone;
+        window.x = (int)frame.origin.x;
+        window.y = (int)frame.origin.y;
+        window.width = width;
+        window.height = height;
+        window.flags = flags;
+
+		window.delegate = window;
+
+		twm_title_window(window, title);
+
+		return window;
+	}
+}
+
+void twm_title_window(twm_window window, const char * title) {
+	@autoreleasepool{
+		NSString * nsTitle = [NSString stringWithUTF8String : title];
+		[window setTitle : nsTitle] ;
+	}
+}
+
+bool twm_window_was_closed(twm_window window) {
+    if (!window.was_closed) return false;
+    
+    window.was_closed = false;
+
+    return true;
+}
+
+bool twm_window_was_resized(twm_window window, int * width, int * height) {
+    if (!window.was_resized) return false;
+
+    window.was_resized = false;
+
+    *width = (int)window.contentView.frame.size.width;
+    *height = (int)window.contentView.frame.size.height;
+
+    return true;
+}
+
+void twm_show_window(twm_window window, bool visible) {
+	if (visible) {
+		[window makeKeyAndOrderFront : nil] ;
+		[NSApp activateIgnoringOtherApps : YES] ;
+	}
+	else {
+		[window orderOut : nil] ;
+	}
+}
+
+
+bool twm_window_is_visible(twm_window window) {
+	return window.isVisible;
+}
+
+void twm_move_window(twm_window window, int x, int y, int width, int height) {
+    int new_x = x, new_y = y;
+    int new_width = width, new_height = height;
+
+    if (x == TWM_CURRENT || x == TWM_CENTER) new_x = window.x;
+    if (y == TWM_CURRENT || y == TWM_CENTER) new_y = window.y;
+
+    int screen = twm_screen_from_position(new_x, new_y);
+    twm_rect screen_rect;
+    twm_screen_rect(screen, &screen_rect);
+
+    if (width == TWM_CURRENT) new_width = window.width;
+    else if (width == TWM_STRETCH) new_width = screen_rect.width - new_x;
+
+    if (height == TWM_CURRENT) new_height = window.frame.size.height;
+    else if (height == TWM_STRETCH) new_height = screen_rect.height - new_y;
+    else {
+        NSRect contentRect = NSMakeRect(0, 0, width, height);
+        NSRect windowFrame = [NSWindow frameRectForContentRect:contentRect styleMask:window.styleMask];
+        
+        new_height = (int)windowFrame.size.height;
+    }
+
+    if (x == TWM_CENTER) new_x = (screen_rect.x + (screen_rect.width - new_width)) >> 1;
+    if (y == TWM_CENTER) new_y = (screen_rect.y + (screen_rect.height - new_height)) >> 1;
+
+    NSRect frame = NSMakeRect(new_x, screen_rect.height - new_height - new_y, new_width, new_height);
+
+    [window setFrame:frame display:YES animate:NO];
+}
+
+int twm_window_width(twm_window window) {
+	return window.width;
+}
+
+int twm_window_height(twm_window window) {
+	return window.height;
+}
+
+void twm_window_size(twm_window window, int* width, int* height) {
+	*width = window.width;
+	*height = window.height;
+}
+
+int twm_window_x(twm_window window) {
+	return window.x;
+}
+
+int twm_window_y(twm_window window) {
+	return window.y;
+}
+
+void twm_window_position(twm_window window, int* x, int* y) {
+	*x = window.x;
+	*y = window.y;
+}
+
+void twm_window_rect(twm_window window, twm_rect* rect) {
+	rect->x = window.x;
+	rect->y = window.y;
+	rect->width = window.width;
+	rect->height = window.height;
+}
+
+void twm_window_borderless(twm_window window, bool enable) {
+	NSWindowStyleMask style = window.styleMask;
+
+	if (enable) {
+        window.flags |= TWM_WINDOW_BORDERLESS;
+        
+		[window setStyleMask:(style & ~NSWindowStyleMaskTitled)];
+        [window setHasShadow:NO];
+	}
+	else {
+        window.flags &= ~TWM_WINDOW_BORDERLESS;
+        
+		[window setStyleMask:(style | NSWindowStyleMaskTitled)];
+        [window setHasShadow:YES];
+	}
+}
+
+bool twm_window_is_borderless(twm_window window) {
+	return window.flags & TWM_WINDOW_BORDERLESS;
+}
+
+void twm_window_fullscreen(twm_window window, bool enable) {
+    if (enable && (window.flags & TWM_WINDOW_FULLSCREEN)) return;
+    
+    @autoreleasepool{
+        NSScreen* screen = window.screen ?: [NSScreen mainScreen];
+        
+        if (enable) {
+            twm_window_borderless(window, enable);
+            
+            window.flags |= TWM_WINDOW_FULLSCREEN;
+            
+            window.original_frame = [window frame];
+            window.original_level = window.level;
+            
+            [window setLevel:NSMainMenuWindowLevel + 1];
+            [window setFrame:screen.frame display:YES];
+        }
+        else {
+            window.flags &= ~TWM_WINDOW_FULLSCREEN;
+            
+            [window setLevel:window.original_level];
+            [window setFrame:window.original_frame display:YES];
+
+            twm_window_borderless(window, enable);
+        }
+    }
+}
+
+bool twm_window_is_fullscreen(twm_window window) {
+	return window.flags & TWM_WINDOW_FULLSCREEN;
+}
+
+void twm_set_window_ptr(twm_window window, void * ptr) {
+	window.ptr = ptr;
+}
+
+void * twm_get_window_ptr(twm_window window) {
+	return window.ptr;
+}
+
+void twm_set_window_property(twm_window window, const char * name, int size, const void* value) {
+	void* data = objc_getAssociatedObject(window, name);
+	if (!data) {
+		data = malloc(size);
+	}
+
+	memcpy(data, value, size);
+
+	objc_setAssociatedObject(window, name, data, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+}
+
+bool twm_get_window_property(twm_window window, const char * name, int size, void* value) {
+	void* data = objc_getAssociatedObject(window, name);
+	if (!data) return 0;
+
+	memcpy(value, data, size);
+
+	return 1;
+}
+
+void twm_free_window_property(twm_window window, const char* name) {
+	void* data = objc_getAssociatedObject(window, name);
+	if (!data) return;
+
+	free(data);
+
+	objc_setAssociatedObject(window, name, nil, OBJC_ASSOCIATION_ASSIGN);
+}
+
+void twm_destroy_window(twm_window window) {
+	[window close];
+}
+
+void twm_show_cursor(bool flag) {
+	if (flag) {
+		[NSCursor unhide];
+	}
+	else {
+		[NSCursor hide];
+	}
+    
+    _twm_data.cursor_visible = flag;
+}
+
+bool twm_cursor_is_visible() {
+	return _twm_data.cursor_visible;
+}
+
+void twm_rawmouse_master_only(bool enable) {
+	_twm_data.mouse.raw.master_only = enable;
+}
+
+void twm_cursor_position(int* x, int* y) {
+	CGEventRef ourEvent = CGEventCreate(NULL);
+	CGPoint p = CGEventGetLocation(ourEvent);
+	CFRelease(ourEvent);
+
+	*x = (int)p.x;
+	*y = (int)p.y;
+}
+
+void twm_move_cursor(int x, int y) {
+	CGWarpMouseCursorPosition(CGPointMake(x, y));
+}
+
+void twm_clip_cursor(twm_window window) {
+    _twm_data.clip_window = window;
+    
+    CGAssociateMouseAndMouseCursorPosition(false);
+
+	CGEventRef event = CGEventCreate(NULL);
+	CGPoint cursorLocation = CGEventGetLocation(event);
+	CFRelease(event);
+	
+	_twm_data.clip_x = cursorLocation.x;
+	_twm_data.clip_y = cursorLocation.y;
+
+	NSWindowStyleMask style = [_twm_data.clip_window styleMask];
+
+	style &= ~NSWindowStyleMaskResizable;
+
+	[_twm_data.clip_window setStyleMask:style];
+}
+
+void twm_unclip_cursor() {
+	if (!_twm_data.clip_window) return;
+
+	CGAssociateMouseAndMouseCursorPosition(true);
+
+	NSWindowStyleMask style = [_twm_data.clip_window styleMask];
+
+	style |= NSWindowStyleMaskResizable;
+
+	[_twm_data.clip_window setStyleMask:style];
+
+	_twm_data.clip_window = NULL;
+}
+
+static inline twm_keymod twm_get_keymods()
+{
+    NSEventModifierFlags flags = [NSEvent modifierFlags];
+    twm_keymod mods = TWM_KEYMOD_NONE;
+
+    if (flags & NSEventModifierFlagShift)
+    {
+        mods |= TWM_KEYMOD_SHIFT;
+        // Cocoa doesn't distinguish left/right Shift, so assume both
+        mods |= TWM_KEYMOD_LSHIFT | TWM_KEYMOD_RSHIFT;
+    }
+    if (flags & NSEventModifierFlagControl)
+    {
+        mods |= TWM_KEYMOD_CTRL;
+        mods |= TWM_KEYMOD_LCTRL | TWM_KEYMOD_RCTRL; // no distinction in Cocoa
+    }
+    if (flags & NSEventModifierFlagOption)
+    {
+        mods |= TWM_KEYMOD_ALT;
+        mods |= TWM_KEYMOD_LALT | TWM_KEYMOD_RALT;
+    }
+    if (flags & NSEventModifierFlagCommand)
+    {
+        mods |= TWM_KEYMOD_LWIN | TWM_KEYMOD_RWIN;
+    }
+    if (flags & NSEventModifierFlagCapsLock)
+    {
+        mods |= TWM_KEYMOD_CAPSLOCK;
+    }
+
+    // Cocoa doesn't provide direct access to NumLock, ScrollLock, Menu key
+    // You can implement detection via IOHID APIs if necessary, but it's non-trivial
+
+    return mods;
+}
+
+static inline int _twm_translate_event(NSDate * untilDate, twm_event * evt, twm_window window) {
+	@autoreleasepool{
+		NSEvent * event;
+		while ((event = [_twm_data.app nextEventMatchingMask : NSEventMaskAny untilDate : untilDate inMode : NSDefaultRunLoopMode dequeue : YES])) {
+			twm_window window = (twm_window)event.window;
+
+			_twm_stamp_event(evt, (unsigned long)(event.timestamp * 1000.0));
+
+			switch (event.type) {
+				case NSEventTypeLeftMouseDown: {
 					if (![event.window isZoomed]) {
 						NSPoint mousePos = [event locationInWindow];
 						window.resizeEdge = detect_resize_edge(mousePos, event.window.frame);
@@ -4789,6 +7792,8 @@ static inline int _twm_translate_event(NSDate * untilDate, twm_event * evt, twm_
 					evt->rawmouse.window = window;
                     _twm_data.mouse.dx = evt->rawmouse.dx = (int)event.deltaX;
 					_twm_data.mouse.dy = evt->rawmouse.dy = (int)event.deltaY;
+					_twm_data.mouse.fdx = evt->rawmouse.fdx = event.deltaX;
+					_twm_data.mouse.fdy = evt->rawmouse.fdy = event.deltaY;
 					
 					if (_twm_data.clip_window)
 					{
@@ -4820,6 +7825,8 @@ static inline int _twm_translate_event(NSDate * untilDate, twm_event * evt, twm_
 
                         _twm_data.mouse.x = (int)mouseInContent.x;
                         _twm_data.mouse.y = (int)([[window contentView] frame].size.height - mouseInContent.y);
+                        _twm_data.mouse.fx = mouseInContent.x;
+                        _twm_data.mouse.fy = [[window contentView] frame].size.height - mouseInContent.y;
 		
 						NSEvent* newEvent = [NSEvent otherEventWithType : NSEventTypeApplicationDefined
 															location : mouseInContent
@@ -4869,340 +7876,1197 @@ static inline int _twm_translate_event(NSDate * untilDate, twm_event * evt, twm_
 						case TWM_KEY_RSUPER: if (!(prev_modifiers & NSEventModifierFlagCommand) && (event.modifierFlags & NSEventModifierFlagCommand)) evt->type = TWM_EVENT_KEY_DOWN; break;
 						default: break;
 					}
-		
-					return 1;
-				}
-		
-				case NSEventTypeKeyDown: {
-					static UInt32 deadKeyState = 0;
-					NSString* s = translate_input_for_keydown(event, &deadKeyState);
-		
-					unichar ch = [s characterAtIndex : 0];
-		
-					if ([[[NSCharacterSet controlCharacterSet]invertedSet] characterIsMember:ch] ) {
-						const char* utf8 = s.UTF8String;
-		
-						int len = 1;
-						unsigned char b = utf8[0];
-						if ((b & 0xE0) == 0xC0) len = 2;
-						else if ((b & 0xF0) == 0xE0) len = 3;
-						else if ((b & 0xF8) == 0xF0) len = 4;
-		
-						int data;
-						strncpy((char*)&data, (const char*)s.UTF8String, 4);
-		
-						NSEvent* newEvent = [NSEvent otherEventWithType : NSEventTypeApplicationDefined
-															location : event.locationInWindow
-													   modifierFlags : event.modifierFlags
-														   timestamp : event.timestamp
-														windowNumber : event.windowNumber
-															 context : nil
-															 subtype : TWM_EVENT_KEY_CHAR
-															   data1 : (int)len
-															   data2 : data];
-		
-						[_twm_data.app postEvent : newEvent atStart : YES] ;
+		
+					return 1;
+				}
+		
+				case NSEventTypeKeyDown: {
+					static UInt32 deadKeyState = 0;
+					NSString* s = translate_input_for_keydown(event, &deadKeyState);
+		
+					unichar ch = [s characterAtIndex : 0];
+		
+					if ([[[NSCharacterSet controlCharacterSet]invertedSet] characterIsMember:ch] ) {
+						const char* utf8 = s.UTF8String;
+		
+						int len = 1;
+						unsigned char b = utf8[0];
+						if ((b & 0xE0) == 0xC0) len = 2;
+						else if ((b & 0xF0) == 0xE0) len = 3;
+						else if ((b & 0xF8) == 0xF0) len = 4;
+		
+						int data;
+						strncpy((char*)&data, (const char*)s.UTF8String, 4);
+		
+						NSEvent* newEvent = [NSEvent otherEventWithType : NSEventTypeApplicationDefined
+															location : event.locationInWindow
+													   modifierFlags : event.modifierFlags
+														   timestamp : event.timestamp
+														windowNumber : event.windowNumber
+															 context : nil
+															 subtype : TWM_EVENT_KEY_CHAR
+															   data1 : (int)len
+															   data2 : data];
+		
+						[_twm_data.app postEvent : newEvent atStart : YES] ;
+					}
+		
+					if ([event isARepeat]) return 0;
+		
+					evt->type = TWM_EVENT_KEY_DOWN;
+					evt->keyboard.window = window;
+					evt->keyboard.key = event.keyCode;
+                    _twm_data.keyboard.modifiers = evt->keyboard.modifiers = twm_get_keymods();
+                    _twm_data.keyboard.keys[evt->keyboard.key] = true;
+		
+					return 1;
+				}
+		
+				case NSEventTypeKeyUp: {
+					evt->type = TWM_EVENT_KEY_UP;
+					evt->keyboard.window = window;
+					evt->keyboard.key = event.keyCode;
+                    _twm_data.keyboard.modifiers = evt->keyboard.modifiers = twm_get_keymods();
+                    _twm_data.keyboard.keys[evt->keyboard.key] = false;
+		
+					return 1;
+				}
+		
+				case NSEventTypeApplicationDefined: {
+					if (event.subtype == TWM_EVENT_USER) {
+						if (_twm_pop_event(evt)) return 1;
+
+						continue;
+					}
+
+					evt->type = (twm_event_type)event.subtype;
+		
+					switch (evt->type) {
+						case TWM_EVENT_WINDOW_CLOSE: {
+							evt->window.window = window;
+							break;
+						}
+		
+						case TWM_EVENT_WINDOW_SIZE: {
+							evt->window.window = window;
+							evt->window.width = (int)event.data1;
+							evt->window.height = (int)event.data2;
+		
+							break;
+						}
+		
+						case TWM_EVENT_WINDOW_MOVE: {
+							evt->window.window = window;
+							evt->window.x = (int)event.data1;
+							evt->window.y = (int)event.data2;
+		
+							break;
+						}
+		
+						case TWM_EVENT_MOUSE_MOVE: {
+							evt->mouse.window = window;
+							evt->mouse.x = (int)event.data1;
+							evt->mouse.y = (int)event.data2;
+							evt->mouse.fx = evt->mouse.x;
+							evt->mouse.fy = evt->mouse.y;
+		
+							break;
+						}
+		
+						case TWM_EVENT_KEY_CHAR: {
+							unsigned int codepoint = (unsigned int)event.data1;
+		
+							int data2 = (int)event.data2;
+							strncpy(evt->keyboard.chr, (const char*)&data2, (int)event.data1);
+		
+							evt->keyboard.window = window;
+							evt->keyboard.chr[(int)event.data1] = '\0';
+							evt->keyboard.modifiers = twm_get_keymods();
+		
+							break;
+						}
+		
+						default:
+							break;
+					}
+		
+					return 1;
+				}
+		
+				default:
+					break;
+			}
+		
+			[NSApp sendEvent : event];
+		}
+	}
+	
+	return 0;
+}
+
+static void _twm_platform_wait_event(twm_event* evt) {
+	if (_twm_pop_event(evt)) return;
+
+	_twm_translate_event([NSDate distantFuture], evt, nil);
+}
+
+static int _twm_platform_wait_event_timeout(twm_event* evt, double seconds) {
+	if (_twm_pop_event(evt)) return 1;
+
+	return _twm_translate_event(seconds < 0.0 ? [NSDate distantFuture] : [NSDate dateWithTimeIntervalSinceNow : seconds], evt, nil);
+}
+
+int twm_connection_fd() {
+	return -1;
+}
+
+bool twm_watch_fd(int fd) {
+	return false;
+}
+
+void twm_unwatch_fd(int fd) {
+}
+
+static int _twm_platform_peek_event(twm_event* evt) {
+	if (_twm_pop_event(evt)) return 1;
+
+	return _twm_translate_event(nil, evt, nil);
+}
+
+bool twm_post_event(const twm_event* evt) {
+	if (!_twm_post_push(evt)) return false;
+
+	// postEvent is safe to call from secondary threads and wakes nextEventMatchingMask
+	NSEvent* wakeEvent = [NSEvent otherEventWithType : NSEventTypeApplicationDefined
+		location : NSMakePoint(0, 0)
+		modifierFlags : 0
+		timestamp : 0
+		windowNumber : 0
+		context : nil
+		subtype : TWM_EVENT_USER
+		data1 : 0
+		data2 : 0];
+	[NSApp postEvent : wakeEvent atStart : NO];
+
+	return true;
+}
+
+static int _twm_platform_peek_events(twm_event* events, int max) {
+	int count = 0;
+	while (count < max && _twm_platform_peek_event(&events[count])) count++;
+
+	return count;
+}
+
+NSString* translate_input_for_keydown(NSEvent* event, UInt32* deadKeyState) {
+	const size_t unicodeStringLength = 4;
+	UniChar unicodeString[unicodeStringLength] = { 0, };
+	UniCharCount reallength = 0;
+	NSString* nsstring = nil;
+
+	TISInputSourceRef inputSource = TISCopyCurrentKeyboardInputSource();
+	if (inputSource) {
+		CFDataRef layoutData = (CFDataRef)TISGetInputSourceProperty(inputSource, kTISPropertyUnicodeKeyLayoutData);
+		const UCKeyboardLayout* keyboardLayout = (const UCKeyboardLayout*)CFDataGetBytePtr(layoutData);
+
+		CGEventFlags flags = (CGEventFlags)[event modifierFlags];
+		UInt32 keymodifiers = (flags >> 16) & 0xFF;
+
+		UCKeyTranslate(keyboardLayout,
+			[event keyCode], kUCKeyActionDown, keymodifiers,
+			LMGetKbdType(), 0,
+			deadKeyState,
+			unicodeStringLength, &reallength, unicodeString);
+		CFRelease(inputSource);
+	}
+
+	if (reallength > 0) {
+		nsstring = [NSString stringWithCharacters : unicodeString length : reallength];
+	}
+
+	return nsstring;
+}
+
+ResizeEdge detect_resize_edge(NSPoint mousePos, NSRect frame) {
+	BOOL left = mousePos.x < RESIZE_BORDER;
+	BOOL right = mousePos.x > (frame.size.width - RESIZE_BORDER);
+	BOOL bottom = mousePos.y < RESIZE_BORDER;
+	BOOL top = mousePos.y > (frame.size.height - RESIZE_BORDER);
+
+	if (left && bottom)  return ResizeBottomLeft;
+	if (left && top)     return ResizeTopLeft;
+	if (right && bottom) return ResizeBottomRight;
+	if (right && top)    return ResizeTopRight;
+	if (left)   return ResizeLeft;
+	if (right)  return ResizeRight;
+	if (top)    return ResizeTop;
+	if (bottom) return ResizeBottom;
+	return ResizeNone;
+}
+
+bool is_mouse_in_client_area(NSEvent* event) {
+	NSView* contentView = [event.window contentView];
+	NSPoint localPoint = [contentView convertPoint : [event locationInWindow] fromView : nil];
+	NSRect bounds = [contentView bounds];
+	return NSPointInRect(localPoint, bounds);
+}
+
+// Software presentation is not implemented on Cocoa yet
+twm_framebuffer twm_create_framebuffer(twm_window window) {
+	return NULL;
+}
+
+void twm_destroy_framebuffer(twm_framebuffer framebuffer) {
+}
+
+unsigned int* twm_framebuffer_pixels(twm_framebuffer framebuffer, int* width, int* height, int* stride) {
+	return NULL;
+}
+
+void twm_present_framebuffer(twm_framebuffer framebuffer) {
+}
+
+bool twm_window_present_feedback(twm_window window, bool enable) {
+	return false;
+}
+
+#ifdef TWM_GL
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wdeprecated-declarations"
+
+void twm_gl_set_pixel_attribs(int pixel_attribs[]) {
+	int doubleBufferEnabled = 0;
+
+	int i = 0;
+	while (pixel_attribs[i] != 0) {
+		switch (pixel_attribs[i]) {
+		case TWM_GL_DOUBLE_BUFFER:
+			pixel_attribs[15] = NSOpenGLPFADoubleBuffer;
+			doubleBufferEnabled = 1;
+			break;
+
+		case TWM_GL_COLOR_BITS:
+			_twm_data.pixel_attribs[4] = pixel_attribs[++i];
+			break;
+
+		case TWM_GL_ALPHA_BITS:
+			_twm_data.pixel_attribs[6] = pixel_attribs[++i];
+			break;
+
+		case TWM_GL_DEPTH_BITS:
+			_twm_data.pixel_attribs[8] = pixel_attribs[++i];
+			break;
+
+		case TWM_GL_STENCIL_BITS:
+			_twm_data.pixel_attribs[10] = pixel_attribs[++i];
+			break;
+
+		case TWM_GL_SAMPLE_BUFFERS:
+			_twm_data.pixel_attribs[12] = pixel_attribs[++i];
+			break;
+
+		case TWM_GL_SAMPLES:
+			_twm_data.pixel_attribs[14] = pixel_attribs[++i];
+			break;
+		}
+		i++;
+	}
+
+	if (!doubleBufferEnabled) {
+		pixel_attribs[15] = 0;
+	}
+}
+
+twm_gl_context twm_gl_create_context(twm_window window, int* attribs) {
+	return twm_gl_create_shared_context(window, attribs, nil);
+}
+
+// A context without a view renders into FBOs only, which is all a worker thread needs
+twm_gl_context twm_gl_create_offscreen_context(int* attribs, twm_gl_context share) {
+	return twm_gl_create_shared_context(nil, attribs, share);
+}
+
+twm_gl_context twm_gl_create_shared_context(twm_window window, int* attribs, twm_gl_context share) {
+	@autoreleasepool{
+		NSOpenGLPixelFormatAttribute context_attribs[TWM_GL_PIXEL_ATTRIBS_SIZE];
+
+		memcpy(context_attribs, _twm_data.pixel_attribs, sizeof(_twm_data.pixel_attribs));
+
+		int i = 0;
+		while (attribs && attribs[i] != 0) {
+			switch (attribs[i]) {
+				case TWM_GL_CONTEXT_MAJOR_VERSION:
+					if (attribs[++i] < 3) {
+						context_attribs[2] = NSOpenGLProfileVersionLegacy;
+					}
+					else if (attribs[++i] < 4) {
+						context_attribs[2] = NSOpenGLProfileVersion3_2Core;
 					}
-		
-					if ([event isARepeat]) return 0;
-		
-					evt->type = TWM_EVENT_KEY_DOWN;
-					evt->keyboard.window = window;
-					evt->keyboard.key = event.keyCode;
-                    _twm_data.keyboard.modifiers = evt->keyboard.modifiers = twm_get_keymods();
-                    _twm_data.keyboard.keys[evt->keyboard.key] = true;
-		
-					return 1;
-				}
-		
-				case NSEventTypeKeyUp: {
-					evt->type = TWM_EVENT_KEY_UP;
-					evt->keyboard.window = window;
-					evt->keyboard.key = event.keyCode;
-                    _twm_data.keyboard.modifiers = evt->keyboard.modifiers = twm_get_keymods();
-                    _twm_data.keyboard.keys[evt->keyboard.key] = false;
-		
-					return 1;
-				}
-		
-				case NSEventTypeApplicationDefined: {
-					evt->type = (twm_event_type)event.subtype;
-		
-					switch (evt->type) {
-						case TWM_EVENT_WINDOW_CLOSE: {
-							evt->window.window = window;
-							break;
-						}
-		
-						case TWM_EVENT_WINDOW_SIZE: {
-							evt->window.window = window;
-							evt->window.width = (int)event.data1;
-							evt->window.height = (int)event.data2;
-		
-							break;
-						}
-		
-						case TWM_EVENT_WINDOW_MOVE: {
-							evt->window.window = window;
-							evt->window.x = (int)event.data1;
-							evt->window.y = (int)event.data2;
-		
-							break;
-						}
-		
-						case TWM_EVENT_MOUSE_MOVE: {
-							evt->mouse.window = window;
-							evt->mouse.x = (int)event.data1;
-							evt->mouse.y = (int)event.data2;
-		
-							break;
-						}
-		
-						case TWM_EVENT_KEY_CHAR: {
-							unsigned int codepoint = (unsigned int)event.data1;
-		
-							int data2 = (int)event.data2;
-							strncpy(evt->keyboard.chr, (const char*)&data2, (int)event.data1);
-		
-							evt->keyboard.window = window;
-							evt->keyboard.chr[(int)event.data1] = '\0';
-							evt->keyboard.modifiers = twm_get_keymods();
-		
-							break;
-						}
-		
-						default:
-							break;
+					else {
+						context_attribs[2] = NSOpenGLProfileVersion4_1Core;
 					}
-		
-					return 1;
-				}
-		
-				default:
-					break;
+				break;
+			}
+			i++;
+		}
+
+		NSOpenGLPixelFormat* pf = [[NSOpenGLPixelFormat alloc]initWithAttributes:context_attribs];
+		twm_gl_context glContext = [[NSOpenGLContext alloc]initWithFormat:pf shareContext : share];
+		if (window) [glContext setView : [window contentView] ] ;
+        twm_gl_set_swap_interval(glContext, 0);
+
+		return glContext;
+	}
+}
+
+void twm_gl_delete_context(twm_gl_context context) {
+	[context release];
+}
+
+void twm_gl_make_current(twm_gl_context context) {
+	if (context != NULL) {
+		[context makeCurrentContext];
+		[context update]; 
+	}
+	else {
+		[NSOpenGLContext clearCurrentContext];
+	}
+}
+
+void twm_gl_swap_buffers(twm_gl_context context) {
+    long long start = _twm_stats_begin();
+
+    [context flushBuffer] ;
+
+    if (_twm_data.swap_interval > 0) {
+        static double last_time = 0.0f;
+        
+        twm_fps_limit(_twm_data.refresh_rate / _twm_data.swap_interval, last_time);
+        
+        last_time = twm_time();
+    }
+
+    _twm_stats_end_swap(start);
+}
+
+// No adaptive vsync on NSOpenGL, negative intervals fall back to regular vsync
+void twm_gl_set_swap_interval(twm_gl_context context, int interval) {
+    if (interval < 0) interval = -interval;
+
+    _twm_data.swap_interval = interval;
+    
+    [context setValues:&interval forParameter:NSOpenGLCPSwapInterval];
+}
+
+int twm_gl_get_swap_interval(twm_gl_context context) {
+	int current;
+	[context getValues : &current forParameter : NSOpenGLCPSwapInterval] ;
+	return current;
+}
+
+bool twm_gl_adaptive_vsync_supported() {
+	return false;
+}
+
+bool twm_gl_sync_control_supported() {
+	return false;
+}
+
+bool twm_gl_get_sync_values(twm_gl_context context, twm_gl_sync_values* values) {
+	return false;
+}
+
+long long twm_gl_swap_buffers_msc(twm_gl_context context, long long target_msc, long long divisor, long long remainder) {
+	return -1;
+}
+
+bool twm_gl_wait_for_sbc(twm_gl_context context, long long target_sbc, twm_gl_sync_values* values) {
+	return false;
+}
+
+#pragma clang diagnostic pop
+#endif
+
+#ifdef TWM_VULKAN
+#import <QuartzCore/CAMetalLayer.h>
+
+const char** twm_vk_get_instance_extensions(int* extension_count) {
+	static const char* extensions[] = {
+		VK_KHR_SURFACE_EXTENSION_NAME,
+		VK_MVK_MACOS_SURFACE_EXTENSION_NAME
+	};
+
+	*extension_count = sizeof(extensions) / sizeof(extensions[0]);
+
+	return extensions;
+}
+
+VkResult twm_vk_create_surface(twm_window window, VkInstance instance, const
+                                      VkAllocationCallbacks* pAllocator, VkSurfaceKHR* pSurface) {
+
+    [window.contentView setWantsLayer:YES];
+
+    CAMetalLayer* metalLayer = [CAMetalLayer layer];
+    [window.contentView setLayer:metalLayer];
+    
+    VkMacOSSurfaceCreateInfoMVK surface_info = { 0 };
+	surface_info.sType = VK_STRUCTURE_TYPE_MACOS_SURFACE_CREATE_INFO_MVK;
+	surface_info.pNext = NULL;
+	surface_info.flags = 0;
+    surface_info.pView = [window contentView];
+
+	return vkCreateMacOSSurfaceMVK(instance, &surface_info, pAllocator, pSurface);
+}
+#endif
+#endif
+
+#elif defined(TWM_HEADLESS)
+
+twm_data _twm_data = { 0 };
+
+#ifndef TWM_HEADLESS_SCREEN_WIDTH
+	#define TWM_HEADLESS_SCREEN_WIDTH 1920
+#endif
+
+#ifndef TWM_HEADLESS_SCREEN_HEIGHT
+	#define TWM_HEADLESS_SCREEN_HEIGHT 1080
+#endif
+
+#ifndef TWM_HEADLESS_SCREEN_HZ
+	#define TWM_HEADLESS_SCREEN_HZ 60
+#endif
+
+typedef struct _twm_headless_property {
+	char name[64];
+	int size;
+	struct _twm_headless_property* next;
+	unsigned char value[];
+} _twm_headless_property;
+
+struct _twm_window {
+	int x, y;
+	int width, height;
+	bool visible;
+	bool was_closed;
+	bool was_resized;
+	twm_window_flags flags;
+	char title[128];
+	void* ptr;
+	_twm_headless_property* properties;
+	struct _twm_window* next;
+};
+
+typedef struct _twm_window twm_window_data;
+
+struct _twm_framebuffer {
+	twm_window window;
+	unsigned int* pixels;
+	int width, height;
+};
+
+static inline twm_window_data* twm_get_window_data(twm_window window) {
+	return window;
+}
+
+// Injected events can name any handle, including windows that were already destroyed
+static inline twm_window_data* _twm_headless_find_window(twm_window window) {
+	for (twm_window_data* data = _twm_data.windows; data; data = data->next) {
+		if (data == window) return data;
+	}
+
+	return NULL;
+}
+
+int twm_init() {
+	_twm_init_post_queue();
+
+	#ifdef __linux__
+		_twm_data.wakeup[0] = _twm_data.wakeup[1] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	#else
+		if (pipe(_twm_data.wakeup) == 0) {
+			for (int i = 0; i < 2; i++) {
+				fcntl(_twm_data.wakeup[i], F_SETFL, fcntl(_twm_data.wakeup[i], F_GETFL) | O_NONBLOCK);
+				fcntl(_twm_data.wakeup[i], F_SETFD, FD_CLOEXEC);
 			}
-		
-			[NSApp sendEvent : event];
 		}
+		else {
+			_twm_data.wakeup[0] = _twm_data.wakeup[1] = -1;
+		}
+	#endif
+
+	_twm_data.cursor_visible = true;
+
+	static const int sizes[][2] = {
+		{ TWM_HEADLESS_SCREEN_WIDTH, TWM_HEADLESS_SCREEN_HEIGHT },
+		{ 1280, 720 },
+		{ 800, 600 },
+	};
+
+	_twm_data.screen.count = 1;
+	_twm_data.screen.screen = (twm_screen*)calloc(1, sizeof(twm_screen));
+
+	twm_screen* screen = &_twm_data.screen.screen[0];
+
+	strcpy(screen->name, "headless");
+	screen->width = TWM_HEADLESS_SCREEN_WIDTH;
+	screen->height = TWM_HEADLESS_SCREEN_HEIGHT;
+
+	screen->modes.count = sizeof(sizes) / sizeof(sizes[0]);
+	screen->modes.current = 0;
+	screen->modes.mode = (twm_screen_mode*)calloc(screen->modes.count, sizeof(twm_screen_mode));
+
+	for (int i = 0; i < screen->modes.count; i++) {
+		screen->modes.mode[i].width = sizes[i][0];
+		screen->modes.mode[i].height = sizes[i][1];
+		screen->modes.mode[i].bpp = 32;
+		screen->modes.mode[i].hz = TWM_HEADLESS_SCREEN_HZ;
+		screen->modes.mode[i].refresh_rate = TWM_HEADLESS_SCREEN_HZ;
 	}
-	
-	return 0;
+
+	screen->modes.mode[0].flags = TWM_SCREEN_MODE_PREFERRED;
+
+	return 1;
 }
 
-void twm_wait_event(twm_event* evt) {
-	_twm_translate_event([NSDate distantFuture], evt, nil);
+void twm_finalize() {
+	twm_record_end();
+	twm_replay_end();
+
+	while (_twm_data.windows) twm_destroy_window(_twm_data.windows);
+
+	for (int i = 0; i < _twm_data.screen.count; i++) {
+		free(_twm_data.screen.screen[i].modes.mode);
+	}
+	free(_twm_data.screen.screen);
+
+	_twm_data.screen.screen = NULL;
+	_twm_data.screen.count = 0;
+
+	if (_twm_data.wakeup[0] >= 0) close(_twm_data.wakeup[0]);
+	if (_twm_data.wakeup[1] != _twm_data.wakeup[0] && _twm_data.wakeup[1] >= 0) close(_twm_data.wakeup[1]);
 }
 
-int twm_peek_event(twm_event* evt) {
-	return _twm_translate_event(nil, evt, nil);
+bool twm_change_screen_mode(int screen_index, int mode_index) {
+	if (screen_index < 0 || screen_index >= _twm_data.screen.count || mode_index < 0) return false;
+
+	twm_screen* screen = &_twm_data.screen.screen[screen_index];
+
+	if (mode_index >= screen->modes.count) return false;
+
+	if (mode_index == screen->modes.current) return true;
+
+	// Same notification X11 gets from RandR once the new mode is set
+	twm_event evt = { 0 };
+	evt.type = TWM_EVENT_SCREEN_CHANGED;
+	evt.screen.screen = screen_index;
+	evt.screen.change = TWM_SCREEN_MODE;
+
+	if (screen->width != screen->modes.mode[mode_index].width || screen->height != screen->modes.mode[mode_index].height) {
+		evt.screen.change |= TWM_SCREEN_GEOMETRY;
+	}
+
+	screen->modes.current = mode_index;
+	screen->width = screen->modes.mode[mode_index].width;
+	screen->height = screen->modes.mode[mode_index].height;
+
+	twm_screen_rect(screen_index, &evt.screen.rect);
+
+	_twm_push_event(&evt);
+
+	return true;
 }
 
-NSString* translate_input_for_keydown(NSEvent* event, UInt32* deadKeyState) {
-	const size_t unicodeStringLength = 4;
-	UniChar unicodeString[unicodeStringLength] = { 0, };
-	UniCharCount reallength = 0;
-	NSString* nsstring = nil;
+twm_window twm_create_window(const char* title, int x, int y, int width, int height, twm_window_flags flags) {
+	twm_window_data* data = (twm_window_data*)calloc(1, sizeof(twm_window_data));
 
-	TISInputSourceRef inputSource = TISCopyCurrentKeyboardInputSource();
-	if (inputSource) {
-		CFDataRef layoutData = (CFDataRef)TISGetInputSourceProperty(inputSource, kTISPropertyUnicodeKeyLayoutData);
-		const UCKeyboardLayout* keyboardLayout = (const UCKeyboardLayout*)CFDataGetBytePtr(layoutData);
+	if (!data) return NULL;
+
+	twm_rect screen_rect;
+	twm_screen_rect(twm_screen_from_cursor(), &screen_rect);
+
+	data->width = width;
+	data->height = height;
+	data->x = x == TWM_CENTER ? screen_rect.x + ((screen_rect.width - width) >> 1) : x;
+	data->y = y == TWM_CENTER ? screen_rect.y + ((screen_rect.height - height) >> 1) : y;
+	data->flags = flags;
+
+	twm_title_window(data, title);
+
+	data->next = _twm_data.windows;
+	_twm_data.windows = data;
+
+	return data;
+}
+
+void twm_destroy_window(twm_window window) {
+	for (twm_window* link = &_twm_data.windows; *link; link = &(*link)->next) {
+		if (*link == window) {
+			*link = window->next;
+			break;
+		}
+	}
+
+	while (window->properties) {
+		_twm_headless_property* property = window->properties;
+		window->properties = property->next;
+
+		free(property);
+	}
+
+	if (_twm_data.clip == window) _twm_data.clip = NULL;
+
+	free(window);
+}
+
+bool twm_window_was_closed(twm_window window) {
+	twm_window_data* data = twm_get_window_data(window);
+
+	if (!data->was_closed) return false;
+
+	data->was_closed = false;
+
+	return true;
+}
+
+bool twm_window_was_resized(twm_window window, int* width, int* height) {
+	twm_window_data* data = twm_get_window_data(window);
+
+	if (!data->was_resized) return false;
+
+	data->was_resized = false;
+
+	*width = data->width;
+	*height = data->height;
+
+	return true;
+}
+
+void twm_show_window(twm_window window, bool visible) {
+	twm_get_window_data(window)->visible = visible;
+}
+
+bool twm_window_is_visible(twm_window window) {
+	return twm_get_window_data(window)->visible;
+}
+
+// Behaves like a window manager that grants every request, the changes come back as events
+void twm_move_window(twm_window window, int x, int y, int width, int height) {
+	twm_window_data* data = twm_get_window_data(window);
+
+	int new_x = x, new_y = y;
+	int new_width = width, new_height = height;
+
+	if (x == TWM_CURRENT || x == TWM_CENTER) new_x = data->x;
+	if (y == TWM_CURRENT || y == TWM_CENTER) new_y = data->y;
+
+	twm_rect screen_rect;
+	twm_screen_rect(twm_screen_from_position(new_x, new_y), &screen_rect);
+
+	if (width == TWM_CURRENT || width == TWM_STRETCH) new_width = data->width;
+	if (height == TWM_CURRENT || height == TWM_STRETCH) new_height = data->height;
+
+	if (width == TWM_STRETCH) new_width = screen_rect.width - new_x;
+	if (height == TWM_STRETCH) new_height = screen_rect.height - new_y;
+
+	if (x == TWM_CENTER) new_x = screen_rect.x + ((screen_rect.width - new_width) >> 1);
+	if (y == TWM_CENTER) new_y = screen_rect.y + ((screen_rect.height - new_height) >> 1);
+
+	twm_event evt = { 0 };
+	evt.window.window = window;
+	evt.window.x = new_x;
+	evt.window.y = new_y;
+	evt.window.width = new_width;
+	evt.window.height = new_height;
+
+	if (new_width != data->width || new_height != data->height) {
+		evt.type = TWM_EVENT_WINDOW_SIZE;
+		_twm_push_event(&evt);
+	}
+
+	if (new_x != data->x || new_y != data->y) {
+		evt.type = TWM_EVENT_WINDOW_MOVE;
+		_twm_push_event(&evt);
+	}
+}
+
+int twm_window_width(twm_window window) {
+	return twm_get_window_data(window)->width;
+}
+
+int twm_window_height(twm_window window) {
+	return twm_get_window_data(window)->height;
+}
+
+void twm_window_size(twm_window window, int* width, int* height) {
+	twm_window_data* data = twm_get_window_data(window);
+	*width = data->width;
+	*height = data->height;
+}
+
+int twm_window_x(twm_window window) {
+	return twm_get_window_data(window)->x;
+}
+
+int twm_window_y(twm_window window) {
+	return twm_get_window_data(window)->y;
+}
+
+void twm_window_position(twm_window window, int* x, int* y) {
+	twm_window_data* data = twm_get_window_data(window);
+	*x = data->x;
+	*y = data->y;
+}
+
+void twm_window_rect(twm_window window, twm_rect* rect) {
+	twm_window_data* data = twm_get_window_data(window);
+	rect->x = data->x;
+	rect->y = data->y;
+	rect->width = data->width;
+	rect->height = data->height;
+}
+
+void twm_title_window(twm_window window, const char* title) {
+	twm_window_data* data = twm_get_window_data(window);
+
+	snprintf(data->title, sizeof(data->title), "%s", title ? title : "");
+}
+
+void twm_window_borderless(twm_window window, bool enable) {
+	twm_window_data* data = twm_get_window_data(window);
+
+	if (enable) {
+		data->flags |= TWM_WINDOW_BORDERLESS;
+	}
+	else {
+		data->flags &= ~TWM_WINDOW_BORDERLESS;
+	}
+}
+
+bool twm_window_is_borderless(twm_window window) {
+	return twm_get_window_data(window)->flags & TWM_WINDOW_BORDERLESS;
+}
+
+void twm_window_fullscreen(twm_window window, bool enable) {
+	twm_window_data* data = twm_get_window_data(window);
+
+	if (enable) {
+		data->flags |= TWM_WINDOW_BORDERLESS | TWM_WINDOW_FULLSCREEN;
+	}
+	else {
+		data->flags &= ~(TWM_WINDOW_BORDERLESS | TWM_WINDOW_FULLSCREEN);
+	}
+}
+
+bool twm_window_is_fullscreen(twm_window window) {
+	return twm_get_window_data(window)->flags & TWM_WINDOW_FULLSCREEN;
+}
+
+void twm_set_window_ptr(twm_window window, void* ptr) {
+	twm_get_window_data(window)->ptr = ptr;
+}
+
+void* twm_get_window_ptr(twm_window window) {
+	return twm_get_window_data(window)->ptr;
+}
+
+static _twm_headless_property** _twm_headless_find_property(twm_window window, const char* name) {
+	_twm_headless_property** link = &twm_get_window_data(window)->properties;
+
+	while (*link && strcmp((*link)->name, name) != 0) link = &(*link)->next;
+
+	return link;
+}
+
+void twm_set_window_property(twm_window window, const char* name, int size, const void* value) {
+	twm_free_window_property(window, name);
+
+	_twm_headless_property* property = (_twm_headless_property*)malloc(sizeof(_twm_headless_property) + size);
+
+	if (!property) return;
+
+	snprintf(property->name, sizeof(property->name), "%s", name);
+	property->size = size;
+	memcpy(property->value, value, size);
+
+	property->next = twm_get_window_data(window)->properties;
+	twm_get_window_data(window)->properties = property;
+}
+
+bool twm_get_window_property(twm_window window, const char* name, int size, void* value) {
+	_twm_headless_property* property = *_twm_headless_find_property(window, name);
+
+	if (!property) return false;
+
+	memcpy(value, property->value, property->size < size ? property->size : size);
+
+	return true;
+}
 
-		CGEventFlags flags = (CGEventFlags)[event modifierFlags];
-		UInt32 keymodifiers = (flags >> 16) & 0xFF;
+void twm_free_window_property(twm_window window, const char* name) {
+	_twm_headless_property** link = _twm_headless_find_property(window, name);
 
-		UCKeyTranslate(keyboardLayout,
-			[event keyCode], kUCKeyActionDown, keymodifiers,
-			LMGetKbdType(), 0,
-			deadKeyState,
-			unicodeStringLength, &reallength, unicodeString);
-		CFRelease(inputSource);
-	}
+	if (*link) {
+		_twm_headless_property* property = *link;
+		*link = property->next;
 
-	if (reallength > 0) {
-		nsstring = [NSString stringWithCharacters : unicodeString length : reallength];
+		free(property);
 	}
+}
 
-	return nsstring;
+void twm_cursor_position(int* x, int* y) {
+	*x = _twm_data.cursor_x;
+	*y = _twm_data.cursor_y;
 }
 
-ResizeEdge detect_resize_edge(NSPoint mousePos, NSRect frame) {
-	BOOL left = mousePos.x < RESIZE_BORDER;
-	BOOL right = mousePos.x > (frame.size.width - RESIZE_BORDER);
-	BOOL bottom = mousePos.y < RESIZE_BORDER;
-	BOOL top = mousePos.y > (frame.size.height - RESIZE_BORDER);
+void twm_move_cursor(int x, int y) {
+	_twm_data.cursor_x = x;
+	_twm_data.cursor_y = y;
+}
 
-	if (left && bottom)  return ResizeBottomLeft;
-	if (left && top)     return ResizeTopLeft;
-	if (right && bottom) return ResizeBottomRight;
-	if (right && top)    return ResizeTopRight;
-	if (left)   return ResizeLeft;
-	if (right)  return ResizeRight;
-	if (top)    return ResizeTop;
-	if (bottom) return ResizeBottom;
-	return ResizeNone;
+void twm_clip_cursor(twm_window window) {
+	_twm_data.clip = window;
 }
 
-bool is_mouse_in_client_area(NSEvent* event) {
-	NSView* contentView = [event.window contentView];
-	NSPoint localPoint = [contentView convertPoint : [event locationInWindow] fromView : nil];
-	NSRect bounds = [contentView bounds];
-	return NSPointInRect(localPoint, bounds);
+void twm_unclip_cursor() {
+	_twm_data.clip = NULL;
 }
 
-#ifdef TWM_GL
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Wdeprecated-declarations"
+void twm_show_cursor(bool show) {
+	_twm_data.cursor_visible = show;
+}
 
-void twm_gl_set_pixel_attribs(int pixel_attribs[]) {
-	int doubleBufferEnabled = 0;
+bool twm_cursor_is_visible() {
+	return _twm_data.cursor_visible;
+}
 
-	int i = 0;
-	while (pixel_attribs[i] != 0) {
-		switch (pixel_attribs[i]) {
-		case TWM_GL_DOUBLE_BUFFER:
-			pixel_attribs[15] = NSOpenGLPFADoubleBuffer;
-			doubleBufferEnabled = 1;
-			break;
+void twm_rawmouse_master_only(bool enable) {
+	_twm_data.mouse.raw.master_only = enable;
+}
 
-		case TWM_GL_COLOR_BITS:
-			_twm_data.pixel_attribs[4] = pixel_attribs[++i];
-			break;
+// Injected events are for the event loop thread, other threads use twm_post_event
+bool twm_inject_event(const twm_event* evt) {
+	return _twm_push_event(evt);
+}
 
-		case TWM_GL_ALPHA_BITS:
-			_twm_data.pixel_attribs[6] = pixel_attribs[++i];
+// Applies an event to the input and window state the way a real backend does when it translates one
+static inline int _twm_translate_event(twm_event* evt) {
+	_twm_stamp_event(evt, evt->common.server_time);
+
+	switch (evt->type) {
+		case TWM_EVENT_WINDOW_CLOSE: {
+			twm_window_data* data = _twm_headless_find_window(evt->window.window);
+
+			if (data) data->was_closed = true;
 			break;
+		}
 
-		case TWM_GL_DEPTH_BITS:
-			_twm_data.pixel_attribs[8] = pixel_attribs[++i];
+		case TWM_EVENT_WINDOW_SIZE:
+		case TWM_EVENT_WINDOW_MAXIMIZE:
+		case TWM_EVENT_WINDOW_RESTORE: {
+			twm_window_data* data = _twm_headless_find_window(evt->window.window);
+
+			if (!data) break;
+
+			data->was_resized = true;
+			data->width = evt->window.width;
+			data->height = evt->window.height;
 			break;
+		}
 
-		case TWM_GL_STENCIL_BITS:
-			_twm_data.pixel_attribs[10] = pixel_attribs[++i];
+		case TWM_EVENT_WINDOW_MOVE: {
+			twm_window_data* data = _twm_headless_find_window(evt->window.window);
+
+			if (!data) break;
+
+			data->x = evt->window.x;
+			data->y = evt->window.y;
 			break;
+		}
 
-		case TWM_GL_SAMPLE_BUFFERS:
-			_twm_data.pixel_attribs[12] = pixel_attribs[++i];
+		case TWM_EVENT_KEY_DOWN:
+		case TWM_EVENT_KEY_UP: {
+			_twm_apply_input_state(evt);
 			break;
+		}
 
-		case TWM_GL_SAMPLES:
-			_twm_data.pixel_attribs[14] = pixel_attribs[++i];
+		case TWM_EVENT_RAWMOUSE_MOVE: {
+			double dx = evt->rawmouse.fdx, dy = evt->rawmouse.fdy;
+
+			if (dx == 0.0 && dy == 0.0) {
+				dx = evt->rawmouse.dx;
+				dy = evt->rawmouse.dy;
+			}
+
+			return _twm_translate_rawmouse(evt, evt->rawmouse.window, dx, dy);
+		}
+
+		case TWM_EVENT_MOUSE_DOWN:
+		case TWM_EVENT_MOUSE_UP:
+		case TWM_EVENT_MOUSE_MOVE: {
+			if (evt->mouse.fx == 0.0 && evt->mouse.fy == 0.0) {
+				evt->mouse.fx = evt->mouse.x;
+				evt->mouse.fy = evt->mouse.y;
+			}
+
+			_twm_apply_input_state(evt);
+
+			twm_window_data* data = _twm_headless_find_window(evt->mouse.window);
+
+			if (data) {
+				_twm_data.cursor_x = data->x + evt->mouse.x;
+				_twm_data.cursor_y = data->y + evt->mouse.y;
+			}
 			break;
 		}
-		i++;
-	}
 
-	if (!doubleBufferEnabled) {
-		pixel_attribs[15] = 0;
+		default:
+			break;
 	}
+
+	return 1;
 }
 
-twm_gl_context twm_gl_create_context(twm_window window, int* attribs) {
-	@autoreleasepool{
-		NSOpenGLPixelFormatAttribute context_attribs[TWM_GL_PIXEL_ATTRIBS_SIZE];
+static void _twm_platform_wait_event(twm_event* evt) {
+	_twm_platform_wait_event_timeout(evt, -1.0);
+}
 
-		memcpy(context_attribs, _twm_data.pixel_attribs, sizeof(_twm_data.pixel_attribs));
+static int _twm_platform_wait_event_timeout(twm_event* evt, double seconds) {
+	double deadline = twm_time() + seconds;
 
-		int i = 0;
-		while (attribs[i] != 0) {
-			switch (attribs[i]) {
-				case TWM_GL_CONTEXT_MAJOR_VERSION:
-					if (attribs[++i] < 3) {
-						context_attribs[2] = NSOpenGLProfileVersionLegacy;
-					}
-					else if (attribs[++i] < 4) {
-						context_attribs[2] = NSOpenGLProfileVersion3_2Core;
-					}
-					else {
-						context_attribs[2] = NSOpenGLProfileVersion4_1Core;
-					}
-				break;
-			}
-			i++;
+	struct pollfd fds[1 + TWM_MAX_WATCH_FDS];
+
+	for (;;) {
+		if (_twm_platform_peek_event(evt)) return 1;
+
+		int timeout = -1;
+
+		if (seconds >= 0.0) {
+			double remaining = deadline - twm_time();
+
+			if (remaining <= 0.0) return 0;
+
+			timeout = (int)ceil(remaining * 1000.0);
 		}
 
-		NSOpenGLPixelFormat* pf = [[NSOpenGLPixelFormat alloc]initWithAttributes:context_attribs];
-		twm_gl_context glContext = [[NSOpenGLContext alloc]initWithFormat:pf shareContext : nil];
-		[glContext setView : [window contentView] ] ;
-        twm_gl_set_swap_interval(glContext, 0);
+		fds[0].fd = _twm_data.wakeup[0];
+		fds[0].events = POLLIN;
+		fds[0].revents = 0;
 
-		return glContext;
+		for (int i = 0; i < _twm_data.watch.count; i++) {
+			fds[i + 1].fd = _twm_data.watch.fd[i];
+			fds[i + 1].events = POLLIN;
+			fds[i + 1].revents = 0;
+		}
+
+		int ready = poll(fds, 1 + _twm_data.watch.count, timeout);
+
+		if (ready < 0 && errno != EINTR) return 0;
+		if (ready <= 0) continue;
+
+		if (fds[0].revents & POLLIN) {
+			char drain[64];
+			while (read(_twm_data.wakeup[0], drain, sizeof(drain)) > 0);
+		}
+
+		for (int i = 0; i < _twm_data.watch.count; i++) {
+			int index = (_twm_data.watch.next + i) % _twm_data.watch.count;
+
+			if (fds[index + 1].revents & (POLLIN | POLLHUP | POLLERR | POLLNVAL)) {
+				_twm_data.watch.next = index + 1;
+
+				_twm_stamp_event(evt, 0);
+				evt->type = TWM_EVENT_FD_READY;
+				evt->fd.fd = fds[index + 1].fd;
+
+				// Closed without twm_unwatch_fd, poll would report it again on every pass
+				if (fds[index + 1].revents & POLLNVAL) twm_unwatch_fd(evt->fd.fd);
+
+				return 1;
+			}
+		}
 	}
 }
 
-void twm_gl_delete_context(twm_gl_context context) {
-	[context release];
+int twm_connection_fd() {
+	return -1;
 }
 
-void twm_gl_make_current(twm_gl_context context) {
-	if (context != NULL) {
-		[context makeCurrentContext];
-		[context update]; 
+bool twm_watch_fd(int fd) {
+	if (fd < 0 || _twm_data.watch.count == TWM_MAX_WATCH_FDS) return false;
+
+	for (int i = 0; i < _twm_data.watch.count; i++) {
+		if (_twm_data.watch.fd[i] == fd) return true;
 	}
-	else {
-		[NSOpenGLContext clearCurrentContext];
+
+	_twm_data.watch.fd[_twm_data.watch.count++] = fd;
+
+	return true;
+}
+
+void twm_unwatch_fd(int fd) {
+	for (int i = 0; i < _twm_data.watch.count; i++) {
+		if (_twm_data.watch.fd[i] == fd) {
+			_twm_data.watch.fd[i] = _twm_data.watch.fd[--_twm_data.watch.count];
+			_twm_data.watch.next = 0;
+
+			return;
+		}
 	}
 }
 
-void twm_gl_swap_buffers(twm_gl_context context) {
-    [context flushBuffer] ;
+static int _twm_platform_peek_event(twm_event* evt) {
+	while (_twm_pop_event(evt)) {
+		if (_twm_translate_event(evt)) return 1;
+	}
 
-    if (_twm_data.swap_interval > 0) {
-        static double last_time = 0.0f;
-        
-        twm_fps_limit(_twm_data.refresh_rate / _twm_data.swap_interval, last_time);
-        
-        last_time = twm_time();
-    }
+	return _twm_flush_rawmouse(evt);
 }
 
-void twm_gl_set_swap_interval(twm_gl_context context, int interval) {
-    _twm_data.swap_interval = interval;
-    
-    [context setValues:&interval forParameter:NSOpenGLCPSwapInterval];
+bool twm_post_event(const twm_event* evt) {
+	if (!_twm_post_push(evt)) return false;
+
+	#ifdef __linux__
+		unsigned long long one = 1;
+	#else
+		char one = 1;
+	#endif
+
+	ssize_t written = write(_twm_data.wakeup[1], &one, sizeof(one));
+	(void)written;
+
+	return true;
 }
 
-int twm_gl_get_swap_interval(twm_gl_context context) {
-	int current;
-	[context getValues : &current forParameter : NSOpenGLCPSwapInterval] ;
-	return current;
+static int _twm_platform_peek_events(twm_event* events, int max) {
+	int count = 0;
+	while (count < max && _twm_platform_peek_event(&events[count])) count++;
+
+	return count;
 }
 
-#pragma clang diagnostic pop
-#endif
+twm_framebuffer twm_create_framebuffer(twm_window window) {
+	twm_framebuffer framebuffer = (twm_framebuffer)calloc(1, sizeof(_twm_framebuffer));
 
-#ifdef TWM_VULKAN
-#import <QuartzCore/CAMetalLayer.h>
+	if (framebuffer) framebuffer->window = window;
 
-const char** twm_vk_get_instance_extensions(int* extension_count) {
-	static const char* extensions[] = {
-		VK_KHR_SURFACE_EXTENSION_NAME,
-		VK_MVK_MACOS_SURFACE_EXTENSION_NAME
-	};
+	return framebuffer;
+}
 
-	*extension_count = sizeof(extensions) / sizeof(extensions[0]);
+void twm_destroy_framebuffer(twm_framebuffer framebuffer) {
+	if (!framebuffer) return;
 
-	return extensions;
+	free(framebuffer->pixels);
+	free(framebuffer);
 }
 
-VkResult twm_vk_create_surface(twm_window window, VkInstance instance, const
-                                      VkAllocationCallbacks* pAllocator, VkSurfaceKHR* pSurface) {
+unsigned int* twm_framebuffer_pixels(twm_framebuffer framebuffer, int* width, int* height, int* stride) {
+	twm_window_data* data = twm_get_window_data(framebuffer->window);
 
-    [window.contentView setWantsLayer:YES];
+	if (framebuffer->width != data->width || framebuffer->height != data->height) {
+		free(framebuffer->pixels);
 
-    CAMetalLayer* metalLayer = [CAMetalLayer layer];
-    [window.contentView setLayer:metalLayer];
-    
-    VkMacOSSurfaceCreateInfoMVK surface_info = { 0 };
-	surface_info.sType = VK_STRUCTURE_TYPE_MACOS_SURFACE_CREATE_INFO_MVK;
-	surface_info.pNext = NULL;
-	surface_info.flags = 0;
-    surface_info.pView = [window contentView];
+		framebuffer->width = data->width;
+		framebuffer->height = data->height;
+		framebuffer->pixels = (unsigned int*)calloc((size_t)data->width * data->height, sizeof(unsigned int));
+	}
 
-	return vkCreateMacOSSurfaceMVK(instance, &surface_info, pAllocator, pSurface);
+	if (width) *width = framebuffer->width;
+	if (height) *height = framebuffer->height;
+	if (stride) *stride = framebuffer->width;
+
+	return framebuffer->pixels;
 }
+
+void twm_present_framebuffer(twm_framebuffer framebuffer) {
+	(void)framebuffer;
+}
+
+bool twm_window_present_feedback(twm_window window, bool enable) {
+	(void)window;
+	(void)enable;
+
+	return false;
+}
+
 #endif
-#endif
+
+#if !defined(TWM_COCOA) || defined(__OBJC__)
+
+// Replayed events are handed out first once due, live events keep flowing so windows can still be closed
+static int _twm_wait_event_timeout(twm_event* evt, double seconds) {
+	if (!_twm_data.replay.data) return _twm_platform_wait_event_timeout(evt, seconds);
+
+	double deadline = twm_time() + seconds;
+
+	for (;;) {
+		double due, timeout = seconds;
+
+		if (_twm_replay_pop(evt, &due)) return 1;
+
+		if (seconds >= 0.0) {
+			timeout = deadline - twm_time();
+
+			if (timeout < 0.0) timeout = 0.0;
+		}
+
+		if (due >= 0.0 && (timeout < 0.0 || due < timeout)) timeout = due;
+
+		if (_twm_platform_wait_event_timeout(evt, timeout)) return 1;
+
+		if (seconds >= 0.0 && twm_time() >= deadline) return 0;
+	}
+}
+
+void twm_wait_event(twm_event* evt) {
+	long long start = _twm_stats_begin();
+
+	if (_twm_data.replay.data) {
+		_twm_wait_event_timeout(evt, -1.0);
+	}
+	else {
+		_twm_platform_wait_event(evt);
+	}
+
+	_twm_record_events(evt, 1);
+	_twm_stats_end_events(start, 1);
+}
+
+int twm_wait_event_timeout(twm_event* evt, double seconds) {
+	long long start = _twm_stats_begin();
+
+	int result = _twm_wait_event_timeout(evt, seconds);
+
+	_twm_record_events(evt, result);
+	_twm_stats_end_events(start, result);
+
+	return result;
+}
+
+int twm_peek_event(twm_event* evt) {
+	long long start = _twm_stats_begin();
+
+	int result = _twm_replay_pop(evt, NULL) || _twm_platform_peek_event(evt);
+
+	_twm_record_events(evt, result);
+	_twm_stats_end_events(start, result);
+
+	return result;
+}
+
+int twm_peek_events(twm_event* events, int max) {
+	long long start = _twm_stats_begin();
+
+	int count = 0;
+	while (count < max && _twm_replay_pop(&events[count], NULL)) count++;
+
+	if (count < max) count += _twm_platform_peek_events(&events[count], max - count);
+
+	_twm_record_events(events, count);
+	_twm_stats_end_events(start, count);
+
+	return count;
+}
+
 #endif
 #endif
 